@@ -3,6 +3,9 @@
 
 #include "../src/Assembler.h"
 #include "../src/Lexer.h"
+#include "../src/Linker.h"
+#include "../src/ObjectFile.h"
+#include "../src/TokenStream.h"
 #include "../src/Utils.h"
 
 #endif // BLEND_BASM_H
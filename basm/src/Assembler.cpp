@@ -1,5 +1,6 @@
 #include "Assembler.h"
 #include "Lexer.h"
+#include "ObjectFile.h"
 #include "Utils.h"
 
 #ifdef __clang__
@@ -38,13 +39,8 @@ static constexpr inline relang::u8 SizeOfDataType(relang::basm::DataType type)
 }
 
 namespace relang::basm {
-    std::unordered_map<std::string, DataInfo> Assembler::m_SymbolTable;
-    std::unordered_map<std::string, std::pair<usize, std::unordered_map<std::string, usize>>> Assembler::m_LabelAddressMap;
-    std::vector<blend::Instruction> Assembler::m_AssembledCode;
-    std::vector<blend::Instruction> Assembler::m_InstEpilogue;
-    std::vector<u8> Assembler::m_DataSection;
-    usize Assembler::m_BssSize = 0;
-    std::string Assembler::m_CurrentSection = "";
+    // Amount of source read per step when assembling from a stream.
+    static constexpr usize STREAM_CHUNK_SIZE = 1 << 20;
 
     void Assembler::Cleanup()
     {
@@ -55,95 +51,102 @@ namespace relang::basm {
         m_DataSection.clear();
         m_CurrentSection = "";
         m_BssSize = 0;
+        m_IncludeCache.clear();
+        m_Lexer.Clear();
+        m_Fixups.clear();
+        m_Relocations.clear();
+        m_Imports.clear();
+        m_NativeImports.clear();
+        m_NativeIndices.clear();
+        m_HostImports.clear();
+        m_HostIndices.clear();
+        m_CurrentLabel = "";
+        m_InstCount = 0;
     }
 
-    void Assembler::LabelProcessor(TokenList& tokens)
+    void Assembler::ExpandIncludes(const TokenList& tokens, TokenStream& stream, const std::filesystem::path& dir)
     {
-        // Pre proccess the source code.
-        usize inst_count = 0;
-        std::string last_label_definition;
-        bool data_section = false;
-        for (auto i = 0; i < tokens.size(); ++i)
+        // Directives have to be the first thing on their line.
+        const auto is_directive = [&tokens](const usize i, const std::string_view name)
         {
-            if (!data_section)
+            return tokens[i].type == TokenType::Operator && tokens[i].text == "." &&
+                   (i == 0 || tokens[i - 1].line != tokens[i].line) && i + 1 < tokens.size() &&
+                   tokens[i + 1].type == TokenType::Identifier && tokens[i + 1].text == name;
+        };
+
+        usize begin = 0;
+        for (usize i = 0; i < tokens.size(); ++i)
+        {
+            // Include guard, the file has already been marked when it was loaded so just drop it.
+            if (is_directive(i, "once"))
             {
-                if (tokens[i].type == TokenType::Operator &&
-                    tokens[i].text == "." &&
-                    tokens[i + 1].type == TokenType::Identifier &&
-                    tokens[i + 1].text == "section" &&
-                    tokens[i + 2].type == TokenType::Identifier &&
-                    tokens[i + 2].text == "code" &&
-                    tokens[i + 3].type == TokenType::Operator &&
-                    tokens[i + 3].text == ":")
-                {
-                    data_section = true;
-                    i += 4;
-                }
-                // Include directive.
-                else if (tokens[i].type == TokenType::Operator &&
-                         tokens[i].text == "." &&
-                         tokens[i + 1].type == TokenType::Identifier &&
-                         tokens[i + 1].text == "include" &&
-                         tokens[i + 2].type == TokenType::StringLiteral)
+                stream.Append(std::span(tokens.data() + begin, i - begin));
+                begin = i + 2;
+                i++;
+            }
+            // Include directive.
+            else if (is_directive(i, "include") && i + 2 < tokens.size() && tokens[i + 2].type == TokenType::StringLiteral)
+            {
+                stream.Append(std::span(tokens.data() + begin, i - begin));
+                begin = i + 3;
+
+                const auto path = (dir / tokens[i + 2].text).lexically_normal();
+                auto [it, inserted] = m_IncludeCache.try_emplace(path.string());
+                auto& file = it->second;
+                if (inserted)
                 {
-                    std::ifstream fs(tokens[i + 2].text);
-                    if (fs.is_open())
-                    {
-                        std::string src_code = std::string(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
-                        auto tk_list = relang::basm::Lexer::Start(src_code);
-                        tokens.insert(tokens.begin() + i + 2, tk_list.begin(), tk_list.end());
-                        tokens.erase(tokens.begin() + i, tokens.begin() + 2);
-                    }
-                    else
+                    std::ifstream fs(path);
+                    if (!fs.is_open())
                     {
                         std::cerr << "Preproccess Error @ line (" << tokens[i].line << ", " << tokens[i].cur << "): "
-                                  << "File not found."
+                                  << "File " << path << " not found."
                                   << std::endl;
                         std::exit(-2);
                     }
-                }
-                continue;
-            }
 
-            if (tokens[i].type == TokenType::Instruction)
-                inst_count++;
-
-            switch (tokens[i].type)
-            {
-                case TokenType::Operator:
-                    if (tokens[i].text == "@" && tokens[i + 1].type == TokenType::Identifier)
+                    // Lex each file only once no matter how many times it's included.
+                    file.source.assign(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
+                    file.tokens = m_Lexer.Start(file.source);
+                    for (usize x = 0; x < file.tokens.size() && !file.once; ++x)
                     {
-                        // Label definition.
-                        if (tokens[i + 2].type == TokenType::Operator && tokens[i + 2].text == ":")
-                        {
-                            m_LabelAddressMap[tokens[i + 1].text] = {inst_count + 1, {}};
-                            last_label_definition = tokens[i + 1].text;
-                            i += 2;
-                        }
-                    }
-                    else if (tokens[i].text == "." && tokens[i + 1].type == TokenType::Identifier)
-                    {
-                        // Local label definition.
-                        if (tokens[i + 2].type == TokenType::Operator && tokens[i + 2].text == ":")
-                        {
-                            if (auto it = m_LabelAddressMap[last_label_definition].second.find(tokens[i + 1].text);
-                                it != m_LabelAddressMap[last_label_definition].second.end())
-                            {
-                                std::cerr << "Preproccess Error @ line (" << tokens[i].line << ", " << tokens[i].cur << "): "
-                                          << "Unconsistent local label redefinition of '" << tokens[i + 1].text << "'."
-                                          << std::endl;
-                                std::exit(-2);
-                            }
-                            m_LabelAddressMap[last_label_definition].second[tokens[i + 1].text] = inst_count + 1;
-                            i += 2;
-                        }
+                        file.once = file.tokens[x].type == TokenType::Operator && file.tokens[x].text == "." &&
+                                    (x == 0 || file.tokens[x - 1].line != file.tokens[x].line) && x + 1 < file.tokens.size() &&
+                                    file.tokens[x + 1].type == TokenType::Identifier && file.tokens[x + 1].text == "once";
                     }
-                    break;
+                }
+
+                if (file.active)
+                {
+                    std::cerr << "Preproccess Error @ line (" << tokens[i].line << ", " << tokens[i].cur << "): "
+                              << "Recursive inclusion of '" << tokens[i + 2].text << "'."
+                              << std::endl;
+                    std::exit(-2);
+                }
+
+                if (!file.once || !file.expanded)
+                {
+                    file.active = true;
+                    file.expanded = true;
+                    ExpandIncludes(file.tokens, stream, path.parent_path());
+                    file.active = false;
+                }
+                i += 2;
             }
         }
+        stream.Append(std::span(tokens.data() + begin, tokens.size() - begin));
+    }
+
+    void Assembler::AddRelocation(const DataInfo& inf, const RelocationField field)
+    {
+        m_Relocations.push_back(
+            {
+                .index = m_AssembledCode.size(),
+                .type = (inf.initialized) ? RelocationType::Data : RelocationType::Bss,
+                .field = field,
+            });
     }
 
-    AssemblerStatus Assembler::WriteToBinary(const std::string& path)
+    AssemblerStatus Assembler::WriteToBinary(const std::string& path, const AssemblerResult& res)
     {
         std::ofstream fs(path);
         if (fs.is_open())
@@ -151,23 +154,56 @@ namespace relang::basm {
             fs.seekp(0, fs.beg);
 
             u8 indic = blend::DATA_SECTION_INDIC;
-            usize data_section_size = m_DataSection.size() * sizeof(u8);
-            usize code_section_size = m_AssembledCode.size() * sizeof(blend::Instruction);
+            usize data_section_size = res.dataSection.size() * sizeof(u8);
+            usize code_section_size = res.assembledCode.size() * sizeof(blend::Instruction);
 
             fs.write((const char*)&indic, sizeof(u8));
             fs.write((const char*)&data_section_size, sizeof(usize));
-            fs.write((const char*)m_DataSection.data(), data_section_size);
+            fs.write((const char*)res.dataSection.data(), data_section_size);
 
             indic = blend::BSS_SECTION_INDIC;
 
             fs.write((const char*)&indic, sizeof(u8));
-            fs.write((const char*)&m_BssSize, sizeof(usize));
+            fs.write((const char*)&res.bssSize, sizeof(usize));
 
             indic = blend::CODE_SECTION_INDIC;
 
             fs.write((const char*)&indic, sizeof(u8));
             fs.write((const char*)&code_section_size, sizeof(usize));
-            fs.write((const char*)m_AssembledCode.data(), code_section_size);
+            fs.write((const char*)res.assembledCode.data(), code_section_size);
+
+            const auto write_string = [&fs](const std::string& str)
+            {
+                u32 length = (u32)str.size();
+                fs.write((const char*)&length, sizeof(u32));
+                fs.write(str.data(), length);
+            };
+
+            if (!res.nativeImports.empty())
+            {
+                indic = blend::NATIVE_IMPORT_SECTION_INDIC;
+                usize native_import_count = res.nativeImports.size();
+
+                fs.write((const char*)&indic, sizeof(u8));
+                fs.write((const char*)&native_import_count, sizeof(usize));
+                for (const auto& import : res.nativeImports)
+                {
+                    write_string(import.library);
+                    write_string(import.symbol);
+                    write_string(import.signature);
+                }
+            }
+
+            if (!res.hostImports.empty())
+            {
+                indic = blend::HOST_IMPORT_SECTION_INDIC;
+                usize host_import_count = res.hostImports.size();
+
+                fs.write((const char*)&indic, sizeof(u8));
+                fs.write((const char*)&host_import_count, sizeof(usize));
+                for (const auto& name : res.hostImports)
+                    write_string(name);
+            }
 
             fs.close();
         }
@@ -181,36 +217,158 @@ namespace relang::basm {
     AssemblerResult Assembler::Assemble(AssemblerOptions& opt)
     {
         AssemblerResult res;
-        res.status = CodeGen(const_cast<std::vector<Token>&>(opt.tokens));
+        Cleanup();
+
+        if (opt.source)
+        {
+            res.status = StreamCodeGen(*opt.source, opt.dir);
+        }
+        else
+        {
+            TokenStream tokens;
+            ExpandIncludes(*opt.tokens, tokens, opt.dir);
+            res.status = CodeGen(tokens);
+        }
+
+        // Relocatable output keeps references to labels of other units around for the linker.
+        const bool relocatable = opt.type != OutputType::XBin;
+        if (res.status == AssemblerStatus::Ok)
+            res.status = ResolveFixups(relocatable);
+
         if (res.status == AssemblerStatus::Ok)
         {
-            res.assembledCode = m_AssembledCode;
-            res.dataSection = m_DataSection;
+            if (!relocatable)
+                m_AssembledCode.push_back(blend::Instruction{.opcode = blend::OpCode::End});
+
+            res.assembledCode = std::move(m_AssembledCode);
+            res.dataSection = std::move(m_DataSection);
+            res.bssSize = m_BssSize;
+            res.nativeImports = std::move(m_NativeImports);
+            res.hostImports = std::move(m_HostImports);
             switch (opt.type)
             {
                 case OutputType::Lib:
-                    break;
                 case OutputType::DLib:
+                    for (const auto& [label, address] : m_LabelAddressMap)
+                    {
+                        if (!label.empty())
+                            res.labels[label] = address.first;
+                    }
+                    res.relocations = std::move(m_Relocations);
+                    res.imports = std::move(m_Imports);
+                    // No path means the caller links the result in memory.
+                    if (!opt.path.empty())
+                        res.status = ObjectFile::Write(opt.path, res);
                     break;
                 case OutputType::XBin:
-                    res.status = WriteToBinary(opt.path);
+                    res.status = WriteToBinary(opt.path, res);
                     break;
             }
         }
         return res;
     }
 
-    AssemblerStatus Assembler::CodeGen(TokenList& tokens)
+    AssemblerStatus Assembler::StreamCodeGen(std::istream& source, const std::filesystem::path& dir)
     {
-        Cleanup();
-        LabelProcessor(tokens);
+        std::vector<char> buffer(STREAM_CHUNK_SIZE);
+        std::string chunk;
+        std::string carry;
+        u32 line = 1;
+        while (source)
+        {
+            source.read(buffer.data(), (std::streamsize)buffer.size());
+            chunk = std::move(carry);
+            chunk.append(buffer.data(), (usize)source.gcount());
+
+            // Statements never span lines, so cut the chunk after its last line break and
+            // carry the partial line over to the next one.
+            carry.clear();
+            if (source)
+            {
+                const usize cut = chunk.find_last_of("\r\n");
+                if (cut == std::string::npos)
+                {
+                    carry = std::move(chunk);
+                    continue;
+                }
+                carry.assign(chunk, cut + 1);
+                chunk.resize(cut + 1);
+            }
+
+            const auto tokens = m_Lexer.Start(chunk, line);
+            line += (u32)std::count_if(chunk.begin(), chunk.end(), [](const char c) { return c == '\n' || c == '\r'; });
+
+            TokenStream stream;
+            ExpandIncludes(tokens, stream, dir);
+            if (const auto status = CodeGen(stream); status != AssemblerStatus::Ok)
+                return status;
+        }
+        return AssemblerStatus::Ok;
+    }
+
+    AssemblerStatus Assembler::ResolveFixups(const bool allow_imports)
+    {
+        const auto resolve = [this](const LabelFixup& fixup, const usize address)
+        {
+            if (fixup.data)
+            {
+                *(u64*)(m_DataSection.data() + fixup.index) = (u64)address;
+                m_Relocations.push_back({.index = fixup.index, .field = RelocationField::Data});
+            }
+            else
+            {
+                m_AssembledCode[fixup.index].imm64 = (u64)address;
+                m_Relocations.push_back({.index = fixup.index});
+            }
+        };
+
+        for (const auto& fixup : m_Fixups)
+        {
+            if (auto it = m_LabelAddressMap.find(fixup.label); it != m_LabelAddressMap.end())
+            {
+                if (fixup.local.empty())
+                {
+                    resolve(fixup, it->second.first);
+                    continue;
+                }
+                else if (auto local = it->second.second.find(fixup.local); local != it->second.second.end())
+                {
+                    resolve(fixup, local->second);
+                    continue;
+                }
+            }
 
-        std::string current_label;
+            // Jump tables only hold labels of their own unit, the linker patches instructions alone.
+            if (fixup.local.empty() && allow_imports && !fixup.data)
+            {
+                // Might be defined by another unit, leave it to the linker.
+                m_Imports.push_back(fixup);
+            }
+            else if (fixup.local.empty())
+            {
+                std::cout << "Compiler Error @ line (" << fixup.line << ", " << fixup.cur << "): "
+                          << "Attempted to reference an undefined label '" << fixup.label << "'.\n";
+                return AssemblerStatus::AssembleError;
+            }
+            else if (!fixup.label.empty())
+            {
+                ASSEMBLE_ERROR(fixup, "Local label " << fixup.local << " in parent label " << fixup.label << " is undefined.");
+            }
+            else
+            {
+                ASSEMBLE_ERROR(fixup, "Attempted to reference a local label in an unexistent parent label.");
+            }
+        }
+        return AssemblerStatus::Ok;
+    }
+
+    AssemblerStatus Assembler::CodeGen(const TokenStream& tokens)
+    {
         int operand_count = -1;
         blend::RegType ptr = blend::RegType::NUL;
         usize inst_token_id = 0;
         blend::Instruction current_instruction;
-        for (auto i = 0; i < tokens.size(); ++i)
+        for (auto i = 0; i < tokens.GetSize(); ++i)
         {
             switch (tokens[i].type)
             {
@@ -256,7 +414,7 @@ namespace relang::basm {
                                                 case TokenType::Immediate:
                                                 case TokenType::Displacement:
                                                     m_DataSection.resize(m_DataSection.size() + 1);
-                                                    *(u8*)(m_DataSection.data() + inf.addr + inf.size) = (u8)std::stoull(tokens[i].text);
+                                                    *(u8*)(m_DataSection.data() + inf.addr + inf.size) = (u8)tokens[i].data;
                                                     inf.size++;
                                                     break;
                                                 case TokenType::Operator:
@@ -303,8 +461,8 @@ namespace relang::basm {
                                                                 ASSEMBLE_ERROR(tokens[i], "Expected a ')'.");
                                                             }
 
-                                                            u8 value = (u8)std::stoull(tokens[i].text);
-                                                            usize size = std::stoull(tokens[i + 2].text);
+                                                            u8 value = (u8)tokens[i].data;
+                                                            usize size = tokens[i + 2].data;
                                                             m_DataSection.resize(inf.addr + size);
                                                             for (auto x = 0; x < size; ++x)
                                                                 *((u8*)m_DataSection.data() + inf.addr + x) = value;
@@ -319,7 +477,7 @@ namespace relang::basm {
                                                     else
                                                     {
                                                         run = false;
-                                                        m_SymbolTable[tokens[inst_token_id + 1].text] = inf;
+                                                        m_SymbolTable[std::string(tokens[inst_token_id + 1].text)] = inf;
                                                     }
                                                     break;
                                             }
@@ -342,7 +500,7 @@ namespace relang::basm {
                                                 case TokenType::Immediate:
                                                 case TokenType::Displacement:
                                                     m_DataSection.resize(m_DataSection.size() + 2);
-                                                    *(u16*)(m_DataSection.data() + inf.addr + inf.size) = (u16)std::stoull(tokens[i].text);
+                                                    *(u16*)(m_DataSection.data() + inf.addr + inf.size) = (u16)tokens[i].data;
                                                     inf.size += 2;
                                                     break;
                                                 case TokenType::Operator:
@@ -389,8 +547,8 @@ namespace relang::basm {
                                                                 ASSEMBLE_ERROR(tokens[i], "Expected a ')'.");
                                                             }
 
-                                                            u16 value = (u16)std::stoull(tokens[i].text);
-                                                            usize size = std::stoull(tokens[i + 1].text);
+                                                            u16 value = (u16)tokens[i].data;
+                                                            usize size = tokens[i + 2].data;
                                                             m_DataSection.resize(inf.addr + size * 2);
                                                             for (auto x = 0; x < size; ++x)
                                                             {
@@ -407,7 +565,7 @@ namespace relang::basm {
                                                     else
                                                     {
                                                         run = false;
-                                                        m_SymbolTable[tokens[inst_token_id + 1].text] = inf;
+                                                        m_SymbolTable[std::string(tokens[inst_token_id + 1].text)] = inf;
                                                     }
                                                     break;
                                             }
@@ -430,7 +588,7 @@ namespace relang::basm {
                                                 case TokenType::Immediate:
                                                 case TokenType::Displacement:
                                                     m_DataSection.resize(m_DataSection.size() + 4);
-                                                    *(u32*)(m_DataSection.data() + inf.addr + inf.size) = (u32)std::stoull(tokens[i].text);
+                                                    *(u32*)(m_DataSection.data() + inf.addr + inf.size) = (u32)tokens[i].data;
                                                     inf.size += 4;
                                                     break;
                                                 case TokenType::Operator:
@@ -477,8 +635,8 @@ namespace relang::basm {
                                                                 ASSEMBLE_ERROR(tokens[i], "Expected a ')'.");
                                                             }
 
-                                                            u32 value = (u32)std::stoull(tokens[i].text);
-                                                            usize size = std::stoull(tokens[i + 1].text);
+                                                            u32 value = (u32)tokens[i].data;
+                                                            usize size = tokens[i + 2].data;
                                                             m_DataSection.resize(inf.addr + size * 4);
                                                             for (auto x = 0; x < size; ++x)
                                                             {
@@ -495,7 +653,7 @@ namespace relang::basm {
                                                     else
                                                     {
                                                         run = false;
-                                                        m_SymbolTable[tokens[inst_token_id + 1].text] = inf;
+                                                        m_SymbolTable[std::string(tokens[inst_token_id + 1].text)] = inf;
                                                     }
                                                     break;
                                             }
@@ -519,7 +677,7 @@ namespace relang::basm {
                                                 case TokenType::Immediate:
                                                 case TokenType::Displacement:
                                                     m_DataSection.resize(m_DataSection.size() + 8);
-                                                    *(u64*)(m_DataSection.data() + inf.addr + inf.size) = std::stoull(tokens[i].text);
+                                                    *(u64*)(m_DataSection.data() + inf.addr + inf.size) = tokens[i].data;
                                                     inf.size += 8;
                                                     break;
                                                 case TokenType::Operator:
@@ -566,8 +724,8 @@ namespace relang::basm {
                                                                 ASSEMBLE_ERROR(tokens[i], "Expected a ')'.");
                                                             }
 
-                                                            u64 value = std::stoull(tokens[i].text);
-                                                            usize size = std::stoull(tokens[i + 1].text);
+                                                            u64 value = tokens[i].data;
+                                                            usize size = tokens[i + 2].data;
                                                             m_DataSection.resize(inf.addr + size * 8);
                                                             for (auto x = 0; x < size; ++x)
                                                             {
@@ -584,7 +742,7 @@ namespace relang::basm {
                                                     else
                                                     {
                                                         run = false;
-                                                        m_SymbolTable[tokens[inst_token_id + 1].text] = inf;
+                                                        m_SymbolTable[std::string(tokens[inst_token_id + 1].text)] = inf;
                                                     }
                                                     break;
                                             }
@@ -605,13 +763,73 @@ namespace relang::basm {
                                 if (tokens[i + 1].type == TokenType::Immediate ||
                                     tokens[i + 1].type == TokenType::Displacement)
                                 {
-                                    m_DataSection.resize(m_DataSection.size() + std::stoull(tokens[i + 1].text));
+                                    m_DataSection.resize(m_DataSection.size() + tokens[i + 1].data);
                                 }
                                 else
                                 {
                                     ASSEMBLE_ERROR(tokens[i + 2], "Expected a number literal after '" << tokens[i + 1].text << "'.");
                                 }
                             }
+                            else if (inst == "jtab")
+                            {
+                                // jtab name @label, @parent.local, ...
+                                if (tokens[i + 1].type != TokenType::Identifier)
+                                {
+                                    ASSEMBLE_ERROR(tokens[i], "Expected an Identifier after jtab.");
+                                }
+                                if (m_SymbolTable.find(tokens[i + 1].text) != m_SymbolTable.end())
+                                {
+                                    ASSEMBLE_ERROR(tokens[i + 1], "Attempted to redefine '" << tokens[i + 1].text << "'.");
+                                }
+
+                                DataInfo inf =
+                                    {
+                                        .addr = m_DataSection.size(),
+                                        .value = (u64)m_DataSection.size(),
+                                        .initialized = true,
+                                        .type = DataType::JumpTable,
+                                    };
+                                m_DataSection.resize(m_DataSection.size() + sizeof(u64));
+
+                                // Code labels come after the data section, so every entry is filled in by ResolveFixups().
+                                u64 count = 0;
+                                i += 2;
+                                while (tokens[i].type == TokenType::Operator && tokens[i].text == "@" && tokens[i + 1].type == TokenType::Identifier)
+                                {
+                                    LabelFixup fixup =
+                                        {
+                                            .index = m_DataSection.size(),
+                                            .label = std::string(tokens[i + 1].text),
+                                            .local = {},
+                                            .line = tokens[i + 1].line,
+                                            .cur = tokens[i + 1].cur,
+                                            .data = true,
+                                        };
+                                    i += 2;
+                                    if (tokens[i].type == TokenType::Operator && tokens[i].text == "." &&
+                                        tokens[i + 1].type == TokenType::Identifier && tokens[i + 1].line == fixup.line)
+                                    {
+                                        fixup.local = std::string(tokens[i + 1].text);
+                                        i += 2;
+                                    }
+                                    m_Fixups.push_back(std::move(fixup));
+                                    m_DataSection.resize(m_DataSection.size() + sizeof(u64));
+                                    count++;
+
+                                    if (tokens[i].type != TokenType::Operator || tokens[i].text != ",")
+                                        break;
+                                    i++;
+                                }
+
+                                if (count == 0)
+                                {
+                                    ASSEMBLE_ERROR(tokens[inst_token_id + 1], "Expected the labels of the jump table, e.g. jtab _CASES @zero, @one.");
+                                }
+                                *(u64*)(m_DataSection.data() + inf.addr) = count;
+                                inf.size = (count + 1) * sizeof(u64);
+                                m_SymbolTable[std::string(tokens[inst_token_id + 1].text)] = inf;
+                                i--;
+                            }
                             else if (inst == "const")
                             {
                                 if (tokens[i + 1].type == TokenType::Identifier)
@@ -619,10 +837,10 @@ namespace relang::basm {
                                     if (tokens[i + 2].type == TokenType::Immediate ||
                                         tokens[i + 2].type == TokenType::Displacement)
                                     {
-                                        m_SymbolTable[tokens[i + 1].text] =
+                                        m_SymbolTable[std::string(tokens[i + 1].text)] =
                                             {
                                                 .size = 4,
-                                                .value = std::stoull(tokens[i + 2].text),
+                                                .value = tokens[i + 2].data,
                                                 .constant = true,
                                                 .type = DataType::QWord};
                                     }
@@ -684,9 +902,9 @@ namespace relang::basm {
                                     {
                                         inf.type = DataType::QWord;
                                     }
-                                    inf.size = (SizeOfDataType(inf.type) / 8) * std::stoull(tokens[i].text);
+                                    inf.size = (SizeOfDataType(inf.type) / 8) * tokens[i].data;
                                     m_BssSize += inf.size;
-                                    m_SymbolTable[tokens[inst_token_id + 1].text] = inf;
+                                    m_SymbolTable[std::string(tokens[inst_token_id + 1].text)] = inf;
                                     break;
                                 }
                                 else
@@ -697,103 +915,12 @@ namespace relang::basm {
                         }
                     }
 
+                    m_InstCount++;
                     if (i > 0)
                     {
-                        if (current_instruction.opcode != blend::OpCode::Nop)
-                        {
-                            switch (current_instruction.opcode)
-                            {
-                                // Instructions that accept no operands.
-                                case blend::OpCode::Leave:
-                                case blend::OpCode::Return:
-                                case blend::OpCode::End:
-                                case blend::OpCode::Lrzf:
-                                case blend::OpCode::Srzf:
-                                case blend::OpCode::Nop:
-                                case blend::OpCode::Pushar:
-                                case blend::OpCode::Popar:
-                                case blend::OpCode::DumpFlags:
-                                    if (operand_count > -1)
-                                    {
-                                        ASSEMBLE_ERROR(tokens[inst_token_id], "Instruction doesn't accept any operands.");
-                                    }
-                                    break;
-                                // Instructions that accept a single operand.
-                                case blend::OpCode::Call:
-                                case blend::OpCode::Jump:
-                                case blend::OpCode::Jc:
-                                case blend::OpCode::Jcn:
-                                case blend::OpCode::Jue:
-                                case blend::OpCode::Jl:
-                                case blend::OpCode::Jno:
-                                case blend::OpCode::Jns:
-                                case blend::OpCode::Jnz:
-                                case blend::OpCode::Jo:
-                                case blend::OpCode::Js:
-                                case blend::OpCode::Jug:
-                                case blend::OpCode::Juge:
-                                case blend::OpCode::Jul:
-                                case blend::OpCode::Jule:
-                                case blend::OpCode::June:
-                                case blend::OpCode::Enter:
-                                case blend::OpCode::PInt:
-                                case blend::OpCode::PStr:
-                                case blend::OpCode::PChr:
-                                case blend::OpCode::Push:
-                                case blend::OpCode::Pop:
-                                case blend::OpCode::Mul:
-                                case blend::OpCode::Div:
-                                case blend::OpCode::Neg:
-                                case blend::OpCode::System:
-                                case blend::OpCode::GetChar:
-                                case blend::OpCode::Inc:
-                                case blend::OpCode::Dec:
-                                case blend::OpCode::Malloc:
-                                case blend::OpCode::Free:
-                                case blend::OpCode::SConio:
-                                    // Instructions that accept both no operands or a single operand.
-                                    switch (current_instruction.opcode)
-                                    {
-                                        case blend::OpCode::Pop:
-                                            goto ok_instruction_case;
-                                            break;
-                                    }
-
-                                    if (operand_count > 0)
-                                    {
-                                        ASSEMBLE_ERROR(tokens[inst_token_id], "Instruction is unary.");
-                                    }
-                                    else if (operand_count == -1)
-                                    {
-                                        ASSEMBLE_ERROR(tokens[inst_token_id], "Instruction accepts a single operand but no operands were passed. Refer to its encoding for correct usage.");
-                                    }
-                                    break;
-                                // Instructions that acceot three operands.
-                                // None...
-                                // Instructions that accept two operands.
-                                default:
-                                    // Instructions that accept both two operands or a single operand.
-                                    switch (current_instruction.opcode)
-                                    {
-                                        case blend::OpCode::Printf:
-                                            goto ok_instruction_case;
-                                            break;
-                                    }
-
-                                    if (operand_count <= 0 || operand_count > 1)
-                                    {
-                                        ASSEMBLE_ERROR(tokens[inst_token_id], "Invalid number of operands passed to Instruction.\nRefer to its encoding for correct usage.");
-                                    }
-                                    break;
-                            }
-                        ok_instruction_case:
-                            m_AssembledCode.push_back(current_instruction);
-                        }
-                        if (!m_InstEpilogue.empty())
-                        {
-                            m_AssembledCode.insert(m_AssembledCode.end(), m_InstEpilogue.begin(), m_InstEpilogue.end());
-                            m_InstEpilogue.clear();
-                        }
+                        if (const auto status = EmitInstruction(tokens[inst_token_id], current_instruction, operand_count);
+                            status != AssemblerStatus::Ok)
+                            return status;
                     }
                     inst_token_id = i;
                     current_instruction = blend::Instruction{};
@@ -846,7 +973,7 @@ namespace relang::basm {
                     {
                         // Displacer...
                         ptr = blend::RegType::PTR;
-                        current_instruction.disp = (i32)std::stoull(tokens[i].text);
+                        current_instruction.disp = (i32)tokens[i].data;
                     }
                     break;
                 }
@@ -857,7 +984,28 @@ namespace relang::basm {
                         blend::RegType reg = GetReg(tokens[i + 1].text);
                         if (reg != blend::RegType::NUL)
                         {
-                            if (operand_count <= 0)
+                            // pushm and popm take a list of registers which ends up as a mask.
+                            if (current_instruction.opcode == blend::OpCode::Pushm || current_instruction.opcode == blend::OpCode::Popm)
+                            {
+                                if (reg > blend::RegType::R31 || ptr != blend::RegType::NUL)
+                                {
+                                    ASSEMBLE_ERROR(tokens[i + 1], "Only %r0-%r31 can be saved by pushm and popm.");
+                                }
+                                current_instruction.imm64 |= u64{1} << reg;
+                            }
+                            // So do the frame instructions, the mask goes in disp as enter keeps the frame size in imm64. tcall
+                            // takes its target first.
+                            else if (current_instruction.opcode == blend::OpCode::Enter || current_instruction.opcode == blend::OpCode::Leave ||
+                                     current_instruction.opcode == blend::OpCode::LeaveRet ||
+                                     (current_instruction.opcode == blend::OpCode::TailCall && operand_count > 0))
+                            {
+                                if (reg > blend::RegType::R31 || ptr != blend::RegType::NUL)
+                                {
+                                    ASSEMBLE_ERROR(tokens[i + 1], "Only %r0-%r31 can be saved by a stack frame.");
+                                }
+                                current_instruction.disp |= (i32)(u32{1} << reg);
+                            }
+                            else if (operand_count <= 0)
                             {
                                 current_instruction.sreg = reg;
                                 if (ptr != blend::RegType::NUL)
@@ -888,7 +1036,7 @@ namespace relang::basm {
                                 auto it = m_SymbolTable.find(tokens[i - 1].text);
                                 if (it != m_SymbolTable.end())
                                 {
-                                    current_instruction.disp += (i32)std::stoull(tokens[i + 1].text);
+                                    current_instruction.disp += (i32)tokens[i + 1].data;
                                 }
                                 else
                                 {
@@ -915,7 +1063,7 @@ namespace relang::basm {
                                 auto it = m_SymbolTable.find(tokens[i - 1].text);
                                 if (it != m_SymbolTable.end())
                                 {
-                                    current_instruction.disp -= (i32)std::stoull(tokens[i + 1].text);
+                                    current_instruction.disp -= (i32)tokens[i + 1].data;
                                 }
                                 else
                                 {
@@ -1008,11 +1156,10 @@ namespace relang::basm {
                             if (operand_count <= -1)
                                 operand_count++;
 
-                            if (m_LabelAddressMap.find(tokens[i + 1].text) != m_LabelAddressMap.end())
+                            switch (current_instruction.opcode)
                             {
-                                switch (current_instruction.opcode)
-                                {
                                     case blend::OpCode::Call:
+                                    case blend::OpCode::TailCall:
                                     case blend::OpCode::Jump:
                                     case blend::OpCode::Jc:
                                     case blend::OpCode::Jcn:
@@ -1028,25 +1175,72 @@ namespace relang::basm {
                                     case blend::OpCode::Jul:
                                     case blend::OpCode::Jule:
                                     case blend::OpCode::June:
+                                    case blend::OpCode::InvokeC:
+                                    case blend::OpCode::HostCall:
                                         break;
-                                    default:
-                                        ASSEMBLE_ERROR(tokens[i], "Instruction doesn't accept a label as an operand.");
+                                    case blend::OpCode::Mov:
+                                        // Loads the label's address for a later jmp or call through the register.
+                                        if (operand_count > 0)
+                                        {
+                                            ASSEMBLE_ERROR(tokens[i], "Instruction doesn't accept a label as its destination operand.");
+                                        }
                                         break;
+                                default:
+                                    ASSEMBLE_ERROR(tokens[i], "Instruction doesn't accept a label as an operand.");
+                                    break;
+                            }
+
+                            if (current_instruction.opcode == blend::OpCode::HostCall)
+                            {
+                                // Host functions get the same treatment, they are bound by name when the program runs.
+                                auto it = m_HostIndices.find(tokens[i + 1].text);
+                                if (it == m_HostIndices.end())
+                                {
+                                    ASSEMBLE_ERROR(tokens[i + 1], "Undeclared host function '" << tokens[i + 1].text << "'.");
                                 }
-                                current_instruction.imm64 = (u64)m_LabelAddressMap[tokens[i + 1].text].first;
+                                current_instruction.imm64 = (u64)it->second;
+                                m_Relocations.push_back({.index = m_AssembledCode.size(), .type = RelocationType::Host});
+                                i++;
+                                break;
+                            }
+                            else if (current_instruction.opcode == blend::OpCode::InvokeC)
+                            {
+                                // Native functions are declared up front, there's nothing to patch later.
+                                auto it = m_NativeIndices.find(tokens[i + 1].text);
+                                if (it == m_NativeIndices.end())
+                                {
+                                    ASSEMBLE_ERROR(tokens[i + 1], "Undeclared native function '" << tokens[i + 1].text << "'.");
+                                }
+                                current_instruction.imm64 = (u64)it->second;
+                                m_Relocations.push_back({.index = m_AssembledCode.size(), .type = RelocationType::Native});
+                                i++;
+                                break;
+                            }
+
+                            // Forward references get patched once every label has been seen.
+                            if (auto it = m_LabelAddressMap.find(tokens[i + 1].text); it != m_LabelAddressMap.end())
+                            {
+                                current_instruction.imm64 = (u64)it->second.first;
+                                m_Relocations.push_back({.index = m_AssembledCode.size()});
                             }
                             else
                             {
-                                std::cout << "Compiler Error @ line (" << tokens[i + 1].line << ", " << tokens[i + 1].cur << "): "
-                                          << "Attempted to reference an undefined label '" << tokens[i + 1].text << "'.\n";
-                                return AssemblerStatus::AssembleError;
+                                m_Fixups.push_back(
+                                    {
+                                        .index = m_AssembledCode.size(),
+                                        .label = std::string(tokens[i + 1].text),
+                                        .local = {},
+                                        .line = tokens[i + 1].line,
+                                        .cur = tokens[i + 1].cur,
+                                    });
                             }
                             i++;
                         }
                         else if (tokens[i + 2].type == TokenType::Operator && tokens[i + 2].text == ":")
                         {
-                            // It's a label definition, ignore it.
-                            current_label = tokens[i + 1].text;
+                            // Label definition.
+                            m_CurrentLabel = tokens[i + 1].text;
+                            m_LabelAddressMap[m_CurrentLabel] = {m_InstCount, {}};
                             i += 2;
                         }
                     }
@@ -1080,35 +1274,81 @@ namespace relang::basm {
                             m_CurrentSection = tokens[i + 2].text;
                             i += 3;
                         }
+                        else if (tokens[i + 1].type == TokenType::Identifier && tokens[i + 1].text == "native")
+                        {
+                            // .native name "library" "signature"
+                            if (tokens[i + 2].type != TokenType::Identifier ||
+                                tokens[i + 3].type != TokenType::StringLiteral ||
+                                tokens[i + 4].type != TokenType::StringLiteral)
+                            {
+                                ASSEMBLE_ERROR(tokens[i + 1], "Expected a name, a library and a signature.");
+                            }
+
+                            auto [it, inserted] = m_NativeIndices.try_emplace(std::string(tokens[i + 2].text), m_NativeImports.size());
+                            if (!inserted)
+                            {
+                                ASSEMBLE_ERROR(tokens[i + 2], "Redeclaration of native function '" << tokens[i + 2].text << "'.");
+                            }
+                            m_NativeImports.push_back(
+                                {
+                                    .library = std::string(tokens[i + 3].text),
+                                    .symbol = std::string(tokens[i + 2].text),
+                                    .signature = std::string(tokens[i + 4].text),
+                                });
+                            i += 4;
+                        }
+                        else if (tokens[i + 1].type == TokenType::Identifier && tokens[i + 1].text == "host")
+                        {
+                            // .host name
+                            if (tokens[i + 2].type != TokenType::Identifier)
+                            {
+                                ASSEMBLE_ERROR(tokens[i + 1], "Expected the name of a host function.");
+                            }
+
+                            auto [it, inserted] = m_HostIndices.try_emplace(std::string(tokens[i + 2].text), m_HostImports.size());
+                            if (!inserted)
+                            {
+                                ASSEMBLE_ERROR(tokens[i + 2], "Redeclaration of host function '" << tokens[i + 2].text << "'.");
+                            }
+                            m_HostImports.emplace_back(tokens[i + 2].text);
+                            i += 2;
+                        }
                         else if (tokens[i + 1].type == TokenType::Identifier)
                         {
                             // Possible local label reference
                             if (tokens[i + 2].type != TokenType::Operator || tokens[i + 2].text != ":")
                             {
-                                if (m_LabelAddressMap.find(current_label) != m_LabelAddressMap.end() &&
-                                    m_LabelAddressMap[current_label].second.find(tokens[i + 1].text) !=
-                                        m_LabelAddressMap[current_label].second.end())
-                                {
-                                    operand_count++;
-                                    current_instruction.imm64 = (u64)m_LabelAddressMap[current_label].second[tokens[i + 1].text];
-                                    i++;
-                                    break;
-                                }
-                                else
+                                operand_count++;
+                                if (auto it = m_LabelAddressMap.find(m_CurrentLabel); it != m_LabelAddressMap.end())
                                 {
-                                    if (!current_label.empty())
+                                    if (auto local = it->second.second.find(tokens[i + 1].text); local != it->second.second.end())
                                     {
-                                        ASSEMBLE_ERROR(tokens[i], "Local label " << tokens[i + 1].text << " in parent label " << current_label << " is undefined.");
-                                    }
-                                    else
-                                    {
-                                        ASSEMBLE_ERROR(tokens[i], "Attempted to reference a local label in an unexistent parent label.");
+                                        current_instruction.imm64 = (u64)local->second;
+                                        m_Relocations.push_back({.index = m_AssembledCode.size()});
+                                        i++;
+                                        break;
                                     }
                                 }
+                                m_Fixups.push_back(
+                                    {
+                                        .index = m_AssembledCode.size(),
+                                        .label = m_CurrentLabel,
+                                        .local = std::string(tokens[i + 1].text),
+                                        .line = tokens[i].line,
+                                        .cur = tokens[i].cur,
+                                    });
+                                i++;
+                                break;
                             }
                             else if (tokens[i + 2].type == TokenType::Operator || tokens[i + 2].text == ":")
                             {
-                                // It's a local label definition, ignore it.
+                                // Local label definition.
+                                auto& locals = m_LabelAddressMap[m_CurrentLabel].second;
+                                if (locals.find(tokens[i + 1].text) != locals.end())
+                                {
+                                    ASSEMBLE_ERROR(tokens[i], "Unconsistent local label redefinition of '" << tokens[i + 1].text << "'.");
+                                }
+                                locals[std::string(tokens[i + 1].text)] = m_InstCount;
                                 i += 2;
                                 break;
                             }
@@ -1169,7 +1409,7 @@ namespace relang::basm {
                             break;
                     }
 
-                    current_instruction.imm64 = std::stoull(tokens[i].text);
+                    current_instruction.imm64 = tokens[i].data;
                     break;
                 }
                 case TokenType::Identifier:
@@ -1247,6 +1487,8 @@ namespace relang::basm {
                             }
 
                             current_instruction.imm64 = it->second.addr;
+                            if (!it->second.constant)
+                                AddRelocation(it->second, RelocationField::Imm64);
                         }
                     }
                     else if (auto it = m_SymbolTable.find(tokens[i].text); it != m_SymbolTable.end())
@@ -1272,6 +1514,7 @@ namespace relang::basm {
                                     {
                                         current_instruction.sreg = (blend::RegType)(blend::RegType::DS | 0x80);
                                         current_instruction.disp = (i64)it->second.addr;
+                                        AddRelocation(it->second, RelocationField::Disp);
                                     }
                                     else
                                     {
@@ -1323,6 +1566,7 @@ namespace relang::basm {
                                         {
                                             current_instruction.sreg = (blend::RegType)(blend::RegType::DS | 0x80);
                                             current_instruction.disp = (i64)it->second.addr;
+                                            AddRelocation(it->second, RelocationField::Disp);
                                         }
                                         else
                                         {
@@ -1335,6 +1579,18 @@ namespace relang::basm {
                                     ASSEMBLE_ERROR(tokens[i], "Instruction expects one of the following types: BYTE, WORD, DWORD, QWORD");
                                 }
                                 break;
+                            case blend::OpCode::Jtab:
+                                if (it->second.type != DataType::JumpTable)
+                                {
+                                    ASSEMBLE_ERROR(tokens[i], "Instruction expects a jump table declared with jtab in the data section.");
+                                }
+                                else if (operand_count == 0)
+                                {
+                                    ASSEMBLE_ERROR(tokens[i], "Instruction expects the index register first, e.g. jtab %r0, _CASES.");
+                                }
+                                current_instruction.disp = (i32)it->second.addr;
+                                AddRelocation(it->second, RelocationField::Disp);
+                                break;
                             case blend::OpCode::Store:
                                 if (it->second.type != DataType::Undefined)
                                 {
@@ -1352,6 +1608,7 @@ namespace relang::basm {
                                         {
                                             current_instruction.dreg = (blend::RegType)(blend::RegType::DS | 0x80);
                                             current_instruction.disp = (i64)it->second.addr;
+                                            AddRelocation(it->second, RelocationField::Disp);
                                         }
                                         else
                                         {
@@ -1403,6 +1660,7 @@ namespace relang::basm {
                                         {
                                             current_instruction.sreg = (blend::RegType)(blend::RegType::DS | 0x80);
                                             current_instruction.disp = (i64)it->second.addr;
+                                            AddRelocation(it->second, RelocationField::Disp);
                                         }
                                     }
                                     else
@@ -1426,21 +1684,147 @@ namespace relang::basm {
             }
         }
 
-        m_AssembledCode.push_back(current_instruction);
+        // Chunks always end on a line boundary so whatever instruction is pending is complete.
+        return EmitInstruction(tokens[inst_token_id], current_instruction, operand_count);
+    }
+
+    AssemblerStatus Assembler::EmitInstruction(const Token& inst_token, const blend::Instruction& inst, int operand_count)
+    {
+        if (inst.opcode != blend::OpCode::Nop)
+        {
+            switch (inst.opcode)
+            {
+                // Instructions that accept no operands.
+                case blend::OpCode::Return:
+                case blend::OpCode::End:
+                case blend::OpCode::Lrzf:
+                case blend::OpCode::Srzf:
+                case blend::OpCode::Nop:
+                case blend::OpCode::Pushar:
+                case blend::OpCode::Popar:
+                case blend::OpCode::DumpFlags:
+                case blend::OpCode::Syscall:
+                case blend::OpCode::SyscallV:
+                case blend::OpCode::Present:
+                    if (operand_count > -1)
+                    {
+                        ASSEMBLE_ERROR(inst_token, "Instruction doesn't accept any operands.");
+                    }
+                    break;
+                // Instructions that accept a list of operands.
+                case blend::OpCode::Pushm:
+                case blend::OpCode::Popm:
+                    if (operand_count == -1)
+                    {
+                        ASSEMBLE_ERROR(inst_token, "Instruction expects the registers to save, e.g. pushm %r4, %r5.");
+                    }
+                    break;
+                // Instructions that accept no operands or a list of registers.
+                case blend::OpCode::Leave:
+                case blend::OpCode::LeaveRet:
+                    break;
+                // Instructions that accept a single operand optionally followed by a list of registers.
+                case blend::OpCode::Enter:
+                    if (operand_count == -1)
+                    {
+                        ASSEMBLE_ERROR(inst_token, "Instruction expects the size of the frame, e.g. enter $16, %r4, %r5.");
+                    }
+                    break;
+                case blend::OpCode::TailCall:
+                    if (operand_count == -1)
+                    {
+                        ASSEMBLE_ERROR(inst_token, "Instruction expects a label or a register to jump to, e.g. tcall @fn, %r4.");
+                    }
+                    break;
+                // Instructions that accept a single operand.
+                case blend::OpCode::Call:
+                case blend::OpCode::Jump:
+                case blend::OpCode::Jc:
+                case blend::OpCode::Jcn:
+                case blend::OpCode::Jue:
+                case blend::OpCode::Jl:
+                case blend::OpCode::Jno:
+                case blend::OpCode::Jns:
+                case blend::OpCode::Jnz:
+                case blend::OpCode::Jo:
+                case blend::OpCode::Js:
+                case blend::OpCode::Jug:
+                case blend::OpCode::Juge:
+                case blend::OpCode::Jul:
+                case blend::OpCode::Jule:
+                case blend::OpCode::June:
+                case blend::OpCode::PInt:
+                case blend::OpCode::PStr:
+                case blend::OpCode::PChr:
+                case blend::OpCode::Push:
+                case blend::OpCode::Pop:
+                case blend::OpCode::Mul:
+                case blend::OpCode::Div:
+                case blend::OpCode::Neg:
+                case blend::OpCode::System:
+                case blend::OpCode::GetChar:
+                case blend::OpCode::Inc:
+                case blend::OpCode::Dec:
+                case blend::OpCode::Malloc:
+                case blend::OpCode::Free:
+                case blend::OpCode::SConio:
+                case blend::OpCode::InvokeC:
+                case blend::OpCode::HostCall:
+                case blend::OpCode::Clock:
+                case blend::OpCode::Rdtsc:
+                case blend::OpCode::Sleep:
+                case blend::OpCode::Spawn:
+                case blend::OpCode::Shell:
+                case blend::OpCode::PollKey:
+                    // Instructions that accept both no operands or a single operand.
+                    switch (inst.opcode)
+                    {
+                        case blend::OpCode::Pop:
+                            goto ok_instruction_case;
+                            break;
+                    }
+
+                    if (operand_count > 0)
+                    {
+                        ASSEMBLE_ERROR(inst_token, "Instruction is unary.");
+                    }
+                    else if (operand_count == -1)
+                    {
+                        ASSEMBLE_ERROR(inst_token, "Instruction accepts a single operand but no operands were passed. Refer to its encoding for correct usage.");
+                    }
+                    break;
+                // Instructions that acceot three operands.
+                // None...
+                // Instructions that accept two operands.
+                default:
+                    // Instructions that accept both two operands or a single operand.
+                    switch (inst.opcode)
+                    {
+                        case blend::OpCode::Printf:
+                            goto ok_instruction_case;
+                            break;
+                    }
+
+                    if (operand_count <= 0 || operand_count > 1)
+                    {
+                        ASSEMBLE_ERROR(inst_token, "Invalid number of operands passed to Instruction.\nRefer to its encoding for correct usage.");
+                    }
+                    break;
+            }
+        ok_instruction_case:
+            m_AssembledCode.push_back(inst);
+        }
         if (!m_InstEpilogue.empty())
         {
             m_AssembledCode.insert(m_AssembledCode.end(), m_InstEpilogue.begin(), m_InstEpilogue.end());
             m_InstEpilogue.clear();
         }
-
-        m_AssembledCode.push_back(blend::Instruction{.opcode = blend::OpCode::End});
         return AssemblerStatus::Ok;
     }
 
-    blend::OpCode Assembler::GetInst(std::string inst)
+    blend::OpCode Assembler::GetInst(std::string_view inst_str)
     {
-        std::for_each(inst.begin(), inst.end(), [](char& c)
-                      { c = std::tolower(c); });
+        std::string inst = utils::string::ToLowerCopy(inst_str);
         auto it = std::find_if(blend::Instruction::InstructionStr.begin(), blend::Instruction::InstructionStr.end(),
                                [&inst](std::string str)
                                {
@@ -1454,10 +1838,9 @@ namespace relang::basm {
                    : blend::OpCode::Nop;
     }
 
-    blend::RegType Assembler::GetReg(std::string reg)
+    blend::RegType Assembler::GetReg(std::string_view reg_str)
     {
-        std::for_each(reg.begin(), reg.end(), [](char& c)
-                      { c = std::tolower(c); });
+        std::string reg = utils::string::ToLowerCopy(reg_str);
         auto it = std::find_if(blend::Register::RegisterStr.begin(), blend::Register::RegisterStr.end(),
                                [&reg](std::string str)
                                {
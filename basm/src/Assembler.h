@@ -3,9 +3,12 @@
 
 #include <Blend.h>
 #include <cstdint>
+#include <filesystem>
+#include <istream>
 #include <unordered_map>
 
 #include "Lexer.h"
+#include "TokenStream.h"
 #include "Utils.h"
 
 #include <CommonDef.h>
@@ -20,7 +23,9 @@ namespace relang::basm
     Byte,
     Word,
     DWord,
-    QWord
+    QWord,
+    // A count followed by that many code addresses, for jtab.
+    JumpTable
 };
 
     struct DataInfo
@@ -41,10 +46,69 @@ namespace relang::basm
     ReadError
 };
 
+    struct IncludedFile
+    {
+        std::string source;
+        TokenList tokens;
+        // File carries a .once include guard.
+        bool once = false;
+        bool expanded = false;
+        // Currently being expanded, used to catch recursive includes.
+        bool active = false;
+    };
+
+    struct LabelFixup
+    {
+        // Index of the instruction whose imm64 is waiting on the label.
+        usize index = 0;
+        std::string label;
+        // Set for local label references, label then holds the parent label.
+        std::string local;
+        u32 line = 0;
+        u32 cur = 0;
+        // Set for jump table entries, index is then the offset of the qword in the data section.
+        bool data = false;
+    };
+
+    enum class RelocationType : u8
+    {
+        Code,
+        Data,
+        Bss,
+        // Index into the native import table, for invokec.
+        Native,
+        // Index into the host import table, for hostcall.
+        Host
+    };
+
+    enum class RelocationField : u8
+    {
+        Imm64,
+        Disp,
+        // A qword in the data section rather than an instruction field, index is its offset.
+        Data
+    };
+
+    // An instruction field holding an address that moves when units are linked together.
+    struct Relocation
+    {
+        usize index = 0;
+        RelocationType type = RelocationType::Code;
+        RelocationField field = RelocationField::Imm64;
+    };
+
     struct AssemblerResult
     {
         blend::InstructionList assembledCode;
         std::vector<u8> dataSection;
+        usize bssSize = 0;
+        // Link information, only kept for OutputType::Lib and OutputType::DLib which both produce
+        // relocatable object files.
+        utils::StringMap<usize> labels;
+        std::vector<Relocation> relocations;
+        std::vector<LabelFixup> imports;
+        std::vector<blend::NativeImport> nativeImports;
+        std::vector<std::string> hostImports;
         AssemblerStatus status;
     };
 
@@ -58,33 +122,54 @@ namespace relang::basm
     struct AssemblerOptions
     {
         OutputType type;
-        const TokenList& tokens;
+        const TokenList* tokens = nullptr;
+        // When set the source is lexed and assembled chunk by chunk instead of going through tokens.
+        std::istream* source = nullptr;
         const std::string& path;
+        // The top level .include paths are relative to this, the directory of the unit's source file.
+        std::filesystem::path dir{};
     };
 
     struct Assembler
     {
     private:
-        static std::unordered_map<std::string, DataInfo> m_SymbolTable;
-        static std::unordered_map<std::string, std::pair<usize, std::unordered_map<std::string, usize>>> m_LabelAddressMap;
-        static std::vector<blend::Instruction> m_AssembledCode;
-        static std::vector<blend::Instruction> m_InstEpilogue;
-        static std::vector<u8> m_DataSection;
-        static usize m_BssSize;
-        static std::string m_CurrentSection;
+        utils::StringMap<DataInfo> m_SymbolTable;
+        utils::StringMap<std::pair<usize, utils::StringMap<usize>>> m_LabelAddressMap;
+        std::vector<blend::Instruction> m_AssembledCode;
+        std::vector<blend::Instruction> m_InstEpilogue;
+        std::vector<u8> m_DataSection;
+        usize m_BssSize = 0;
+        std::string m_CurrentSection;
+        utils::StringMap<IncludedFile> m_IncludeCache;
+        Lexer m_Lexer;
+        std::vector<LabelFixup> m_Fixups;
+        std::vector<Relocation> m_Relocations;
+        std::vector<LabelFixup> m_Imports;
+        std::vector<blend::NativeImport> m_NativeImports;
+        utils::StringMap<usize> m_NativeIndices;
+        std::vector<std::string> m_HostImports;
+        utils::StringMap<usize> m_HostIndices;
+        std::string m_CurrentLabel;
+        usize m_InstCount = 0;
 
     private:
-        static void LabelProcessor(TokenList& tokens);
-        static void Cleanup();
-        static AssemblerStatus WriteToBinary(const std::string& path);
+        void ExpandIncludes(const TokenList& tokens, TokenStream& stream, const std::filesystem::path& dir);
+        void Cleanup();
+
+    public:
+        AssemblerResult Assemble(AssemblerOptions& opt);
 
     public:
-        static AssemblerResult Assemble(AssemblerOptions& opt);
+        static AssemblerStatus WriteToBinary(const std::string& path, const AssemblerResult& res);
 
     private:
-        static AssemblerStatus CodeGen(TokenList& tokens);
-        static blend::OpCode GetInst(std::string inst);
-        static blend::RegType GetReg(std::string reg);
+        AssemblerStatus StreamCodeGen(std::istream& source, const std::filesystem::path& dir);
+        AssemblerStatus CodeGen(const TokenStream& tokens);
+        AssemblerStatus EmitInstruction(const Token& inst_token, const blend::Instruction& inst, int operand_count);
+        AssemblerStatus ResolveFixups(bool allow_imports);
+        void AddRelocation(const DataInfo& inf, RelocationField field);
+        static blend::OpCode GetInst(std::string_view inst);
+        static blend::RegType GetReg(std::string_view reg);
     };
 } // namespace relang::rmc
 
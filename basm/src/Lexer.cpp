@@ -4,15 +4,79 @@ namespace relang::basm
 {
     void Token::Dump() const
     {
-        std::printf("token { \"%s\" type: %s data: %lu [%lu, %lu] }\n",
-                    text.c_str(), GET_TOKEN_STR(type).c_str(), data, line, cur);
+        std::printf("token { \"%.*s\" type: %s data: %lu [%u, %u] }\n",
+                    (int)text.size(), text.data(), GET_TOKEN_STR(type).c_str(), data, line, cur);
     }
 
-    TokenList Lexer::Start(const std::string& src)
+    void Lexer::TokenText::Append(const usize index, const char c)
+    {
+        if (!owned)
+        {
+            if (src[index] == c && (length == 0 || begin + length == index))
+            {
+                if (length == 0)
+                    begin = index;
+                length++;
+                return;
+            }
+
+            // The text no longer mirrors the source, copy what we have so far and continue from there.
+            owned = true;
+            buffer.assign(src.substr(begin, length));
+        }
+        buffer.push_back(c);
+    }
+
+    void Lexer::TokenText::Reset() noexcept
+    {
+        begin = 0;
+        length = 0;
+        owned = false;
+        buffer.clear();
+    }
+
+    std::string_view Lexer::TokenText::View() const noexcept
+    {
+        return (owned) ? std::string_view(buffer) : src.substr(begin, length);
+    }
+
+    std::string_view Lexer::Intern(std::string_view str)
+    {
+        return *m_StringTable.emplace(str).first;
+    }
+
+    void Lexer::Clear() noexcept
+    {
+        m_StringTable.clear();
+    }
+
+    u64 Lexer::ParseNumber(std::string_view str) noexcept
+    {
+        // Mirrors std::stoull(): an optional sign followed by decimal digits, negative values wrap around.
+        bool negative = false;
+        if (!str.empty() && (str[0] == '+' || str[0] == '-'))
+        {
+            negative = str[0] == '-';
+            str.remove_prefix(1);
+        }
+
+        u64 value = 0;
+        for (const char c : str)
+        {
+            if (c < '0' || c > '9')
+                break;
+            value = value * 10 + (c - '0');
+        }
+        return (negative) ? (u64)-(i64)value : value;
+    }
+
+    TokenList Lexer::Start(std::string_view src, u32 line)
     {
         TokenList tokens;
         Token current_token;
-        current_token.line = 1;
+        current_token.line = line;
+
+        TokenText text{.src = src};
 
     std:;
         size_t cur = 0;
@@ -25,10 +89,10 @@ namespace relang::basm
                 {
                     if (current_token.type == TokenType::Comment || current_token.type == TokenType::StringLiteral)
                     {
-                        current_token.text.append(1, c);
+                        text.Append(i, c);
                         break;
                     }
-                    EndToken(current_token, tokens);
+                    EndToken(current_token, text, tokens);
                     current_token.type = TokenType::Immediate;
                     break;
                 }
@@ -36,42 +100,47 @@ namespace relang::basm
                 {
                     if (current_token.type == TokenType::Comment || current_token.type == TokenType::StringLiteral)
                     {
-                        current_token.text.append(1, c);
+                        text.Append(i, c);
                         break;
                     }
-                    EndToken(current_token, tokens);
+                    EndToken(current_token, text, tokens);
                     current_token.type = TokenType::Immediate;
 
+                    usize begin = i;
                     u16 cx = src[++i];
                     if (cx == '\\')
                     {
                         switch (src[++i])
                         {
                             case 'n':
-                                current_token.text = "10";
+                                current_token.data = 10;
                                 break;
                             case 't':
-                                current_token.text = "9";
+                                current_token.data = 9;
                                 break;
                             case 'r':
-                                current_token.text = "13";
+                                current_token.data = 13;
                                 break;
                             case '0':
-                                current_token.text = "0";
+                                current_token.data = 0;
                                 break;
                             case '\\':
-                                current_token.text = "92";
+                                current_token.data = 92;
                                 break;
                             case '\'':
-                                current_token.text = "39";
+                                current_token.data = 39;
                                 break;
                         }
                     }
                     else
                     {
-                        current_token.text = std::to_string(cx);
+                        current_token.data = cx;
                     }
                     i++;
+
+                    // The token's text is the character literal itself, quotes included.
+                    text.begin = begin;
+                    text.length = i - begin + 1;
                     break;
                 }
                 case '0':
@@ -90,36 +159,36 @@ namespace relang::basm
                         current_token.type == TokenType::Immediate ||
                         current_token.type == TokenType::Identifier)
                     {
-                        current_token.text.append(1, c);
+                        text.Append(i, c);
                         break;
                     }
                     else
                     {
-                        EndToken(current_token, tokens);
-                        current_token.text.append(1, c);
+                        EndToken(current_token, text, tokens);
+                        text.Append(i, c);
                         current_token.type = TokenType::Displacement;
                     }
                     break;
                 case '\\':
                 {
-                    if (current_token.type == TokenType::StringLiteral)
+                    if (current_token.type == TokenType::StringLiteral && i + 1 < src.size())
                     {
                         switch (src[i + 1])
                         {
                             case '0':
-                                current_token.text.append(1, '\0');
+                                text.Append(i, '\0');
                                 break;
                             case 'n':
-                                current_token.text.append(1, '\n');
+                                text.Append(i, '\n');
                                 break;
                             case 'r':
-                                current_token.text.append(1, '\r');
+                                text.Append(i, '\r');
                                 break;
                             case 't':
-                                current_token.text.append(1, '\t');
+                                text.Append(i, '\t');
                                 break;
                             case '"':
-                                current_token.text.append(1, '\"');
+                                text.Append(i, '\"');
                                 break;
                         }
                         i++;
@@ -130,16 +199,16 @@ namespace relang::basm
                 {
                     if (current_token.type == TokenType::Comment)
                     {
-                        current_token.text.append(1, c);
+                        text.Append(i, c);
                         break;
                     }
                     else if (current_token.type == TokenType::StringLiteral)
                     {
-                        EndToken(current_token, tokens);
+                        EndToken(current_token, text, tokens);
                     }
                     else
                     {
-                        EndToken(current_token, tokens);
+                        EndToken(current_token, text, tokens);
                         current_token.type = TokenType::StringLiteral;
                     }
                     break;
@@ -147,7 +216,7 @@ namespace relang::basm
                 case '\n':
                 case '\r':
                 {
-                    EndToken(current_token, tokens);
+                    EndToken(current_token, text, tokens);
                     cur = 0;
                     current_token.cur = 0;
                     current_token.line++;
@@ -159,20 +228,20 @@ namespace relang::basm
                 {
                     if (current_token.type == TokenType::Comment || current_token.type == TokenType::StringLiteral)
                     {
-                        current_token.text.append(1, c);
+                        text.Append(i, c);
                         break;
                     }
-                    EndToken(current_token, tokens);
+                    EndToken(current_token, text, tokens);
                     break;
                 }
                 case ';':
                 {
                     if (current_token.type == TokenType::Comment || current_token.type == TokenType::StringLiteral)
                     {
-                        current_token.text.append(1, c);
+                        text.Append(i, c);
                         break;
                     }
-                    EndToken(current_token, tokens);
+                    EndToken(current_token, text, tokens);
                     current_token.type = TokenType::Comment;
                     break;
                 }
@@ -192,44 +261,44 @@ namespace relang::basm
                 {
                     if (current_token.type == TokenType::Comment || current_token.type == TokenType::StringLiteral)
                     {
-                        current_token.text.append(1, c);
+                        text.Append(i, c);
                         break;
                     }
-                    else if ((src[i] == '+' || src[i] == '-') && (src[i + 1] >= '0' && src[i + 1] <= '9'))
+                    else if ((src[i] == '+' || src[i] == '-') && i + 1 < src.size() && (src[i + 1] >= '0' && src[i + 1] <= '9'))
                     {
-                        EndToken(current_token, tokens);
+                        EndToken(current_token, text, tokens);
                         current_token.type = TokenType::Displacement;
-                        current_token.text.append(1, c);
+                        text.Append(i, c);
                         break;
                     }
-                    EndToken(current_token, tokens);
+                    EndToken(current_token, text, tokens);
                     current_token.type = TokenType::Operator;
-                    current_token.text.append(1, c);
-                    EndToken(current_token, tokens);
+                    text.Append(i, c);
+                    EndToken(current_token, text, tokens);
                     break;
                 }
                 default:
                 {
                     if (current_token.type == TokenType::Whitespace)
                     {
-                        EndToken(current_token, tokens);
+                        EndToken(current_token, text, tokens);
                         if (tokens.empty() || tokens.back().line < current_token.line)
                         {
                             current_token.type = TokenType::Instruction;
-                            current_token.cur = cur;
-                            current_token.text.append(1, c);
+                            current_token.cur = (u32)cur;
+                            text.Append(i, c);
                         }
                         else
                         {
                             current_token.type = TokenType::Identifier;
-                            current_token.cur = cur;
-                            current_token.text.append(1, c);
+                            current_token.cur = (u32)cur;
+                            text.Append(i, c);
                         }
                     }
                     else
                     {
-                        current_token.text.append(1, c);
-                        current_token.cur = cur + 1;
+                        text.Append(i, c);
+                        current_token.cur = (u32)cur + 1;
                     }
                     break;
                 }
@@ -237,19 +306,23 @@ namespace relang::basm
             cur++;
         }
 
-        EndToken(current_token, tokens);
+        EndToken(current_token, text, tokens);
         return tokens;
     }
 
-    void Lexer::EndToken(Token& t, TokenList& tokens)
+    void Lexer::EndToken(Token& t, TokenText& text, TokenList& tokens)
     {
         if (t.type != TokenType::Whitespace && t.type != TokenType::Comment)
         {
+            t.text = (text.owned) ? Intern(text.buffer) : text.View();
             switch (t.type)
             {
                 case TokenType::Immediate:
+                case TokenType::Displacement:
                 {
-                    t.data = (i32)std::stoul(t.text);
+                    // Character literals already had their value decoded.
+                    if (t.text.empty() || t.text[0] != '\'')
+                        t.data = ParseNumber(t.text);
                     break;
                 }
                 default:
@@ -259,6 +332,7 @@ namespace relang::basm
         }
         t.type = TokenType::Whitespace;
         t.data = 0;
-        t.text.erase();
+        t.text = {};
+        text.Reset();
     }
 } // namespace relang::rmc
@@ -3,6 +3,8 @@
 
 #include <Blend.h>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
 #define GET_TOKEN_STR(token) Token::TokenStr[(usize)token]
@@ -13,7 +15,7 @@ namespace relang::basm {
 
     using TokenList = std::vector<Token>;
 
-    enum class TokenType
+    enum class TokenType : u8
     {
         Whitespace,
         Comment,
@@ -32,10 +34,13 @@ namespace relang::basm {
 
     public:
         TokenType type = TokenType::Whitespace;
-        std::string text;
+        // A view into the source buffer that was lexed or, for text that had to be rewritten
+        // (e.g. escaped string literals), into the lexer's interned string table.
+        std::string_view text;
+        // Numeric value of Immediate and Displacement tokens, parsed once by the lexer.
         u64 data = 0;
-        usize line = 0;
-        usize cur = 0;
+        u32 line = 0;
+        u32 cur = 0;
 
     public:
         inline static const std::vector<std::string> TokenStr =
@@ -58,11 +63,35 @@ namespace relang::basm {
 
     class Lexer
     {
+    private:
+        // Tracks the text of the token currently being lexed as a span into the source and only
+        // falls back to an owned buffer once the text stops being a verbatim slice of it.
+        struct TokenText
+        {
+            std::string_view src;
+            usize begin = 0;
+            usize length = 0;
+            bool owned = false;
+            std::string buffer;
+
+        public:
+            void Append(const usize index, const char c);
+            void Reset() noexcept;
+            std::string_view View() const noexcept;
+        };
+
+    private:
+        std::unordered_set<std::string> m_StringTable;
+
     public:
-        static TokenList Start(const std::string& src);
+        // The returned tokens reference src and the lexer's string table, so both must outlive them.
+        TokenList Start(std::string_view src, u32 line = 1);
+        std::string_view Intern(std::string_view str);
+        void Clear() noexcept;
+        static u64 ParseNumber(std::string_view str) noexcept;
 
     private:
-        static void EndToken(Token& t, TokenList& tokens);
+        void EndToken(Token& t, TokenText& text, TokenList& tokens);
     };
 } // namespace relang::rmc
 
@@ -0,0 +1,102 @@
+#include "Linker.h"
+
+namespace relang::basm {
+    AssemblerResult Linker::Link(const std::vector<AssemblerResult>& units, const std::vector<std::string>& names)
+    {
+        AssemblerResult res{};
+        res.status = AssemblerStatus::Ok;
+
+        usize code_size = 0;
+        usize data_size = 0;
+        for (const auto& unit : units)
+        {
+            code_size += unit.assembledCode.size();
+            data_size += unit.dataSection.size();
+        }
+        res.assembledCode.reserve(code_size + 1);
+        res.dataSection.reserve(data_size);
+
+        // Gather the labels first, units can reference labels of units that come after them.
+        utils::StringMap<usize> labels;
+        for (usize i = 0, code_base = 0; i < units.size(); code_base += units[i++].assembledCode.size())
+        {
+            for (const auto& [label, address] : units[i].labels)
+            {
+                if (!labels.emplace(label, code_base + address).second)
+                {
+                    std::cerr << "Link Error: " << names[i] << ": Multiple definitions of label '" << label << "'.\n";
+                    res.status = AssemblerStatus::AssembleError;
+                    return res;
+                }
+            }
+        }
+
+        for (usize i = 0; i < units.size(); ++i)
+        {
+            const auto& unit = units[i];
+            const usize code_base = res.assembledCode.size();
+            const usize data_base = res.dataSection.size();
+            const usize native_base = res.nativeImports.size();
+            const usize host_base = res.hostImports.size();
+            // BSS addresses were handed out right after the unit's own data section.
+            const usize bss_base = data_size + res.bssSize - unit.dataSection.size();
+
+            res.assembledCode.insert(res.assembledCode.end(), unit.assembledCode.begin(), unit.assembledCode.end());
+            res.dataSection.insert(res.dataSection.end(), unit.dataSection.begin(), unit.dataSection.end());
+            res.bssSize += unit.bssSize;
+            res.nativeImports.insert(res.nativeImports.end(), unit.nativeImports.begin(), unit.nativeImports.end());
+            res.hostImports.insert(res.hostImports.end(), unit.hostImports.begin(), unit.hostImports.end());
+
+            for (const auto& reloc : unit.relocations)
+            {
+                usize offset = 0;
+                switch (reloc.type)
+                {
+                    case RelocationType::Code:
+                        offset = code_base;
+                        break;
+                    case RelocationType::Data:
+                        offset = data_base;
+                        break;
+                    case RelocationType::Bss:
+                        offset = bss_base;
+                        break;
+                    case RelocationType::Native:
+                        offset = native_base;
+                        break;
+                    case RelocationType::Host:
+                        offset = host_base;
+                        break;
+                }
+
+                if (reloc.field == RelocationField::Data)
+                {
+                    *(u64*)(res.dataSection.data() + data_base + reloc.index) += offset;
+                    continue;
+                }
+
+                auto& inst = res.assembledCode[code_base + reloc.index];
+                if (reloc.field == RelocationField::Imm64)
+                    inst.imm64 += offset;
+                else
+                    inst.disp += (i32)offset;
+            }
+
+            for (const auto& import : unit.imports)
+            {
+                auto it = labels.find(import.label);
+                if (it == labels.end())
+                {
+                    std::cerr << "Link Error: " << names[i] << " @ line (" << import.line << ", " << import.cur << "): "
+                              << "Attempted to reference an undefined label '" << import.label << "'.\n";
+                    res.status = AssemblerStatus::AssembleError;
+                    return res;
+                }
+                res.assembledCode[code_base + import.index].imm64 = (u64)it->second;
+            }
+        }
+
+        res.assembledCode.push_back(blend::Instruction{.opcode = blend::OpCode::End});
+        return res;
+    }
+} // namespace relang::basm
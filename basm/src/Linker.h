@@ -0,0 +1,19 @@
+#ifndef BLEND_BASM_LINKER_H
+#define BLEND_BASM_LINKER_H
+
+#include <string>
+#include <vector>
+
+#include "Assembler.h"
+
+namespace relang::basm {
+    // Merges relocatable units (OutputType::Lib) into a single executable image. Code and data of
+    // each unit are laid out in order, all BSS goes after the merged data section.
+    class Linker
+    {
+    public:
+        static AssemblerResult Link(const std::vector<AssemblerResult>& units, const std::vector<std::string>& names);
+    };
+} // namespace relang::basm
+
+#endif // BLEND_BASM_LINKER_H
@@ -0,0 +1,179 @@
+#include "ObjectFile.h"
+
+namespace relang::basm {
+    template <typename T>
+    static void WriteValue(std::ofstream& fs, const T& value)
+    {
+        fs.write((const char*)&value, sizeof(T));
+    }
+
+    static void WriteString(std::ofstream& fs, const std::string& str)
+    {
+        WriteValue(fs, (u32)str.size());
+        fs.write(str.data(), str.size());
+    }
+
+    template <typename T>
+    static bool ReadValue(std::ifstream& fs, T& value)
+    {
+        return (bool)fs.read((char*)&value, sizeof(T));
+    }
+
+    static bool ReadString(std::ifstream& fs, std::string& str)
+    {
+        u32 size = 0;
+        if (!ReadValue(fs, size))
+            return false;
+        str.resize(size);
+        return (bool)fs.read(str.data(), size);
+    }
+
+    AssemblerStatus ObjectFile::Write(const std::string& path, const AssemblerResult& res)
+    {
+        std::ofstream fs(path, std::ios::binary);
+        if (!fs.is_open())
+            return AssemblerStatus::WriteError;
+
+        WriteValue(fs, OBJECT_FILE_MAGIC);
+
+        WriteValue(fs, blend::DATA_SECTION_INDIC);
+        WriteValue(fs, (usize)res.dataSection.size());
+        fs.write((const char*)res.dataSection.data(), res.dataSection.size());
+
+        WriteValue(fs, blend::BSS_SECTION_INDIC);
+        WriteValue(fs, res.bssSize);
+
+        WriteValue(fs, blend::CODE_SECTION_INDIC);
+        WriteValue(fs, (usize)(res.assembledCode.size() * sizeof(blend::Instruction)));
+        fs.write((const char*)res.assembledCode.data(), res.assembledCode.size() * sizeof(blend::Instruction));
+
+        WriteValue(fs, LABEL_SECTION_INDIC);
+        WriteValue(fs, (usize)res.labels.size());
+        for (const auto& [label, address] : res.labels)
+        {
+            WriteString(fs, label);
+            WriteValue(fs, address);
+        }
+
+        WriteValue(fs, RELOCATION_SECTION_INDIC);
+        WriteValue(fs, (usize)res.relocations.size());
+        for (const auto& reloc : res.relocations)
+        {
+            WriteValue(fs, reloc.index);
+            WriteValue(fs, reloc.type);
+            WriteValue(fs, reloc.field);
+        }
+
+        WriteValue(fs, IMPORT_SECTION_INDIC);
+        WriteValue(fs, (usize)res.imports.size());
+        for (const auto& import : res.imports)
+        {
+            WriteString(fs, import.label);
+            WriteValue(fs, import.index);
+            WriteValue(fs, import.line);
+            WriteValue(fs, import.cur);
+        }
+
+        WriteValue(fs, blend::NATIVE_IMPORT_SECTION_INDIC);
+        WriteValue(fs, (usize)res.nativeImports.size());
+        for (const auto& import : res.nativeImports)
+        {
+            WriteString(fs, import.library);
+            WriteString(fs, import.symbol);
+            WriteString(fs, import.signature);
+        }
+
+        WriteValue(fs, blend::HOST_IMPORT_SECTION_INDIC);
+        WriteValue(fs, (usize)res.hostImports.size());
+        for (const auto& name : res.hostImports)
+            WriteString(fs, name);
+
+        return (fs) ? AssemblerStatus::Ok : AssemblerStatus::WriteError;
+    }
+
+    AssemblerStatus ObjectFile::Read(const std::string& path, AssemblerResult& res)
+    {
+        std::ifstream fs(path, std::ios::binary);
+        if (!fs.is_open())
+            return AssemblerStatus::ReadError;
+
+        u32 magic = 0;
+        if (!ReadValue(fs, magic) || magic != OBJECT_FILE_MAGIC)
+            return AssemblerStatus::ReadError;
+
+        u8 indic;
+        usize size = 0;
+        while (ReadValue(fs, indic))
+        {
+            if (!ReadValue(fs, size))
+                return AssemblerStatus::ReadError;
+
+            switch (indic)
+            {
+                case blend::DATA_SECTION_INDIC:
+                    res.dataSection.resize(size);
+                    fs.read((char*)res.dataSection.data(), size);
+                    break;
+                case blend::BSS_SECTION_INDIC:
+                    res.bssSize = size;
+                    break;
+                case blend::CODE_SECTION_INDIC:
+                    res.assembledCode.resize(size / sizeof(blend::Instruction));
+                    fs.read((char*)res.assembledCode.data(), size);
+                    break;
+                case LABEL_SECTION_INDIC:
+                    for (usize i = 0; i < size; ++i)
+                    {
+                        std::string label;
+                        usize address = 0;
+                        if (!ReadString(fs, label) || !ReadValue(fs, address))
+                            return AssemblerStatus::ReadError;
+                        res.labels[std::move(label)] = address;
+                    }
+                    break;
+                case RELOCATION_SECTION_INDIC:
+                    res.relocations.resize(size);
+                    for (auto& reloc : res.relocations)
+                    {
+                        if (!ReadValue(fs, reloc.index) || !ReadValue(fs, reloc.type) || !ReadValue(fs, reloc.field))
+                            return AssemblerStatus::ReadError;
+                    }
+                    break;
+                case IMPORT_SECTION_INDIC:
+                    res.imports.resize(size);
+                    for (auto& import : res.imports)
+                    {
+                        if (!ReadString(fs, import.label) || !ReadValue(fs, import.index) ||
+                            !ReadValue(fs, import.line) || !ReadValue(fs, import.cur))
+                            return AssemblerStatus::ReadError;
+                    }
+                    break;
+                case blend::NATIVE_IMPORT_SECTION_INDIC:
+                    res.nativeImports.resize(size);
+                    for (auto& import : res.nativeImports)
+                    {
+                        if (!ReadString(fs, import.library) || !ReadString(fs, import.symbol) ||
+                            !ReadString(fs, import.signature))
+                            return AssemblerStatus::ReadError;
+                    }
+                    break;
+                case blend::HOST_IMPORT_SECTION_INDIC:
+                    res.hostImports.resize(size);
+                    for (auto& name : res.hostImports)
+                    {
+                        if (!ReadString(fs, name))
+                            return AssemblerStatus::ReadError;
+                    }
+                    break;
+                default:
+                    return AssemblerStatus::ReadError;
+            }
+
+            if (!fs)
+                return AssemblerStatus::ReadError;
+        }
+
+        res.status = AssemblerStatus::Ok;
+        return AssemblerStatus::Ok;
+    }
+} // namespace relang::basm
@@ -0,0 +1,25 @@
+#ifndef BLEND_BASM_OBJECT_FILE_H
+#define BLEND_BASM_OBJECT_FILE_H
+
+#include <string>
+
+#include "Assembler.h"
+
+namespace relang::basm {
+    // Relocatable object files (.alo) produced for OutputType::Lib and consumed by blend-ld.
+    // After a magic header they use the same section layout as executables (data, bss, code)
+    // followed by the link sections below and the native and host import sections.
+    constexpr u32 OBJECT_FILE_MAGIC = 0x4F4C4100; // "\0ALO"
+    constexpr u8 LABEL_SECTION_INDIC = 0xFA;
+    constexpr u8 RELOCATION_SECTION_INDIC = 0xF9;
+    constexpr u8 IMPORT_SECTION_INDIC = 0xF8;
+
+    class ObjectFile
+    {
+    public:
+        static AssemblerStatus Write(const std::string& path, const AssemblerResult& res);
+        static AssemblerStatus Read(const std::string& path, AssemblerResult& res);
+    };
+} // namespace relang::basm
+
+#endif // BLEND_BASM_OBJECT_FILE_H
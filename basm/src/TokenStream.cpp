@@ -0,0 +1,36 @@
+#include "TokenStream.h"
+
+#include <algorithm>
+
+namespace relang::basm
+{
+    TokenStream::TokenStream(const TokenList& tokens)
+    {
+        Append(tokens);
+    }
+
+    void TokenStream::Append(std::span<const Token> tokens)
+    {
+        if (tokens.empty())
+            return;
+
+        m_Segments.push_back(tokens);
+        m_Offsets.push_back(m_Size);
+        m_Size += tokens.size();
+    }
+
+    const Token& TokenStream::operator[](const usize index) const noexcept
+    {
+        if (index >= m_Size)
+            return m_EndToken;
+
+        // Accesses are almost always close to the previous one so try the last segment first.
+        usize seg = m_LastSegment;
+        if (index < m_Offsets[seg] || index - m_Offsets[seg] >= m_Segments[seg].size())
+        {
+            seg = std::upper_bound(m_Offsets.begin(), m_Offsets.end(), index) - m_Offsets.begin() - 1;
+            m_LastSegment = seg;
+        }
+        return m_Segments[seg][index - m_Offsets[seg]];
+    }
+} // namespace relang::basm
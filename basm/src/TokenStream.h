@@ -0,0 +1,37 @@
+#ifndef BLEND_BASM_TOKEN_STREAM_H
+#define BLEND_BASM_TOKEN_STREAM_H
+
+#include <span>
+#include <vector>
+
+#include "Lexer.h"
+
+namespace relang::basm {
+    // A flat, random access view over token lists that live elsewhere (the main file and the
+    // cached tokens of included files). Appending a list only records a span, nothing is copied.
+    class TokenStream
+    {
+    private:
+        std::vector<std::span<const Token>> m_Segments;
+        std::vector<usize> m_Offsets;
+        usize m_Size = 0;
+        mutable usize m_LastSegment = 0;
+
+    private:
+        // Returned for reads past the end so lookaheads never run off the stream.
+        inline static const Token m_EndToken{};
+
+    public:
+        TokenStream() = default;
+        explicit TokenStream(const TokenList& tokens);
+
+    public:
+        inline usize GetSize() const noexcept { return m_Size; }
+
+    public:
+        void Append(std::span<const Token> tokens);
+        const Token& operator[](const usize index) const noexcept;
+    };
+} // namespace relang::basm
+
+#endif // BLEND_BASM_TOKEN_STREAM_H
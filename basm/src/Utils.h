@@ -2,28 +2,43 @@
 #define BLEND_BASM_UTILS_H
 
 #include <sdafx.h>
+#include <string_view>
 
 namespace relang::basm::utils {
+	// Transparent hasher so string keyed maps can be queried with std::string_view without allocating.
+	struct StringHash
+	{
+		using is_transparent = void;
+
+		inline usize operator()(const std::string_view str) const noexcept
+		{
+			return std::hash<std::string_view>{}(str);
+		}
+	};
+
+	template <typename T>
+	using StringMap = std::unordered_map<std::string, T, StringHash, std::equal_to<>>;
+
 	namespace string {
 		inline std::vector<u8> ToBytes(std::string&& str)
 		{
 			return std::vector<u8>(str.begin(), str.end());
 		}
 
-		inline std::vector<u8> ToBytes(const std::string& str)
+		inline std::vector<u8> ToBytes(const std::string_view str)
 		{
 			return std::vector<u8>(str.begin(), str.end());
 		}
 
-		inline std::string ToLowerCopy(const std::string& str)
+		inline std::string ToLowerCopy(const std::string_view str)
 		{
-			std::string low_str = str;
+			std::string low_str{str};
 			std::for_each(low_str.begin(), low_str.end(), [](char& c) { c = std::tolower(c); });
 			return low_str;
 		}
-		inline std::string ToUpperCopy(const std::string& str)
+		inline std::string ToUpperCopy(const std::string_view str)
 		{
-			std::string upper_str = str;
+			std::string upper_str{str};
 			std::for_each(upper_str.begin(), upper_str.end(), [](char& c) { c = std::toupper(c); });
 			return upper_str;
 		}
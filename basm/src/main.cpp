@@ -1,5 +1,10 @@
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <thread>
 #include <vector>
 
 #include "../include/BASM.h"
@@ -129,10 +134,10 @@ void DumpIntermediate(const relang::blend::InstructionList& code, const std::opt
                     switch (inst.opcode)
                     {
                         case relang::blend::OpCode::PInt:
-                        case relang::blend::OpCode::Enter:
                         case relang::blend::OpCode::SConio:
                         case relang::blend::OpCode::Push:
                         case relang::blend::OpCode::Call:
+                        case relang::blend::OpCode::TailCall:
                         case relang::blend::OpCode::Jz:
                         case relang::blend::OpCode::Jnz:
                         case relang::blend::OpCode::Js:
@@ -155,6 +160,7 @@ void DumpIntermediate(const relang::blend::InstructionList& code, const std::opt
                     }
                 }
             }
+            relang::blend::PrintMaskOperands(fs, inst);
             fs << "\n";
         }
     }
@@ -270,10 +276,10 @@ void DumpIntermediate(const relang::blend::InstructionList& code, const std::opt
                     {
                         case relang::blend::OpCode::PInt:
                         case relang::blend::OpCode::PChr:
-                        case relang::blend::OpCode::Enter:
                         case relang::blend::OpCode::SConio:
                         case relang::blend::OpCode::Push:
                         case relang::blend::OpCode::Call:
+                        case relang::blend::OpCode::TailCall:
                         case relang::blend::OpCode::Jz:
                         case relang::blend::OpCode::Jnz:
                         case relang::blend::OpCode::Js:
@@ -296,11 +302,90 @@ void DumpIntermediate(const relang::blend::InstructionList& code, const std::opt
                     }
                 }
             }
+            relang::blend::PrintMaskOperands(std::cout, inst);
             std::cout << "\n";
         }
     }
 }
 
+int AssembleAndLink(const std::vector<std::string>& input_filepaths, const std::vector<std::string>& object_filepaths,
+                    const usize jobs, const std::string& output_filepath, const bool intermediate)
+{
+    using namespace relang::basm;
+
+    // Every file is its own unit with its own assembler, so they can be assembled side by side
+    // and stitched together by the linker afterwards. Object files are linked in as they are.
+    static const std::string in_memory;
+    std::vector<AssemblerResult> units(input_filepaths.size());
+    std::atomic<usize> next_unit = 0;
+    const auto worker = [&]()
+    {
+        for (usize i = next_unit++; i < input_filepaths.size(); i = next_unit++)
+        {
+            if (std::filesystem::path(input_filepaths[i]).extension() == ".alo")
+            {
+                if (ObjectFile::Read(input_filepaths[i], units[i]) != AssemblerStatus::Ok)
+                {
+                    std::cerr << "Error: " << input_filepaths[i] << " is not a valid object file.\n";
+                    units[i].status = AssemblerStatus::ReadError;
+                }
+                continue;
+            }
+
+            std::ifstream fs(input_filepaths[i]);
+            if (!fs.is_open())
+            {
+                std::cerr << "Error: Couldn't open file " << input_filepaths[i] << " for reading.\n";
+                units[i].status = AssemblerStatus::ReadError;
+                continue;
+            }
+
+            AssemblerOptions opt =
+            {
+                    .type = OutputType::Lib,
+                    .source = &fs,
+                    .path = (object_filepaths.empty()) ? in_memory : object_filepaths[i],
+                    .dir = std::filesystem::path(input_filepaths[i]).parent_path()
+            };
+            Assembler assembler;
+            units[i] = assembler.Assemble(opt);
+            if (units[i].status == AssemblerStatus::WriteError)
+                std::cerr << "Error: Couldn't open file " << opt.path << " for writing.\n";
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (usize i = 1; i < std::min(jobs, input_filepaths.size()); ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+
+    for (const auto& unit : units)
+    {
+        if (unit.status != AssemblerStatus::Ok)
+            return -2;
+    }
+
+    // Compile only, the units are linked later on by blend-ld.
+    if (!object_filepaths.empty())
+        return 0;
+
+    auto link_result = Linker::Link(units, input_filepaths);
+    if (link_result.status != AssemblerStatus::Ok)
+        return -2;
+
+    if (Assembler::WriteToBinary(output_filepath, link_result) != AssemblerStatus::Ok)
+    {
+        std::cerr << "Error: Couldn't open file " << output_filepath << " for writing.\n";
+        return -2;
+    }
+
+    if (intermediate)
+        DumpIntermediate(link_result.assembledCode, output_filepath + ".int");
+    return 0;
+}
+
 int main(const int argc, const char* argv[])
 {
     using namespace relang;
@@ -308,8 +393,11 @@ int main(const int argc, const char* argv[])
 
     std::string output_filepath;
     std::string input_filepath;
+    std::vector<std::string> input_filepaths;
+    usize jobs = std::max(std::thread::hardware_concurrency(), 1u);
     bool intermediate = false;
     bool disassemble = false;
+    bool compile_only = false;
     if (argc > 1)
     {
         for (int i = 1; i < argc; ++i)
@@ -326,13 +414,37 @@ int main(const int argc, const char* argv[])
             {
                 disassemble = true;
             }
+            else if (std::strcmp(argv[i], "-c") == 0)
+            {
+                compile_only = true;
+            }
+            else if (std::strcmp(argv[i], "-j") == 0)
+            {
+                jobs = std::max(std::stoul(argv[++i]), 1ul);
+            }
             else
             {
                 // Must be a file name, hopefully.
-                input_filepath = argv[i];
+                input_filepaths.push_back(argv[i]);
             }
         }
 
+        if (input_filepaths.empty())
+        {
+            std::cerr << "Error: No input files.\n";
+            return -1;
+        }
+        input_filepath = input_filepaths.front();
+
+        std::vector<std::string> object_filepaths;
+        if (compile_only)
+        {
+            for (const auto& path : input_filepaths)
+                object_filepaths.push_back(std::filesystem::path(path).replace_extension(".alo").string());
+            if (object_filepaths.size() == 1 && !output_filepath.empty())
+                object_filepaths.front() = output_filepath;
+        }
+
         if (output_filepath.empty())
         {
             output_filepath = input_filepath;
@@ -343,6 +455,11 @@ int main(const int argc, const char* argv[])
             }
         }
 
+        const bool has_objects = std::any_of(input_filepaths.begin(), input_filepaths.end(), [](const std::string& path)
+                                             { return std::filesystem::path(path).extension() == ".alo"; });
+        if ((input_filepaths.size() > 1 || compile_only || has_objects) && !disassemble)
+            return AssembleAndLink(input_filepaths, object_filepaths, jobs, output_filepath, intermediate);
+
         std::ifstream fs(input_filepath);
 
         if (fs.is_open())
@@ -368,6 +485,19 @@ int main(const int argc, const char* argv[])
                             fs.read((char*)data_section.data(), size);
                             break;
                         }
+                        case blend::BSS_SECTION_INDIC:
+                        {
+                            // Only the size is stored, there's nothing to skip past it.
+                            fs.read((char*)&size, sizeof(usize));
+                            break;
+                        }
+                        case blend::LINE_TABLE_SECTION_INDIC:
+                        {
+                            // The rows are of no use for disassembling, the size is in bytes like the loader expects.
+                            fs.read((char*)&size, sizeof(usize));
+                            fs.seekg(size, fs.cur);
+                            break;
+                        }
                         case blend::CODE_SECTION_INDIC:
                         {
                             fs.read((char*)&size, sizeof(usize));
@@ -375,22 +505,35 @@ int main(const int argc, const char* argv[])
                             fs.read((char*)code_section.data(), size);
                             break;
                         }
+                        case blend::NATIVE_IMPORT_SECTION_INDIC:
+                        case blend::HOST_IMPORT_SECTION_INDIC:
+                        {
+                            // Three strings per native import, one per host import.
+                            fs.read((char*)&size, sizeof(usize));
+                            for (usize i = 0; i < size * ((byte == blend::NATIVE_IMPORT_SECTION_INDIC) ? 3 : 1); ++i)
+                            {
+                                u32 length = 0;
+                                fs.read((char*)&length, sizeof(u32));
+                                fs.seekg(length, fs.cur);
+                            }
+                            break;
+                        }
                     }
                 }
                 DumpIntermediate(code_section, std::nullopt);
                 fs.close();
                 return EXIT_SUCCESS;
             }
-            std::string src_code = std::string(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
-            auto tk_list = relang::basm::Lexer::Start(src_code);
             AssemblerOptions opt =
             {
                     .type = OutputType::XBin,
-                    .tokens = tk_list,
-                    .path = output_filepath
+                    .source = &fs,
+                    .path = output_filepath,
+                    .dir = std::filesystem::path(input_filepath).parent_path()
             };
 
-            auto asmblr_result = Assembler::Assemble(opt);
+            Assembler assembler;
+            auto asmblr_result = assembler.Assemble(opt);
             if (asmblr_result.status == AssemblerStatus::Ok)
             {
                 if (intermediate)
@@ -0,0 +1,54 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <BASM.h>
+
+int main(const int argc, const char* argv[])
+{
+    using namespace relang;
+    using namespace relang::basm;
+
+    std::string output_filepath = "a.alc";
+    std::vector<std::string> input_filepaths;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            output_filepath = argv[++i];
+        }
+        else
+        {
+            // Must be an object file, hopefully.
+            input_filepaths.push_back(argv[i]);
+        }
+    }
+
+    if (input_filepaths.empty())
+    {
+        std::cerr << "Error: No input files.\n";
+        return -1;
+    }
+
+    std::vector<AssemblerResult> units(input_filepaths.size());
+    for (usize i = 0; i < input_filepaths.size(); ++i)
+    {
+        if (ObjectFile::Read(input_filepaths[i], units[i]) != AssemblerStatus::Ok)
+        {
+            std::cerr << "Error: " << input_filepaths[i] << " is not a valid object file.\n";
+            return -2;
+        }
+    }
+
+    auto res = Linker::Link(units, input_filepaths);
+    if (res.status != AssemblerStatus::Ok)
+        return -2;
+
+    if (Assembler::WriteToBinary(output_filepath, res) != AssemblerStatus::Ok)
+    {
+        std::cerr << "Error: Couldn't open file " << output_filepath << " for writing.\n";
+        return -2;
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+#ifndef BLEND_HOST_FUNCTION_H
+#define BLEND_HOST_FUNCTION_H
+
+#include <sdafx.h>
+
+#include <bit>
+
+#include "Register.h"
+
+namespace relang::blend
+{
+    using HostThunk = u64 (*)(void* callable, Registers& regs);
+
+    // A C++ callable exposed to guest code under a name, called through hostcall.
+    struct HostFunction
+    {
+        std::string name;
+        HostThunk thunk = nullptr;
+        std::shared_ptr<void> callable;
+    };
+
+    // What a hostcall index refers to once the program is bound, no name left to look up.
+    struct BoundHostFunction
+    {
+        HostThunk thunk = nullptr;
+        void* callable = nullptr;
+    };
+
+    namespace host
+    {
+        template <typename T>
+        concept RegisterValue = std::is_arithmetic_v<T> || std::is_pointer_v<T>;
+
+        template <RegisterValue T>
+        inline T FromRegister(const uintptr value) noexcept
+        {
+            if constexpr (std::is_same_v<T, bool>)
+                return value != 0;
+            else if constexpr (std::is_same_v<T, double>)
+                return std::bit_cast<double>((u64)value);
+            else if constexpr (std::is_same_v<T, float>)
+                return (float)std::bit_cast<double>((u64)value);
+            else
+                return (T)value;
+        }
+
+        template <RegisterValue T>
+        inline uintptr ToRegister(const T value) noexcept
+        {
+            if constexpr (std::is_floating_point_v<T>)
+                return (uintptr)std::bit_cast<u64>((double)value);
+            else
+                return (uintptr)value;
+        }
+
+        template <typename T>
+        struct Signature : Signature<decltype(&T::operator())>
+        {
+        };
+
+        template <typename R, typename... Args>
+        struct Signature<R (*)(Args...)>
+        {
+            using Return = R;
+            using Arguments = std::tuple<Args...>;
+        };
+
+        template <typename C, typename R, typename... Args>
+        struct Signature<R (C::*)(Args...)> : Signature<R (*)(Args...)>
+        {
+        };
+
+        template <typename C, typename R, typename... Args>
+        struct Signature<R (C::*)(Args...) const> : Signature<R (*)(Args...)>
+        {
+        };
+
+        template <typename R, typename... Args>
+        struct Signature<R (*)(Args...) noexcept> : Signature<R (*)(Args...)>
+        {
+        };
+
+        template <typename C, typename R, typename... Args>
+        struct Signature<R (C::*)(Args...) noexcept> : Signature<R (*)(Args...)>
+        {
+        };
+
+        template <typename C, typename R, typename... Args>
+        struct Signature<R (C::*)(Args...) const noexcept> : Signature<R (*)(Args...)>
+        {
+        };
+
+        // Arguments are read straight out of %r0 onwards and the result is written to %r0, a void function leaves
+        // %r0 as it was.
+        template <typename F, typename R, typename... Args, usize... Is>
+        u64 Invoke(void* callable, Registers& regs, std::tuple<Args...>*, std::index_sequence<Is...>)
+        {
+            static_assert(sizeof...(Args) <= RegType::R31 + 1, "Host functions take their arguments from %r0-%r31.");
+            auto& fn = *(F*)callable;
+            if constexpr (std::is_void_v<R>)
+            {
+                fn(FromRegister<std::decay_t<Args>>(regs[RegType::R0 + Is])...);
+                return regs[RegType::R0];
+            }
+            else
+            {
+                return ToRegister(fn(FromRegister<std::decay_t<Args>>(regs[RegType::R0 + Is])...));
+            }
+        }
+
+        template <typename F>
+        u64 Thunk(void* callable, Registers& regs)
+        {
+            using Sig = Signature<F>;
+            using Arguments = typename Sig::Arguments;
+            return Invoke<F, typename Sig::Return>(callable, regs, (Arguments*)nullptr,
+                                                   std::make_index_sequence<std::tuple_size_v<Arguments>>{});
+        }
+    } // namespace host
+} // namespace relang::blend
+
+#endif // BLEND_HOST_FUNCTION_H
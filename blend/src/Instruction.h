@@ -74,7 +74,22 @@ namespace relang::blend
 
             SConio,
             DumpFlags,
-            Nop
+            Nop,
+
+            HostCall,
+            SyscallV,
+            Clock,
+            Rdtsc,
+            Sleep,
+            Spawn,
+            Shell,
+            PollKey,
+            Present,
+            Pushm,
+            Popm,
+            LeaveRet,
+            Jtab,
+            TailCall
         };
 
     private:
@@ -176,11 +191,68 @@ namespace relang::blend
                 // Temporary instructions
                 "sconio",
                 "_dbg_dumpflags",
-                "nop"};
+                "nop",
+
+                "hostcall",
+                "syscallv",
+                "clock",
+                "rdtsc",
+                "sleep",
+                "spawn",
+                "shell",
+                "pollkey",
+                "present",
+                "pushm",
+                "popm",
+                "leaveret",
+                "jtab",
+                "tcall"};
     };
 
     using InstructionList = std::vector<Instruction>;
 
+    // Writes the registers set in mask as assembly operands, first says whether they open the operand list.
+    inline void PrintRegisterMask(std::ostream& os, const u64 mask, bool first)
+    {
+        for (u8 r = RegType::R0; r <= RegType::R31; ++r)
+        {
+            if (mask & (u64{1} << r))
+            {
+                os << ((first) ? " %" : ", %") << Register::RegisterStr[r];
+                first = false;
+            }
+        }
+    }
+
+    // Writes the operands the disassemblers can't tell from sreg and dreg: the register masks of enter, leave,
+    // leaveret, pushm, popm and tcall, the frame size of enter and the table jtab reads from the data section.
+    inline void PrintMaskOperands(std::ostream& os, const Instruction& inst)
+    {
+        switch (inst.opcode)
+        {
+            case OpCode::Enter:
+                os << " $0x" << inst.imm64;
+                PrintRegisterMask(os, (u32)inst.disp, false);
+                break;
+            case OpCode::Leave:
+            case OpCode::LeaveRet:
+                PrintRegisterMask(os, (u32)inst.disp, true);
+                break;
+            case OpCode::Pushm:
+            case OpCode::Popm:
+                PrintRegisterMask(os, inst.imm64, true);
+                break;
+            case OpCode::TailCall:
+                PrintRegisterMask(os, (u32)inst.disp, false);
+                break;
+            case OpCode::Jtab:
+                os << ", +0x" << inst.disp << "(%ds)";
+                break;
+            default:
+                break;
+        }
+    }
+
 } // namespace relang::blend
 
 #endif // BLEND_INSTRUCTION_H
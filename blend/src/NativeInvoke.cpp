@@ -0,0 +1,154 @@
+#include "NativeInvoke.h"
+
+#include <bit>
+
+namespace relang::blend
+{
+    namespace
+    {
+        enum class NativeReturn : u8
+        {
+            Int,
+            Double,
+            Void
+        };
+
+        template <usize>
+        using IntArg = u64;
+        template <usize>
+        using DoubleArg = double;
+
+        template <NativeReturn R, usize... Is, usize... Ds>
+        u64 Invoke(const NativeFunction& fn, Registers& regs, std::index_sequence<Is...>, std::index_sequence<Ds...>)
+        {
+            using Ret = std::conditional_t<R == NativeReturn::Int, u64, std::conditional_t<R == NativeReturn::Double, double, void>>;
+            const auto target = (Ret(*)(IntArg<Is>..., DoubleArg<Ds>...))fn.address;
+            if constexpr (R == NativeReturn::Void)
+            {
+                target(regs[fn.intArgs[Is]]..., std::bit_cast<double>((u64)regs[fn.doubleArgs[Ds]])...);
+                return regs[RegType::R0];
+            }
+            else
+            {
+                return std::bit_cast<u64>(target(regs[fn.intArgs[Is]]..., std::bit_cast<double>((u64)regs[fn.doubleArgs[Ds]])...));
+            }
+        }
+
+        template <usize I, usize D, NativeReturn R>
+        u64 Trampoline(const NativeFunction& fn, Registers& regs)
+        {
+            return Invoke<R>(fn, regs, std::make_index_sequence<I>{}, std::make_index_sequence<D>{});
+        }
+
+        // One trampoline per integer count, double count and return kind, indexed by TrampolineIndex().
+        constexpr usize RETURN_KINDS = 3;
+
+        constexpr usize TrampolineIndex(const usize ints, const usize doubles, const NativeReturn ret) noexcept
+        {
+            return (ints * (NATIVE_MAX_DOUBLE_ARGS + 1) + doubles) * RETURN_KINDS + (usize)ret;
+        }
+
+        template <usize... Ns>
+        constexpr auto MakeTrampolines(std::index_sequence<Ns...>)
+        {
+            return std::array<NativeTrampoline, sizeof...(Ns)>{
+                &Trampoline<Ns / RETURN_KINDS / (NATIVE_MAX_DOUBLE_ARGS + 1), Ns / RETURN_KINDS % (NATIVE_MAX_DOUBLE_ARGS + 1),
+                            (NativeReturn)(Ns % RETURN_KINDS)>...};
+        }
+
+        constexpr auto TRAMPOLINES = MakeTrampolines(
+            std::make_index_sequence<(NATIVE_MAX_INT_ARGS + 1) * (NATIVE_MAX_DOUBLE_ARGS + 1) * RETURN_KINDS>{});
+
+        // Fills in the argument maps and picks the trampoline, false if the signature can't be called.
+        bool ParseSignature(const std::string& signature, NativeFunction& fn)
+        {
+            const usize end = signature.find(')');
+            if (end == std::string::npos || end + 2 != signature.size())
+                return false;
+
+            usize ints = 0;
+            usize doubles = 0;
+            for (usize i = 0; i < end; ++i)
+            {
+                const u8 reg = (u8)(RegType::R0 + i);
+                switch (signature[i])
+                {
+                    case 'i':
+                        if (ints == NATIVE_MAX_INT_ARGS)
+                            return false;
+                        fn.intArgs[ints++] = reg;
+                        break;
+                    case 'd':
+                        if (doubles == NATIVE_MAX_DOUBLE_ARGS)
+                            return false;
+                        fn.doubleArgs[doubles++] = reg;
+                        break;
+                    default:
+                        return false;
+                }
+            }
+
+            NativeReturn ret;
+            switch (signature[end + 1])
+            {
+                case 'i': ret = NativeReturn::Int; break;
+                case 'd': ret = NativeReturn::Double; break;
+                case 'v': ret = NativeReturn::Void; break;
+                default: return false;
+            }
+            fn.trampoline = TRAMPOLINES[TrampolineIndex(ints, doubles, ret)];
+            return true;
+        }
+    } // namespace
+
+    NativeImportTable::~NativeImportTable()
+    {
+#if defined(__APPLE__) || defined(__linux__)
+        for (const auto& [path, handle] : m_Libraries)
+            dlclose(handle);
+#endif
+    }
+
+    bool NativeImportTable::Resolve(const std::vector<NativeImport>& imports)
+    {
+        m_Functions.resize(imports.size());
+        for (usize i = 0; i < imports.size(); ++i)
+        {
+            const auto& import = imports[i];
+            auto& fn = m_Functions[i];
+            if (!ParseSignature(import.signature, fn))
+            {
+                std::cerr << "Runtime Error: Invalid signature '" << import.signature << "' for native function '"
+                          << import.symbol << "'.\n";
+                return false;
+            }
+
+#if defined(__APPLE__) || defined(__linux__)
+            auto [it, inserted] = m_Libraries.try_emplace(import.library, nullptr);
+            if (inserted)
+            {
+                it->second = dlopen((import.library.empty()) ? nullptr : import.library.c_str(), RTLD_NOW);
+                if (!it->second)
+                {
+                    std::cerr << "Runtime Error: Couldn't load native library '" << import.library << "': " << dlerror()
+                              << "\n";
+                    m_Libraries.erase(it);
+                    return false;
+                }
+            }
+
+            fn.address = dlsym(it->second, import.symbol.c_str());
+            if (!fn.address)
+            {
+                std::cerr << "Runtime Error: Couldn't find native function '" << import.symbol << "' in '"
+                          << import.library << "'.\n";
+                return false;
+            }
+#else
+            std::cerr << "Runtime Error: Native calls are not yet supported on your platform.\n";
+            return false;
+#endif
+        }
+        return true;
+    }
+} // namespace relang::blend
@@ -0,0 +1,66 @@
+#ifndef BLEND_NATIVE_INVOKE_H
+#define BLEND_NATIVE_INVOKE_H
+
+#include <sdafx.h>
+
+#include "Register.h"
+
+namespace relang::blend
+{
+    // Arguments beyond these would be passed on the native stack, which invokec doesn't do.
+    constexpr usize NATIVE_MAX_INT_ARGS = 6;
+    constexpr usize NATIVE_MAX_DOUBLE_ARGS = 8;
+
+    // A native function called through invokec, as listed in the program's native import section.
+    // The signature lists the arguments, taken from %r0 onwards, then the return value that is put in %r0:
+    //   i - a 64 bit integer or a pointer
+    //   d - a double, its bit pattern is what the register holds
+    //   v - nothing, only as the return type
+    // e.g. "id)d". Variadic functions are not supported.
+    struct NativeImport
+    {
+        // Empty for the VM itself and the libraries it's linked against.
+        std::string library;
+        std::string symbol;
+        std::string signature;
+    };
+
+    struct NativeFunction;
+    using NativeTrampoline = u64 (*)(const NativeFunction& fn, Registers& regs);
+
+    // An import resolved at load time. Integer and double arguments are passed in separate registers natively,
+    // so the trampoline only depends on how many of each there are while the order is kept in the argument maps.
+    struct NativeFunction
+    {
+        void* address = nullptr;
+        NativeTrampoline trampoline = nullptr;
+        // Register each argument is taken from.
+        std::array<u8, NATIVE_MAX_INT_ARGS> intArgs{};
+        std::array<u8, NATIVE_MAX_DOUBLE_ARGS> doubleArgs{};
+    };
+
+    class NativeImportTable
+    {
+    private:
+        std::unordered_map<std::string, void*> m_Libraries;
+        std::vector<NativeFunction> m_Functions;
+
+    public:
+        NativeImportTable() = default;
+        NativeImportTable(const NativeImportTable&) = delete;
+        NativeImportTable& operator=(const NativeImportTable&) = delete;
+        ~NativeImportTable();
+
+    public:
+        inline const NativeFunction& operator[](const usize index) const noexcept
+        {
+            return m_Functions[index];
+        }
+
+    public:
+        // Loads every library and looks every symbol up once, reports the first failure.
+        bool Resolve(const std::vector<NativeImport>& imports);
+    };
+} // namespace relang::blend
+
+#endif // BLEND_NATIVE_INVOKE_H
@@ -0,0 +1,157 @@
+#include "Process.h"
+
+#if defined(__APPLE__) || defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace relang::blend
+{
+#if defined(__APPLE__) || defined(__linux__)
+    namespace
+    {
+        // Takes a command per line from fd 3 and answers with its exit status on the same descriptor, which the
+        // command itself doesn't get to see.
+        constexpr const char* WORKER_SCRIPT =
+            "while IFS= read -r c <&3; do eval \"$c\" 3<&-; printf '%d\\n' \"$?\" >&3; done";
+
+#if defined(MSG_NOSIGNAL)
+        constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+        constexpr int SEND_FLAGS = 0;
+#endif
+
+        int Wait(const pid_t pid) noexcept
+        {
+            int status;
+            while (waitpid(pid, &status, 0) == -1)
+            {
+                if (errno != EINTR)
+                    return -1;
+            }
+            return status;
+        }
+    } // namespace
+#endif
+
+    int SpawnProcess(const char* const* argv)
+    {
+#if defined(__APPLE__) || defined(__linux__)
+        // Whatever the program printed so far has to come out before the child's output.
+        std::fflush(stdout);
+        pid_t pid;
+        if (posix_spawnp(&pid, argv[0], nullptr, nullptr, (char* const*)argv, environ) != 0)
+            return -1;
+        return Wait(pid);
+#else
+        return -1;
+#endif
+    }
+
+    CommandWorker::~CommandWorker()
+    {
+        Stop();
+    }
+
+    int CommandWorker::Run(const char* command)
+    {
+#if defined(__APPLE__) || defined(__linux__)
+        if (std::strchr(command, '\n') || (m_Pid == -1 && !Start()))
+            return std::system(command);
+
+        std::fflush(stdout);
+        std::string line = command;
+        line += '\n';
+        for (usize sent = 0; sent < line.size();)
+        {
+            const ssize_t n = send(m_Fd, line.data() + sent, line.size() - sent, SEND_FLAGS);
+            if (n < 0 && errno == EINTR)
+                continue;
+            // The worker is gone and never saw the command.
+            if (n < 0)
+            {
+                Stop();
+                return std::system(command);
+            }
+            sent += (usize)n;
+        }
+
+        char reply[16];
+        usize length = 0;
+        while (length == 0 || reply[length - 1] != '\n')
+        {
+            const ssize_t n = recv(m_Fd, reply + length, sizeof(reply) - 1 - length, 0);
+            if (n < 0 && errno == EINTR)
+                continue;
+            // The command ended the shell itself, e.g. with exit.
+            if (n <= 0 || length + n == sizeof(reply) - 1)
+                return Stop();
+            length += (usize)n;
+        }
+        reply[length] = '\0';
+        return (std::atoi(reply) & 0xff) << 8;
+#else
+        return std::system(command);
+#endif
+    }
+
+    bool CommandWorker::Start()
+    {
+#if defined(__APPLE__) || defined(__linux__)
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+            return false;
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+#if defined(__APPLE__)
+        const int one = 1;
+        setsockopt(fds[0], SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, fds[1], 3);
+        if (fds[1] != 3)
+            posix_spawn_file_actions_addclose(&actions, fds[1]);
+
+        const char* argv[] = {"sh", "-c", WORKER_SCRIPT, nullptr};
+        pid_t pid;
+        const int err = posix_spawn(&pid, "/bin/sh", &actions, nullptr, (char* const*)argv, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(fds[1]);
+        if (err != 0)
+        {
+            close(fds[0]);
+            return false;
+        }
+
+        m_Pid = pid;
+        m_Fd = fds[0];
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    int CommandWorker::Stop()
+    {
+#if defined(__APPLE__) || defined(__linux__)
+        if (m_Pid == -1)
+            return -1;
+
+        // The shell's read fails once its end of the socket is closed and the loop ends.
+        close(m_Fd);
+        const int status = Wait(m_Pid);
+        m_Pid = -1;
+        m_Fd = -1;
+        return status;
+#else
+        return -1;
+#endif
+    }
+} // namespace relang::blend
@@ -0,0 +1,37 @@
+#ifndef BLEND_PROCESS_H
+#define BLEND_PROCESS_H
+
+#include <sdafx.h>
+
+namespace relang::blend
+{
+    // Runs argv[0], looked up in PATH, with the VM's stdio and waits for it without going through a shell.
+    // Returns the wait status like std::system does, -1 if it couldn't be started.
+    int SpawnProcess(const char* const* argv);
+
+    // A /bin/sh kept running next to the VM, fed one command line at a time over a socket. A command only costs what
+    // the shell does with it instead of a whole new shell, builtins don't even fork. State like the working
+    // directory carries over from one command to the next.
+    class CommandWorker
+    {
+    private:
+        int m_Pid = -1;
+        int m_Fd = -1;
+
+    public:
+        CommandWorker() = default;
+        CommandWorker(const CommandWorker&) = delete;
+        CommandWorker& operator=(const CommandWorker&) = delete;
+        ~CommandWorker();
+
+    public:
+        // Same result as std::system, which it falls back to if the worker can't take the command.
+        int Run(const char* command);
+
+    private:
+        bool Start();
+        int Stop();
+    };
+} // namespace relang::blend
+
+#endif // BLEND_PROCESS_H
@@ -1,6 +1,14 @@
 #include "Runtime.h"
 #include "Instruction.h"
 
+#include <bit>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 using namespace relang;
 
 #define ResetFlags() \
@@ -118,13 +126,18 @@ using namespace relang;
 
 namespace relang::blend
 {
-    Blend::Blend(const std::vector<u8>& data, const usize bssSize)
-        : m_Stack(data), m_Sp(m_Registers[RegType::SP]), m_BssSize(bssSize)
+    Blend::Blend(const std::vector<u8>& data, const usize bssSize, const std::vector<NativeImport>& nativeImports,
+                 std::vector<std::string> hostImports)
+        : m_Stack(data), m_Sp(m_Registers[RegType::SP]), m_BssSize(bssSize), m_CallStack(CALL_STACK_SIZE),
+          m_HostImportNames(std::move(hostImports))
     {
+        if (!m_NativeImports.Resolve(nativeImports))
+            std::exit(-1);
+
         m_Stack.resize(m_Stack.size() + STACK_SIZE + m_BssSize);
 
-        // Init registers
-        m_Registers[RegType::SS] = (uintptr)(m_Stack.data() + data.size());
+        // Init registers, the assemblers hand BSS addresses out right after the data section so the stack goes last.
+        m_Registers[RegType::SS] = (uintptr)(m_Stack.data() + data.size() + m_BssSize);
         m_Registers[RegType::SP] = m_Registers[RegType::SS] + STACK_SIZE;
         m_Registers[RegType::DS] = (uintptr)m_Stack.data();
     }
@@ -133,15 +146,37 @@ namespace relang::blend
     {
         m_Bytecode = ((std::vector<Instruction>&)code).data();
         m_Pc = m_Bytecode;
+        m_CodeSize = code.size();
+        m_CallTop = m_CallStack.data();
 
         m_Registers[RegType::CS] = (uintptr)m_Bytecode;
 
+        if (!BindHostFunctions())
+            std::exit(-1);
+
         while (m_Pc)
             (this->*m_Instructions[(usize)m_Pc->opcode])();
 
         result = m_Registers[RegType::R0];
     }
 
+    bool Blend::BindHostFunctions()
+    {
+        m_HostImports.clear();
+        for (const auto& name : m_HostImportNames)
+        {
+            auto it = std::find_if(m_HostFunctions.begin(), m_HostFunctions.end(),
+                                   [&name](const HostFunction& f) { return f.name == name; });
+            if (it == m_HostFunctions.end())
+            {
+                std::cerr << "Runtime Error: No host function named '" << name << "' was registered.\n";
+                return false;
+            }
+            m_HostImports.push_back(BoundHostFunction{.thunk = it->thunk, .callable = it->callable.get()});
+        }
+        return true;
+    }
+
     void Blend::Nop()
     {
         m_Pc++;
@@ -529,39 +564,99 @@ namespace relang::blend
 
     void Blend::Jump()
     {
-        if (m_Pc->sreg != RegType::NUL)
-            m_Pc = m_Bytecode + m_Registers[m_Pc->sreg];
-        else
+        if (m_Pc->sreg == RegType::NUL)
+        {
             m_Pc = m_Bytecode + m_Pc->imm64;
+            return;
+        }
+
+        JumpTo(m_Registers[m_Pc->sreg]);
+    }
+
+    void Blend::JumpTo(const u64 target)
+    {
+        if (target >= m_CodeSize)
+        {
+            std::cerr << "Runtime Error: Jump to 0x" << std::hex << target << std::dec << " outside of the code.\n";
+            std::exit(-1);
+        }
+        m_Pc = m_Bytecode + target;
+    }
+
+    void Blend::JumpTable()
+    {
+        // The table sits in the data section, a count followed by that many instruction indices. Indices past its
+        // end fall through to the next instruction, which is where the default case goes.
+        const auto* table = (const u64*)(m_Registers[RegType::DS] + m_Pc->disp);
+        const u64 index = m_Registers[m_Pc->sreg];
+        if (index < table[0])
+            JumpTo(table[1 + index]);
+        else
+            m_Pc++;
     }
 
     void Blend::Enter()
     {
+        // disp optionally carries the callee saved registers so the whole prologue is a single instruction.
         Push64(m_Registers[RegType::BP]);
         m_Registers[RegType::BP] = m_Registers[RegType::SP];
         m_Registers[RegType::SP] -= m_Pc->imm64;
+        SaveRegisters((u32)m_Pc->disp);
         m_Pc++;
     }
 
     void Blend::Call()
     {
-        Push64((uintptr)(1 + m_Pc));
+        if (m_CallTop == m_CallStack.data() + CALL_STACK_SIZE)
+        {
+            std::cerr << "Runtime Error: Call stack overflow.\n";
+            std::exit(-1);
+        }
+        *m_CallTop++ = (u32)(1 + m_Pc - m_Bytecode);
         Jump();
     }
 
     void Blend::Return()
     {
-        Pop64(uintptr addr);
-        m_Pc = (Instruction*)addr;
+        if (m_CallTop == m_CallStack.data())
+        {
+            std::cerr << "Runtime Error: Return without a matching call.\n";
+            std::exit(-1);
+        }
+        m_Pc = m_Bytecode + *--m_CallTop;
     }
 
     void Blend::Leave()
     {
+        RestoreRegisters((u32)m_Pc->disp);
         m_Registers[RegType::SP] = m_Registers[RegType::BP];
         Pop64(m_Registers[RegType::BP]);
         m_Pc++;
     }
 
+    void Blend::LeaveReturn()
+    {
+        RestoreRegisters((u32)m_Pc->disp);
+        m_Registers[RegType::SP] = m_Registers[RegType::BP];
+        Pop64(m_Registers[RegType::BP]);
+        Return();
+    }
+
+    void Blend::TailCall()
+    {
+        // Tears the frame down like leaveret but jumps instead of returning, the callee returns to our caller. A register
+        // target is read first, restoring the registers or popping bp may overwrite it.
+        const Instruction* inst = m_Pc;
+        const u64 target = (inst->sreg == RegType::NUL) ? inst->imm64 : m_Registers[inst->sreg];
+        RestoreRegisters((u32)inst->disp);
+        m_Registers[RegType::SP] = m_Registers[RegType::BP];
+        Pop64(m_Registers[RegType::BP]);
+        if (inst->sreg == RegType::NUL)
+            m_Pc = m_Bytecode + target;
+        else
+            JumpTo(target);
+    }
+
     void Blend::Malloc()
     {
         // imm64, reg
@@ -694,6 +789,19 @@ namespace relang::blend
         m_Pc++;
     }
 
+    void Blend::Spawn()
+    {
+        // A null terminated array of pointers to the arguments, the program being the first one.
+        m_Registers[RegType::R4] = SpawnProcess((const char* const*)m_Registers[m_Pc->sreg]);
+        m_Pc++;
+    }
+
+    void Blend::Shell()
+    {
+        m_Registers[RegType::R4] = m_CommandWorker.Run((const char*)m_Registers[m_Pc->sreg]);
+        m_Pc++;
+    }
+
     void Blend::Syscall()
     {
 #if defined(__linux__)
@@ -712,8 +820,51 @@ namespace relang::blend
         m_Pc++;
     }
 
+    void Blend::SyscallV()
+    {
+        // %r0 points at an array of %r1 SyscallDescriptors, the number of failed calls ends up in %r0.
+        const auto batch = std::span((SyscallDescriptor*)m_Registers[RegType::R0], (usize)m_Registers[RegType::R1]);
+        m_Registers[RegType::R0] = m_SyscallBatch.Submit(batch);
+        m_Pc++;
+    }
+
+    void Blend::Clock()
+    {
+        // Monotonic nanoseconds, only meaningful as the difference between two reads.
+        const auto now = std::chrono::steady_clock::now().time_since_epoch();
+        m_Registers[m_Pc->sreg] = (uintptr)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+        m_Pc++;
+    }
+
+    void Blend::Rdtsc()
+    {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+        m_Registers[m_Pc->sreg] = (uintptr)__rdtsc();
+#elif defined(__aarch64__)
+        u64 ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        m_Registers[m_Pc->sreg] = (uintptr)ticks;
+#else
+        // No cycle counter to read, nanoseconds will have to do.
+        Clock();
+        return;
+#endif
+        m_Pc++;
+    }
+
+    void Blend::Sleep()
+    {
+        // In nanoseconds.
+        const u64 duration = (m_Pc->sreg != RegType::NUL) ? m_Registers[m_Pc->sreg] : m_Pc->imm64;
+        std::this_thread::sleep_for(std::chrono::nanoseconds(duration));
+        m_Pc++;
+    }
+
     void Blend::InvokeC()
     {
+        // Resolved when the program was loaded.
+        const auto& fn = m_NativeImports[m_Pc->imm64];
+        m_Registers[RegType::R0] = fn.trampoline(fn, m_Registers);
         m_Pc++;
     }
 
@@ -946,22 +1097,34 @@ namespace relang::blend
 
     void Blend::PushAllRegisters()
     {
-        for (u8 i = (u8)RegType::R0; i <= (u8)RegType::R31; ++i)
+        switch (m_Pc->size)
         {
-            switch (m_Pc->size)
-            {
-                case 8:
+            case 8:
+                for (u8 i = (u8)RegType::R0; i <= (u8)RegType::R31; ++i)
+                {
                     Push8(m_Registers[i]);
-                    break;
-                case 16:
+                }
+                break;
+            case 16:
+                for (u8 i = (u8)RegType::R0; i <= (u8)RegType::R31; ++i)
+                {
                     Push16(m_Registers[i]);
-                    break;
-                case 32:
+                }
+                break;
+            case 32:
+                for (u8 i = (u8)RegType::R0; i <= (u8)RegType::R31; ++i)
+                {
                     Push32(m_Registers[i]);
-                    break;
-                case 64:
-                    Push64(m_Registers[i]);
-                    break;
+                }
+                break;
+            case 64:
+            {
+                // Same layout as pushing %r0 to %r31 one by one, %r31 ends up on top at the lowest address.
+                m_Sp -= ((usize)RegType::R31 + 1) * sizeof(u64);
+                auto* dst = (u64*)m_Sp;
+                for (usize i = 0; i <= (usize)RegType::R31; ++i)
+                    dst[i] = m_Registers[RegType::R31 - i];
+                break;
             }
         }
         m_Pc++;
@@ -969,37 +1132,93 @@ namespace relang::blend
 
     void Blend::PopAllRegisters()
     {
-        for (u8 i = (u8)RegType::R31; i != 255; --i)
+        switch (m_Pc->size)
         {
-            switch (m_Pc->size)
-            {
-                case 8:
+            case 8:
+                for (u8 i = (u8)RegType::R31; i != 255; --i)
+                {
                     Pop8(m_Registers[i]);
-                    break;
-                case 16:
+                }
+                break;
+            case 16:
+                for (u8 i = (u8)RegType::R31; i != 255; --i)
+                {
                     Pop16(m_Registers[i]);
-                    break;
-                case 32:
+                }
+                break;
+            case 32:
+                for (u8 i = (u8)RegType::R31; i != 255; --i)
+                {
                     Pop32(m_Registers[i]);
-                    break;
-                case 64:
-                    Pop64(m_Registers[i]);
-                    break;
+                }
+                break;
+            case 64:
+            {
+                const auto* src = (const u64*)m_Sp;
+                for (usize i = 0; i <= (usize)RegType::R31; ++i)
+                    m_Registers[RegType::R31 - i] = src[i];
+                m_Sp += ((usize)RegType::R31 + 1) * sizeof(u64);
+                break;
             }
         }
         m_Pc++;
     }
 
+    void Blend::SaveRegisters(u64 mask)
+    {
+        // Highest register first so nothing has to count the bits up front, popcount is a libcall without -mpopcnt.
+        auto* dst = (u64*)m_Sp;
+        for (; mask; mask &= ~(u64{1} << (std::bit_width(mask) - 1)))
+            *--dst = m_Registers[std::bit_width(mask) - 1];
+        m_Sp = (uintptr)dst;
+    }
+
+    void Blend::RestoreRegisters(u64 mask)
+    {
+        const auto* src = (const u64*)m_Sp;
+        for (; mask; mask &= mask - 1)
+            m_Registers[std::countr_zero(mask)] = *src++;
+        m_Sp = (uintptr)src;
+    }
+
+    void Blend::PushRegisterMask()
+    {
+        // imm64 has a bit set for each of %r0-%r31 to save.
+        SaveRegisters(m_Pc->imm64 & 0xFFFFFFFF);
+        m_Pc++;
+    }
+
+    void Blend::PopRegisterMask()
+    {
+        RestoreRegisters(m_Pc->imm64 & 0xFFFFFFFF);
+        m_Pc++;
+    }
+
     void Blend::SetConioMode()
     {
-        if (m_Pc->imm64)
-        {
-            // utils::gterm::set_conio_terminal_mode();
-        }
-        else
-        {
-            // utils::gterm::reset_terminal_mode();
-        }
+        m_Terminal.SetRawMode(m_Pc->imm64 != 0);
+        m_Pc++;
+    }
+
+    void Blend::PollKey()
+    {
+        m_Registers[m_Pc->sreg] = m_Terminal.PollKey();
+        m_Pc++;
+    }
+
+    void Blend::Present()
+    {
+        // %r0 points at %r1 * %r2 characters, the number of bytes it took to draw them ends up in %r0.
+        m_Registers[RegType::R0] = m_Terminal.Present((const u8*)m_Registers[RegType::R0], (usize)m_Registers[RegType::R1],
+                                                      (usize)m_Registers[RegType::R2]);
+        m_Pc++;
+    }
+
+    void Blend::HostCall()
+    {
+        // Bound by name before the program started.
+        const auto& fn = m_HostImports[m_Pc->imm64];
+        m_Registers[RegType::R0] = fn.thunk(fn.callable, m_Registers);
         m_Pc++;
     }
 
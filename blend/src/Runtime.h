@@ -3,15 +3,27 @@
 
 #include <sdafx.h>
 
+#include "HostFunction.h"
 #include "Instruction.h"
+#include "NativeInvoke.h"
+#include "Process.h"
 #include "Register.h"
-#include "Utils.h"
+#include "SyscallBatch.h"
+#include "Terminal.h"
 
 namespace relang::blend {
-    constexpr int STACK_SIZE = 300;
+    constexpr int STACK_SIZE = 1 << 16;
+    // How many calls deep a program can go, return addresses are kept apart from the data stack.
+    constexpr usize CALL_STACK_SIZE = 1 << 16;
     constexpr u8 DATA_SECTION_INDIC = 0xFD;
     constexpr u8 CODE_SECTION_INDIC = 0xFC;
     constexpr u8 BSS_SECTION_INDIC = 0xFB;
+    // Optional debug section mapping instruction indices to source lines, the VM skips it.
+    constexpr u8 LINE_TABLE_SECTION_INDIC = 0xF7;
+    // Native functions called through invokec, a count followed by each NativeImport's strings.
+    constexpr u8 NATIVE_IMPORT_SECTION_INDIC = 0xF5;
+    // Host functions called through hostcall, a count followed by each name.
+    constexpr u8 HOST_IMPORT_SECTION_INDIC = 0xF4;
 
     class Blend
     {
@@ -20,10 +32,21 @@ namespace relang::blend {
     private:
         Instruction* m_Bytecode = nullptr;
         Instruction* m_Pc = nullptr;
+        usize m_CodeSize = 0;
         std::vector<u8> m_Stack;
         Registers m_Registers;
         uintptr& m_Sp;
         usize m_BssSize = 0;
+        // Indices into m_Bytecode to return to, innermost call last.
+        std::vector<u32> m_CallStack;
+        u32* m_CallTop = nullptr;
+        NativeImportTable m_NativeImports;
+        std::vector<HostFunction> m_HostFunctions;
+        std::vector<std::string> m_HostImportNames;
+        std::vector<BoundHostFunction> m_HostImports;
+        SyscallBatch m_SyscallBatch;
+        CommandWorker m_CommandWorker;
+        Terminal m_Terminal;
         const std::vector<InstructionHandler> m_Instructions =
             {
                 &Blend::End,
@@ -90,14 +113,50 @@ namespace relang::blend {
 
                 &Blend::SetConioMode,
                 &Blend::Debug_DumpFlags,
-                &Blend::Nop};
+                &Blend::Nop,
+
+                &Blend::HostCall,
+                &Blend::SyscallV,
+                &Blend::Clock,
+                &Blend::Rdtsc,
+                &Blend::Sleep,
+                &Blend::Spawn,
+                &Blend::Shell,
+                &Blend::PollKey,
+                &Blend::Present,
+                &Blend::PushRegisterMask,
+                &Blend::PopRegisterMask,
+                &Blend::LeaveReturn,
+                &Blend::JumpTable,
+                &Blend::TailCall};
 
     public:
-        Blend(const std::vector<u8>& data, const usize bssSize);
+        Blend(const std::vector<u8>& data, const usize bssSize, const std::vector<NativeImport>& nativeImports = {},
+              std::vector<std::string> hostImports = {});
 
     public:
+        // Exposes fn to guest code under name, its arguments are taken from %r0 onwards and its result is put in
+        // %r0. Functions have to be registered before Run() binds the program's host imports to them.
+        template <typename F>
+        void RegisterHostFunction(std::string name, F fn)
+        {
+            auto it = std::find_if(m_HostFunctions.begin(), m_HostFunctions.end(),
+                                   [&name](const HostFunction& f) { return f.name == name; });
+            if (it == m_HostFunctions.end())
+                it = m_HostFunctions.insert(it, HostFunction{.name = std::move(name), .thunk = nullptr, .callable = nullptr});
+            it->thunk = &host::Thunk<F>;
+            it->callable = std::make_shared<F>(std::move(fn));
+        }
         void Run(const std::vector<Instruction>& code, i64& result);
 
+    private:
+        bool BindHostFunctions();
+        // Spill and reload the registers set in mask, %r0-%r31 only, lowest register at the lowest address.
+        void SaveRegisters(u64 mask);
+        void RestoreRegisters(u64 mask);
+        // Jumps to a target computed at run time, unlike assembled ones it may point anywhere so it is checked first.
+        void JumpTo(u64 target);
+
     private:
         void End();
         void Push();
@@ -158,6 +217,21 @@ namespace relang::blend {
         void SetConioMode();
         void Debug_DumpFlags();
         void Nop();
+
+        void HostCall();
+        void SyscallV();
+        void Clock();
+        void Rdtsc();
+        void Sleep();
+        void Spawn();
+        void Shell();
+        void PollKey();
+        void Present();
+        void PushRegisterMask();
+        void PopRegisterMask();
+        void LeaveReturn();
+        void JumpTable();
+        void TailCall();
     };
 } // namespace relang::blend
 
@@ -0,0 +1,222 @@
+#include "SyscallBatch.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__linux__) && defined(BLEND_IO_URING)
+#include <atomic>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#endif
+
+namespace relang::blend
+{
+#if defined(__linux__) && defined(BLEND_IO_URING)
+    namespace
+    {
+        // Longer batches go through the ring in several rounds.
+        constexpr u32 RING_ENTRIES = 64;
+
+        // Translates a call into a submission entry, false if io_uring has no equivalent of it.
+        bool Prepare(const SyscallDescriptor& desc, io_uring_sqe& sqe) noexcept
+        {
+            sqe = io_uring_sqe{};
+            const u64* args = desc.args;
+            switch (desc.number)
+            {
+                case SYS_read:
+                case SYS_write:
+                    sqe.opcode = (desc.number == SYS_read) ? IORING_OP_READ : IORING_OP_WRITE;
+                    sqe.fd = (i32)args[0];
+                    sqe.addr = args[1];
+                    sqe.len = (u32)args[2];
+                    // Use and advance the file position like read() and write() do.
+                    sqe.off = ~u64{0};
+                    return args[2] <= ~u32{0};
+                case SYS_pread64:
+                case SYS_pwrite64:
+                    sqe.opcode = (desc.number == SYS_pread64) ? IORING_OP_READ : IORING_OP_WRITE;
+                    sqe.fd = (i32)args[0];
+                    sqe.addr = args[1];
+                    sqe.len = (u32)args[2];
+                    sqe.off = args[3];
+                    return args[2] <= ~u32{0};
+                case SYS_openat:
+                    sqe.opcode = IORING_OP_OPENAT;
+                    sqe.fd = (i32)args[0];
+                    sqe.addr = args[1];
+                    sqe.open_flags = (u32)args[2];
+                    sqe.len = (u32)args[3];
+                    return true;
+                case SYS_close:
+                    sqe.opcode = IORING_OP_CLOSE;
+                    sqe.fd = (i32)args[0];
+                    return true;
+                case SYS_fsync:
+                    sqe.opcode = IORING_OP_FSYNC;
+                    sqe.fd = (i32)args[0];
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    } // namespace
+#endif
+
+    SyscallBatch::~SyscallBatch()
+    {
+#if defined(__linux__) && defined(BLEND_IO_URING)
+        if (m_Sqes)
+            munmap(m_Sqes, m_SqesSize);
+        if (m_CqRing && m_CqRing != m_SqRing)
+            munmap(m_CqRing, m_CqRingSize);
+        if (m_SqRing)
+            munmap(m_SqRing, m_SqRingSize);
+        if (m_RingFd != -1)
+            close(m_RingFd);
+#endif
+    }
+
+    usize SyscallBatch::Submit(const std::span<SyscallDescriptor> batch)
+    {
+        if (!SubmitToRing(batch))
+            RunLoop(batch);
+        return (usize)std::count_if(batch.begin(), batch.end(), [](const SyscallDescriptor& desc) { return desc.result < 0; });
+    }
+
+    bool SyscallBatch::SetupRing()
+    {
+#if defined(__linux__) && defined(BLEND_IO_URING)
+        io_uring_params params{};
+        const int fd = (int)syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+        if (fd < 0)
+            return false;
+
+        // Reads and writes at the file position need 5.6, older kernels take the loop.
+        m_RingFd = fd;
+        if (!(params.features & IORING_FEAT_RW_CUR_POS))
+            return false;
+
+        m_RingEntries = params.sq_entries;
+        m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+        m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            m_SqRingSize = m_CqRingSize = std::max(m_SqRingSize, m_CqRingSize);
+
+        void* sq = mmap(nullptr, m_SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sq == MAP_FAILED)
+            return false;
+        m_SqRing = sq;
+
+        void* cq = sq;
+        if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+        {
+            cq = mmap(nullptr, m_CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cq == MAP_FAILED)
+                return false;
+        }
+        m_CqRing = cq;
+
+        m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, m_SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+            return false;
+        m_Sqes = sqes;
+
+        m_SqTail = (u32*)((u8*)sq + params.sq_off.tail);
+        m_SqMask = (u32*)((u8*)sq + params.sq_off.ring_mask);
+        m_SqArray = (u32*)((u8*)sq + params.sq_off.array);
+        m_CqHead = (u32*)((u8*)cq + params.cq_off.head);
+        m_CqTail = (u32*)((u8*)cq + params.cq_off.tail);
+        m_CqMask = (u32*)((u8*)cq + params.cq_off.ring_mask);
+        m_Cqes = (u8*)cq + params.cq_off.cqes;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool SyscallBatch::SubmitToRing([[maybe_unused]] const std::span<SyscallDescriptor> batch)
+    {
+#if defined(__linux__) && defined(BLEND_IO_URING)
+        if (!m_RingTried)
+        {
+            m_RingTried = true;
+            SetupRing();
+        }
+        // Only set once the whole ring is mapped.
+        if (!m_Cqes)
+            return false;
+
+        // All or nothing, a batch is never split between the ring and the loop.
+        io_uring_sqe scratch;
+        for (const auto& desc : batch)
+        {
+            if (!Prepare(desc, scratch))
+                return false;
+        }
+
+        auto* sqes = (io_uring_sqe*)m_Sqes;
+        auto* cqes = (io_uring_cqe*)m_Cqes;
+        for (usize begin = 0; begin < batch.size(); begin += m_RingEntries)
+        {
+            const u32 count = (u32)std::min<usize>(m_RingEntries, batch.size() - begin);
+            const u32 tail = *m_SqTail;
+            for (u32 i = 0; i < count; ++i)
+            {
+                const u32 index = (tail + i) & *m_SqMask;
+                Prepare(batch[begin + i], sqes[index]);
+                sqes[index].user_data = begin + i;
+                // Hard links run the calls one after the other without a failing call cancelling the rest.
+                if (i + 1 != count)
+                    sqes[index].flags |= IOSQE_IO_HARDLINK;
+                m_SqArray[index] = index;
+            }
+            std::atomic_ref<u32>(*m_SqTail).store(tail + count, std::memory_order_release);
+
+            u32 submitted = 0;
+            u32 completed = 0;
+            while (completed != count)
+            {
+                const long ret = syscall(__NR_io_uring_enter, m_RingFd, count - submitted, count - completed,
+                                         IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                {
+                    std::cerr << "Runtime Error: Submitting system calls failed: " << std::strerror(errno) << "\n";
+                    std::exit(-1);
+                }
+                submitted += (ret > 0) ? (u32)ret : 0;
+
+                u32 head = *m_CqHead;
+                const u32 cq_tail = std::atomic_ref<u32>(*m_CqTail).load(std::memory_order_acquire);
+                for (; head != cq_tail; ++head, ++completed)
+                {
+                    const auto& cqe = cqes[head & *m_CqMask];
+                    batch[cqe.user_data].result = cqe.res;
+                }
+                std::atomic_ref<u32>(*m_CqHead).store(head, std::memory_order_release);
+            }
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void SyscallBatch::RunLoop(const std::span<SyscallDescriptor> batch)
+    {
+#if defined(__linux__)
+        for (auto& desc : batch)
+        {
+            const long ret = syscall(desc.number, desc.args[0], desc.args[1], desc.args[2], desc.args[3], desc.args[4],
+                                     desc.args[5]);
+            desc.result = (ret == -1) ? -errno : ret;
+        }
+#else
+        std::printf("Runtime Error: System calls are not yet supported on your platform.");
+        std::exit(-1);
+#endif
+    }
+} // namespace relang::blend
@@ -0,0 +1,60 @@
+#ifndef BLEND_SYSCALL_BATCH_H
+#define BLEND_SYSCALL_BATCH_H
+
+#include <sdafx.h>
+
+#include <span>
+
+namespace relang::blend
+{
+    // One entry of a syscallv batch as laid out in guest memory. The result is what the kernel returned, errors as
+    // negative errno values.
+    struct SyscallDescriptor
+    {
+        u64 number = 0;
+        u64 args[6] = {0};
+        i64 result = 0;
+    };
+
+    // Runs a batch of system calls in order, as if they were made one after the other, through a plain loop of
+    // syscall(). Built with BLEND_IO_URING, batches made up of calls io_uring knows (read, write, pread64, pwrite64,
+    // openat, close, fsync) are submitted through a ring in one go instead.
+    class SyscallBatch
+    {
+    private:
+        // The ring is only set up once a program submits a batch, if the kernel refuses it stays unavailable.
+        bool m_RingTried = false;
+        int m_RingFd = -1;
+        u32 m_RingEntries = 0;
+        void* m_SqRing = nullptr;
+        usize m_SqRingSize = 0;
+        void* m_CqRing = nullptr;
+        usize m_CqRingSize = 0;
+        void* m_Sqes = nullptr;
+        usize m_SqesSize = 0;
+        u32* m_SqTail = nullptr;
+        u32* m_SqMask = nullptr;
+        u32* m_SqArray = nullptr;
+        u32* m_CqHead = nullptr;
+        u32* m_CqTail = nullptr;
+        u32* m_CqMask = nullptr;
+        void* m_Cqes = nullptr;
+
+    public:
+        SyscallBatch() = default;
+        SyscallBatch(const SyscallBatch&) = delete;
+        SyscallBatch& operator=(const SyscallBatch&) = delete;
+        ~SyscallBatch();
+
+    public:
+        // Fills in every result and returns how many of the calls failed.
+        usize Submit(std::span<SyscallDescriptor> batch);
+
+    private:
+        bool SetupRing();
+        bool SubmitToRing(std::span<SyscallDescriptor> batch);
+        static void RunLoop(std::span<SyscallDescriptor> batch);
+    };
+} // namespace relang::blend
+
+#endif // BLEND_SYSCALL_BATCH_H
@@ -0,0 +1,202 @@
+#include "Terminal.h"
+
+#if defined(__APPLE__) || defined(__linux__)
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace relang::blend
+{
+    namespace
+    {
+        // Unchanged cells between two changed ones are rewritten when that's shorter than moving the cursor over them.
+        constexpr usize MAX_GAP = 6;
+
+        // Anything that would move the cursor on its own is drawn as a space.
+        inline char Printable(const u8 c) noexcept
+        {
+            return (c >= 0x20 && c < 0x7f) ? (char)c : ' ';
+        }
+
+        void WriteAll(const char* data, usize size) noexcept
+        {
+#if defined(__APPLE__) || defined(__linux__)
+            while (size != 0)
+            {
+                const ssize_t n = write(STDOUT_FILENO, data, size);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return;
+                data += n;
+                size -= (usize)n;
+            }
+#else
+            std::fwrite(data, 1, size, stdout);
+            std::fflush(stdout);
+#endif
+        }
+
+        // Shared with the exit and signal handlers, which have no VM to go through.
+        volatile std::sig_atomic_t g_Raw = 0;
+        volatile std::sig_atomic_t g_CursorHidden = 0;
+#if defined(__APPLE__) || defined(__linux__)
+        termios g_Original;
+#endif
+
+        // Only async signal safe calls in here.
+        void Restore() noexcept
+        {
+            if (g_CursorHidden)
+            {
+                constexpr char show[] = "\x1b[?25h";
+                WriteAll(show, sizeof(show) - 1);
+                g_CursorHidden = 0;
+            }
+#if defined(__APPLE__) || defined(__linux__)
+            if (g_Raw)
+            {
+                tcsetattr(STDIN_FILENO, TCSANOW, &g_Original);
+                g_Raw = 0;
+            }
+#endif
+        }
+
+#if defined(__APPLE__) || defined(__linux__)
+        void OnSignal(const int sig)
+        {
+            Restore();
+            std::signal(sig, SIG_DFL);
+            std::raise(sig);
+        }
+#endif
+
+        void InstallRestoreHandlers()
+        {
+            static bool installed = false;
+            if (installed)
+                return;
+            installed = true;
+            std::atexit(Restore);
+#if defined(__APPLE__) || defined(__linux__)
+            for (const int sig : {SIGINT, SIGTERM, SIGHUP, SIGQUIT})
+                std::signal(sig, OnSignal);
+#endif
+        }
+    } // namespace
+
+    Terminal::~Terminal()
+    {
+        SetRawMode(false);
+    }
+
+    void Terminal::SetRawMode(const bool enable)
+    {
+        if (!enable)
+        {
+            // Leave the cursor under the last frame rather than somewhere in the middle of it.
+            if (m_Height != 0 && g_CursorHidden)
+            {
+                std::fflush(stdout);
+                const std::string below = "\x1b[" + std::to_string(m_Height + 1) + ";1H";
+                WriteAll(below.data(), below.size());
+            }
+            Restore();
+            m_Front.clear();
+            m_Width = m_Height = 0;
+            return;
+        }
+
+#if defined(__APPLE__) || defined(__linux__)
+        if (g_Raw || !isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &g_Original) != 0)
+            return;
+        InstallRestoreHandlers();
+
+        termios raw = g_Original;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0)
+            g_Raw = 1;
+#endif
+    }
+
+    u8 Terminal::PollKey()
+    {
+#if defined(__APPLE__) || defined(__linux__)
+        pollfd fd = {.fd = STDIN_FILENO, .events = POLLIN, .revents = 0};
+        u8 key;
+        if (poll(&fd, 1, 0) > 0 && read(STDIN_FILENO, &key, 1) == 1)
+            return key;
+#endif
+        return 0;
+    }
+
+    usize Terminal::Present(const u8* frame, const usize width, const usize height)
+    {
+        m_Output.clear();
+        if (width != m_Width || height != m_Height)
+        {
+            // Nothing on screen can be trusted to match, start over.
+            InstallRestoreHandlers();
+            m_Width = width;
+            m_Height = height;
+            m_Front.assign(width * height, 0);
+            m_Output += "\x1b[?25l\x1b[2J";
+            g_CursorHidden = 1;
+        }
+
+        // Where writing the last character left the cursor, if that's known.
+        usize cursor_row = ~usize{0};
+        usize cursor_col = ~usize{0};
+        for (usize row = 0; row < height; ++row)
+        {
+            const u8* src = frame + row * width;
+            u8* dst = m_Front.data() + row * width;
+            usize col = 0;
+            while (col < width)
+            {
+                if (src[col] == dst[col])
+                {
+                    col++;
+                    continue;
+                }
+
+                usize end = col + 1;
+                for (usize x = end; x < width && x - end < MAX_GAP; ++x)
+                {
+                    if (src[x] != dst[x])
+                        end = x + 1;
+                }
+
+                if (row != cursor_row || col != cursor_col)
+                {
+                    m_Output += "\x1b[";
+                    m_Output += std::to_string(row + 1);
+                    m_Output += ';';
+                    m_Output += std::to_string(col + 1);
+                    m_Output += 'H';
+                }
+                for (; col < end; ++col)
+                {
+                    m_Output += Printable(src[col]);
+                    dst[col] = src[col];
+                }
+                // Past the last column the terminal decides where the cursor goes.
+                cursor_row = row;
+                cursor_col = (end == width) ? ~usize{0} : end;
+            }
+        }
+
+        if (!m_Output.empty())
+        {
+            // Anything printed the usual way has to come out first.
+            std::fflush(stdout);
+            WriteAll(m_Output.data(), m_Output.size());
+        }
+        return m_Output.size();
+    }
+} // namespace relang::blend
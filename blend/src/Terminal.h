@@ -0,0 +1,36 @@
+#ifndef BLEND_TERMINAL_H
+#define BLEND_TERMINAL_H
+
+#include <sdafx.h>
+
+namespace relang::blend
+{
+    // The terminal the VM runs in, for programs that draw a whole screen and read keys as they're pressed.
+    class Terminal
+    {
+    private:
+        // What's on screen since the last Present(), one byte per cell.
+        std::vector<u8> m_Front;
+        usize m_Width = 0;
+        usize m_Height = 0;
+        std::string m_Output;
+
+    public:
+        Terminal() = default;
+        Terminal(const Terminal&) = delete;
+        Terminal& operator=(const Terminal&) = delete;
+        ~Terminal();
+
+    public:
+        // Keys come in as they're pressed without being echoed, Ctrl-C still works. The terminal is put back the way
+        // it was when leaving raw mode or when the VM exits, however that happens.
+        void SetRawMode(bool enable);
+        // A key if one is waiting, 0 otherwise. Never blocks.
+        u8 PollKey();
+        // Draws a width * height frame of characters, row by row. Only the cells that changed since the last frame
+        // are written, all in one write. Returns how many bytes that took.
+        usize Present(const u8* frame, usize width, usize height);
+    };
+} // namespace relang::blend
+
+#endif // BLEND_TERMINAL_H
@@ -1,49 +0,0 @@
-#include "Utils.h"
-
-namespace relang::blend::utils {
-    namespace gterm {
-#ifdef BLEND_PLATFORM_UNIX
-        // Source: https://stackoverflow.com/questions/448944/c-non-blocking-keyboard-input
-        struct termios orig_termios;
-
-        void reset_terminal_mode()
-        {
-            tcsetattr(0, TCSANOW, &orig_termios);
-        }
-
-        void set_conio_terminal_mode()
-        {
-            struct termios new_termios;
-
-            /* take two copies - one for now, one for later */
-            tcgetattr(0, &orig_termios);
-            memcpy(&new_termios, &orig_termios, sizeof(new_termios));
-
-            /* register cleanup handler, and set the new terminal mode */
-            atexit(reset_terminal_mode);
-            cfmakeraw(&new_termios);
-            tcsetattr(0, TCSANOW, &new_termios);
-        }
-
-        int kbhit()
-        {
-            struct timeval tv = { 0L, 0L };
-            fd_set fds;
-            FD_ZERO(&fds);
-            FD_SET(0, &fds);
-            return select(1, &fds, NULL, NULL, &tv) > 0;
-        }
-
-        int getch()
-        {
-            int r;
-            unsigned char c;
-            if ((r = read(0, &c, sizeof(c))) < 0) {
-                return r;
-            } else {
-                return c;
-            }
-        }
-#endif
-    }
-}
@@ -16,12 +16,22 @@ int main(const int argc, const char* argv[])
         {
             InstructionList code_section;
             std::vector<u8> data_section;
+            std::vector<NativeImport> native_imports;
+            std::vector<std::string> host_imports;
             usize bss_size;
 
             fs.seekg(0, fs.end);
             usize file_size = fs.tellg();
             fs.seekg(0, fs.beg);
 
+            const auto read_string = [&fs](std::string& str)
+            {
+                u32 length = 0;
+                fs.read((char*)&length, sizeof(u32));
+                str.resize(length);
+                fs.read(str.data(), length);
+            };
+
             u8 byte;
             usize size = 0;
             while (fs.read((char*)&byte, sizeof(u8)))
@@ -47,10 +57,38 @@ int main(const int argc, const char* argv[])
                         fs.read((char*)code_section.data(), size);
                         break;
                     }
+                    case LINE_TABLE_SECTION_INDIC:
+                    {
+                        fs.read((char*)&size, sizeof(usize));
+                        fs.seekg(size, fs.cur);
+                        break;
+                    }
+                    case NATIVE_IMPORT_SECTION_INDIC:
+                    {
+                        fs.read((char*)&size, sizeof(usize));
+                        native_imports.resize(size);
+                        for (auto& import : native_imports)
+                        {
+                            read_string(import.library);
+                            read_string(import.symbol);
+                            read_string(import.signature);
+                        }
+                        break;
+                    }
+                    case HOST_IMPORT_SECTION_INDIC:
+                    {
+                        fs.read((char*)&size, sizeof(usize));
+                        host_imports.resize(size);
+                        for (auto& name : host_imports)
+                            read_string(name);
+                        break;
+                    }
                 }
             }
 
-            Blend vm(data_section, bss_size);
+            Blend vm(data_section, bss_size, native_imports, std::move(host_imports));
+            // Host functions every program run by the CLI can import.
+            vm.RegisterHostFunction("print_f64", [](const double value) { std::printf("%g\n", value); });
             vm.Run(code_section, result);
         }
         else
@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+
+# Compiles every program in this directory at each optimization level and times the result on the Blend VM.
+#
+# Usage: run.py <refront> <blend> [runs]
+
+import os
+import sys
+import time
+import tempfile
+import subprocess as sb
+
+levels = ['-O0', '-O1', '-O2']
+
+def log(msg):
+    print(f'[Bench] [Info] :: {msg}')
+
+def panic(msg, exit_code = 1):
+    print(f'[Bench] [Error] :: {msg}')
+    sys.exit(exit_code)
+
+args = sys.argv[1:]
+if len(args) < 2:
+    panic('Usage: run.py <refront> <blend> [runs]')
+
+refront = os.path.abspath(args[0])
+blend = os.path.abspath(args[1])
+runs = int(args[2]) if len(args) > 2 else 5
+bench_dir = os.path.dirname(os.path.abspath(__file__))
+programs = sorted(f for f in os.listdir(bench_dir) if f.endswith('.cmm'))
+
+with tempfile.TemporaryDirectory() as out_dir:
+    print(f'{"program":<16}' + ''.join(f'{level:>12}' for level in levels))
+    for program in programs:
+        row = f'{program:<16}'
+        outputs = set()
+        for level in levels:
+            binary = os.path.join(out_dir, f'{program}{level}.bin')
+            res = sb.run([refront, os.path.join(bench_dir, program), level, '-o', binary], stdout=sb.DEVNULL)
+            if res.returncode != 0:
+                panic(f'Failed to compile {program} at {level}.')
+
+            # Best of the runs, the output has to match between levels.
+            best = None
+            for _ in range(runs):
+                begin = time.time()
+                res = sb.run([blend, binary], stdout=sb.PIPE)
+                elapsed = time.time() - begin
+                outputs.add((res.stdout, res.returncode))
+                best = elapsed if best is None else min(best, elapsed)
+            row += f'{best * 1000:>10.1f}ms'
+        print(row)
+        if len(outputs) != 1:
+            panic(f'{program} behaves differently between optimization levels.')
+
+log('Done.')
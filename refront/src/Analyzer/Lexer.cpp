@@ -34,14 +34,6 @@ namespace relang::refront {
     {
     }
 
-    std::optional<Token> Lexer::PeekToken()
-    {
-        const auto current_state = *this;
-        auto       token         = NextToken();
-        *this                    = std::move(current_state);
-        return token;
-    }
-
     std::optional<Token> Lexer::NextToken()
     {
         // If we've reached the end.
@@ -143,8 +135,7 @@ namespace relang::refront {
                             // span.
                             ++m_TokenCount;
                             current_token.type = TokenType::StringLiteral;
-                            current_token.span =
-                                TextSpan{ .line = m_LineCount, .cur = m_TokenCount, .text = std::move(*str) };
+                            current_token.span = TextSpan{ .line = m_LineCount, .cur = m_TokenCount, .text = *str };
 
                             return current_token;
                         }
@@ -152,7 +143,8 @@ namespace relang::refront {
                     }
                     case TokenType::Quote: {
                         // Consume the possible character inside the single quotes.
-                        auto c = Consume();
+                        usize char_pos = m_CurrentPos;
+                        auto  c        = Consume();
                         if (c.has_value())
                         {
                             // Consume the possible second quote.
@@ -163,8 +155,9 @@ namespace relang::refront {
                                 ++m_TokenCount;
                                 current_token.type = TokenType::CharacterLiteral;
                                 current_token.num  = *ec;
-                                current_token.span = TextSpan{ .line = m_LineCount, .cur = m_TokenCount };
-                                current_token.span.text += *c;
+                                current_token.span = TextSpan{ .line = m_LineCount,
+                                                               .cur  = m_TokenCount,
+                                                               .text = m_Source.substr(char_pos, 1) };
 
                                 return current_token;
                             }
@@ -188,9 +181,8 @@ namespace relang::refront {
         // text itself.
         ++m_TokenCount;
         usize end          = m_CurrentPos;
-        current_token.span = TextSpan{ .line = m_LineCount,
-                                       .cur  = m_TokenCount,
-                                       .text = std::string{ m_Source.substr(start, end - start) } };
+        current_token.span =
+            TextSpan{ .line = m_LineCount, .cur = m_TokenCount, .text = m_Source.substr(start, end - start) };
 
         return current_token;
     }
@@ -232,22 +224,22 @@ namespace relang::refront {
         return num;
     }
 
-    std::string Lexer::ConsumeIdentifier() noexcept
+    std::string_view Lexer::ConsumeIdentifier() noexcept
     {
-        std::string ident{};
+        usize start = m_CurrentPos;
         for (auto c = CurrentChar(); c.has_value(); c = CurrentChar())
         {
-            if ((ident.empty() && std::isalpha(*c)) || (!ident.empty() && std::isalnum(*c)) || *c == '_')
+            const bool empty = m_CurrentPos == start;
+            if ((empty && std::isalpha(*c)) || (!empty && std::isalnum(*c)) || *c == '_')
             {
                 // If our identifier starts with a letter or contains a possible letter or a number, or it's just an
-                // underscore then Consume the current character, append the previous to ident, then continue.
+                // underscore then Consume the current character and continue.
                 Consume();
-                ident += *c;
             }
             else
                 break;
         }
-        return ident;
+        return m_Source.substr(start, m_CurrentPos - start);
     }
 
     TokenType Lexer::ConsumeOperator() noexcept
@@ -370,19 +362,22 @@ namespace relang::refront {
         return TokenType::None;
     }
 
-    std::optional<std::string> Lexer::ConsumeString() noexcept
+    std::optional<std::string_view> Lexer::ConsumeString() noexcept
     {
-        std::string str{};
+        usize start = m_CurrentPos;
+        usize end   = start;
         for (auto c = CurrentChar(); c.has_value(); c = CurrentChar())
         {
             // Consume the string until we hit a double quote.
             Consume();
             if (*c != '"')
-                str += *c;
+                end = m_CurrentPos;
             else
                 break;
         }
 
+        auto str = m_Source.substr(start, end - start);
+
         // If the string was invalid then return nothing, or str otherwise.
         if (str.empty())
             return std::nullopt;
@@ -395,6 +390,20 @@ namespace relang::refront {
         // Identifiers start with a letter or an underscore followed by more letters, underscores and numbers.
         return (std::isalpha(c) || c == '_');
     }
+
+    TokenStream::TokenStream(const std::string_view source) : m_Lexer(source)
+    {
+    }
+
+    void TokenStream::Fill(const usize count)
+    {
+        for (; m_Count < count; ++m_Count)
+        {
+            // The lexer gives up after Eof, keep handing Eof out instead.
+            auto token = m_Lexer.NextToken();
+            m_Ring[(m_Head + m_Count) & (Lookahead - 1)] = token.value_or(Token{ .type = TokenType::Eof });
+        }
+    }
 } // namespace relang::refront
 
 std::ostream& operator<<(std::ostream& stream, const relang::refront::TextSpan& span) noexcept
@@ -1,6 +1,8 @@
 #ifndef CMC_ANALYZER_LEXER_H
 #define CMC_ANALYZER_LEXER_H
 
+#include <array>
+#include <cassert>
 #include <iostream>
 #include <nlohmann/json.hpp>
 #include <optional>
@@ -87,9 +89,9 @@ namespace relang::refront {
 
     struct TextSpan
     {
-        usize       line{};
-        usize       cur{};
-        std::string text{};
+        u32              line{};
+        u32              cur{};
+        std::string_view text{}; // Points into the lexed source, which must outlive the token.
     };
 
     struct Token
@@ -179,8 +181,8 @@ namespace relang::refront {
     private:
         std::string_view m_Source{};
         usize            m_CurrentPos{};
-        usize            m_TokenCount{};
-        usize            m_LineCount = 1;
+        u32              m_TokenCount{};
+        u32              m_LineCount = 1;
 
     public:
         Lexer() = default;
@@ -188,18 +190,55 @@ namespace relang::refront {
 
     public:
         std::optional<Token> NextToken();
-        std::optional<Token> PeekToken();
 
     private:
-        std::optional<char>        CurrentChar() const noexcept;
-        std::optional<char>        Consume() noexcept;
-        i64                        ConsumeNumber() noexcept;
-        std::string                ConsumeIdentifier() noexcept;
-        TokenType                  ConsumeOperator() noexcept;
-        std::optional<std::string> ConsumeString() noexcept;
-        bool                       IsIdentifierStart(const char c) const noexcept;
+        std::optional<char>             CurrentChar() const noexcept;
+        std::optional<char>             Consume() noexcept;
+        i64                             ConsumeNumber() noexcept;
+        std::string_view                ConsumeIdentifier() noexcept;
+        TokenType                       ConsumeOperator() noexcept;
+        std::optional<std::string_view> ConsumeString() noexcept;
+        bool                            IsIdentifierStart(const char c) const noexcept;
     };
 
+    // Tokens lexed on demand into a small ring, so looking ahead never lexes the same token twice. Once the source
+    // runs out every further token is Eof.
+    class TokenStream
+    {
+    public:
+        static constexpr usize Lookahead = 4; // How far Peek can see, a power of two.
+
+    private:
+        Lexer                        m_Lexer{};
+        std::array<Token, Lookahead> m_Ring{};
+        usize                        m_Head{};  // Slot of the next token.
+        usize                        m_Count{}; // Tokens lexed but not taken yet.
+
+    public:
+        TokenStream() = default;
+        explicit TokenStream(const std::string_view source);
+
+    public:
+        // Moves the next token out into token.
+        inline void Next(Token& token)
+        {
+            if (m_Count == 0)
+                Fill(1);
+            token  = m_Ring[m_Head];
+            m_Head = (m_Head + 1) & (Lookahead - 1);
+            --m_Count;
+        }
+        inline const Token& Peek(const usize distance = 0)
+        {
+            assert(distance < Lookahead && "Peeking further than the token ring holds.");
+            if (m_Count <= distance)
+                Fill(distance + 1);
+            return m_Ring[(m_Head + distance) & (Lookahead - 1)];
+        }
+
+    private:
+        void Fill(const usize count);
+    };
 } // namespace relang::refront
 
 namespace nlohmann {
@@ -279,7 +318,7 @@ namespace nlohmann {
         {
             j["line"] = t.line;
             j["cur"]  = t.cur;
-            j["text"] = t.text;
+            j["text"] = std::string{ t.text };
         }
     };
 
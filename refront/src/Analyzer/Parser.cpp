@@ -25,36 +25,90 @@ namespace relang::refront {
             return type;
         }
 
-        std::optional<Token> Statement::GetToken(const TokenType& type) const noexcept
+        SyntaxTree::SyntaxTree()
         {
-            for (const auto& t : tokens)
+            // Type index 0 is always Void so default constructed nodes are typeless.
+            InternType(Type{});
+        }
+
+        NodeIndex SyntaxTree::AddNode(const Node& node, std::span<const NodeIndex> children,
+                                      std::span<const Token> tokens)
+        {
+            Node n     = node;
+            n.children = NodeRange{ .begin = (u32)m_Children.size(), .count = (u32)children.size() };
+            n.tokens   = NodeRange{ .begin = (u32)m_Tokens.size(), .count = (u32)tokens.size() };
+            m_Children.insert(m_Children.end(), children.begin(), children.end());
+            m_Tokens.insert(m_Tokens.end(), tokens.begin(), tokens.end());
+            m_Nodes.push_back(n);
+            return (NodeIndex)(m_Nodes.size() - 1);
+        }
+
+        NodeIndex SyntaxTree::ImportDeclaration(const SyntaxTree& module, const Node& fn)
+        {
+            // Only the signature comes over, its names and tokens keep pointing into the other module's source.
+            const auto&            param_list = module.GetChildren(fn)[0];
+            std::vector<NodeIndex> params{};
+            for (const auto& p : module.GetChildren(param_list))
             {
-                if (t.type == type)
-                    return t;
+                Node param  = p;
+                param.type  = InternType(module.GetType(p));
+                param.ident = InternIdentifier(p.name);
+                params.push_back(AddNode(param, {}, module.GetTokens(p)));
             }
-            return std::nullopt;
+
+            const NodeIndex list = AddNode(param_list, params, module.GetTokens(param_list));
+            Node            decl = fn;
+            decl.type            = InternType(module.GetType(fn));
+            decl.ident           = InternIdentifier(fn.name);
+            return AddNode(decl, std::span<const NodeIndex>{ &list, 1 }, module.GetTokens(fn));
         }
-    } // namespace ast
 
-    void SymbolTable::AddSymbol(Symbol symbol) noexcept
-    {
-        m_Symbols[symbol.name] = std::move(symbol);
-    }
+        void SyntaxTree::AddGlobal(const NodeIndex index)
+        {
+            m_Globals.push_back(index);
+        }
 
-    bool SymbolTable::ContainsSymbol(const std::string& name) const noexcept
-    {
-        return m_Symbols.contains(name);
-    }
+        TypeIndex SyntaxTree::InternType(const Type& type)
+        {
+            // Type names are short enough to stay within the small string buffer so the key is allocation free.
+            auto key = type.ToString();
+            key += (char)type.ftype;
+
+            auto [it, inserted] = m_TypeIndices.try_emplace(std::move(key), (TypeIndex)m_Types.size());
+            if (inserted)
+                m_Types.push_back(type);
+            return it->second;
+        }
 
-    Symbol& SymbolTable::GetSymbol(const std::string& name) noexcept
-    {
-        return m_Symbols[name];
-    }
+        IdentId SyntaxTree::InternIdentifier(const std::string_view name)
+        {
+            return m_Identifiers.Intern(name);
+        }
 
-    const Symbol& SymbolTable::GetSymbol(const std::string& name) const noexcept
-    {
-        return ((SymbolTable*)this)->GetSymbol(name);
-    }
+        std::optional<Token> SyntaxTree::GetFirstToken(const Node& node) const noexcept
+        {
+            if (node.tokens.count != 0)
+                return m_Tokens[node.tokens.begin];
+
+            // Some nodes keep no tokens of their own, e.g. assignments, so fall back to their children.
+            for (const auto& c : GetChildren(node))
+            {
+                if (auto token = GetFirstToken(c); token)
+                    return token;
+            }
+            return std::nullopt;
+        }
+
+        std::optional<Token> SyntaxTree::GetToken(const Node& node, const TokenType& type) const noexcept
+        {
+            for (const auto& t : GetTokens(node))
+            {
+                if (t.type == type)
+                    return t;
+            }
+            return std::nullopt;
+        }
+    } // namespace ast
 
     std::optional<Type> Type::FromToken(const Token& token) noexcept
     {
@@ -67,7 +121,8 @@ namespace relang::refront {
             case KeywordString: return Type::String(token);
             case KeywordChar: return Type::Character;
             case KeywordBool: return Type::Boolean;
-            case Identifier: return Type{ .name = token.span.text, .ftype = FundamentalType::UserDefined };
+            case Identifier:
+                return Type{ .name = std::string{ token.span.text }, .ftype = FundamentalType::UserDefined };
             default: break;
         }
         return std::nullopt;
@@ -75,43 +130,126 @@ namespace relang::refront {
 
     Parser::Parser(const std::string_view source) noexcept : m_Source(source)
     {
+        // The outermost scope holds the functions.
+        m_Symbols.PushScope();
     }
 
-    std::vector<Statement> Parser::Parse()
+    void Parser::Import(const SyntaxTree& module)
     {
-        m_Lexer        = Lexer(m_Source);
-        m_CurrentToken = m_Lexer.NextToken();
+        // What the module imported itself stays behind, only its own functions become visible.
+        for (const auto& s : module.GetGlobals())
+        {
+            if (s.kind == StatementKind::FunctionDeclaration && s.children.count > 1)
+            {
+                const auto index = m_Tree.ImportDeclaration(module, s);
+                m_Tree.AddGlobal(index);
+                m_Symbols.Add(m_Tree[index].ident, Symbol{ .node = index });
+            }
+        }
+    }
+
+    SyntaxTree Parser::Parse()
+    {
+        m_Tokens = TokenStream(m_Source);
+        m_Tokens.Next(m_CurrentToken.emplace());
+
+        // Imports come first, the driver does not look any further for the modules to load.
+        while (m_CurrentToken->IsValid())
+        {
+            if (auto c = ExpectImportDirective(); c.has_value())
+                m_Tree.AddGlobal(*c);
+            else
+                break;
+        }
+
         while (m_CurrentToken->IsValid())
         {
+            if (m_CurrentToken->type == TokenType::KeywordImport)
+            {
+                CompileError(*m_CurrentToken, "Import directives have to come before any declaration.");
+            }
+
+            // Functions become visible once declared, which rules out calling one before its declaration.
             if (auto c = ExpectFunctionDecl(); c.has_value())
-                m_GlobalStatements.push_back(std::move(*c));
+            {
+                m_Tree.AddGlobal(*c);
+                m_Symbols.Add(m_Tree[*c].ident, Symbol{ .node = *c });
+            }
+        }
+        return std::move(m_Tree);
+    }
+
+    std::vector<std::string_view> Parser::ScanImports(const std::string_view source)
+    {
+        // Reads just the leading directives so a module's dependencies are known without parsing it, malformed ones
+        // are left for the parser to report.
+        std::vector<std::string_view> imports{};
+        TokenStream                   tokens(source);
+        Token                         token{};
+        for (tokens.Next(token); token.type == TokenType::KeywordImport; tokens.Next(token))
+        {
+            tokens.Next(token);
+            if (token.type != TokenType::StringLiteral)
+                break;
+            imports.push_back(token.span.text);
+
+            tokens.Next(token);
+            if (token.type != TokenType::SemiColon)
+                break;
         }
-        return m_GlobalStatements;
+        return imports;
     }
 
     std::optional<Token> Parser::Consume() noexcept
     {
         auto current   = m_CurrentToken;
-        m_CurrentToken = m_Lexer.NextToken();
+        m_Tokens.Next(*m_CurrentToken);
         return current;
     }
 
-    std::optional<Token> Parser::Peek() noexcept
+    std::optional<Token> Parser::Peek(const usize distance)
+    {
+        // The current token was already taken from the stream, one ahead is the stream's first.
+        return m_Tokens.Peek(distance - 1);
+    }
+
+    Parser::NodeFrame Parser::BeginNode() const noexcept
+    {
+        return NodeFrame{ .children = m_ChildStack.size(), .tokens = m_TokenStack.size() };
+    }
+
+    NodeIndex Parser::EndNode(const NodeFrame& frame, const Node& node)
+    {
+        // Everything pushed since the frame began belongs to this node, nested nodes have already popped theirs.
+        auto children = std::span<const NodeIndex>{ m_ChildStack }.subspan(frame.children);
+        auto tokens   = std::span<const Token>{ m_TokenStack }.subspan(frame.tokens);
+        auto index    = m_Tree.AddNode(node, children, tokens);
+        DiscardNode(frame);
+        return index;
+    }
+
+    void Parser::DiscardNode(const NodeFrame& frame) noexcept
+    {
+        m_ChildStack.resize(frame.children);
+        m_TokenStack.resize(frame.tokens);
+    }
+
+    const Type& Parser::GetType(const NodeIndex index) const noexcept
     {
-        return m_Lexer.PeekToken();
+        return m_Tree.GetType(m_Tree[index]);
     }
 
-    std::optional<Statement> Parser::GetStatement(const StatementKind kind) const noexcept
+    std::optional<NodeIndex> Parser::GetStatement(const StatementKind kind) const noexcept
     {
-        for (const auto& e : m_GlobalStatements)
+        for (const auto& e : m_Tree.GetGlobals())
         {
             if (e.kind == kind)
-                return e;
+                return m_Tree.IndexOf(e);
         }
         return std::nullopt;
     }
 
-    std::optional<Statement> Parser::ExpectFunctionDecl()
+    std::optional<NodeIndex> Parser::ExpectFunctionDecl()
     {
         if (m_CurrentToken->type == TokenType::KeywordFn)
         {
@@ -119,23 +257,25 @@ namespace relang::refront {
             auto prev_token = *Consume();
 
             // Our function declaration statement.
-            Statement func_stmt{};
+            Node func_stmt{};
+            auto frame = BeginNode();
 
             // If the following token is an identifier.
             if (m_CurrentToken->type == TokenType::Identifier)
             {
                 // Consume the identifier.
                 prev_token     = *Consume();
-                func_stmt.name = prev_token.span.text;
-                func_stmt.kind = StatementKind::FunctionDeclaration;
-                func_stmt.tokens.push_back(std::move(prev_token));
+                func_stmt.name  = prev_token.span.text;
+                func_stmt.ident = m_Tree.InternIdentifier(func_stmt.name);
+                func_stmt.kind  = StatementKind::FunctionDeclaration;
+                m_TokenStack.push_back(prev_token);
 
-                // The function's parameter list symbol table.
-                m_SymbolTableStack.push_back(SymbolTable{});
+                // The function's parameter list scope.
+                m_Symbols.PushScope();
 
                 // Parse possible parameter list, if there's none then our parameter list statement will just be empty.
                 auto param_list = ExpectFunctionParameterList();
-                func_stmt.children.push_back(std::move(param_list));
+                m_ChildStack.push_back(param_list);
 
                 // Parse the possible return type or a function scope start.
                 if (m_CurrentToken->IsValid())
@@ -156,7 +296,7 @@ namespace relang::refront {
                             {
                                 // Consume the type.
                                 Consume();
-                                func_stmt.type = std::move(*type_opt);
+                                func_stmt.type = m_Tree.InternType(*type_opt);
                             }
                             else
                             {
@@ -172,7 +312,7 @@ namespace relang::refront {
                     // Parse the function body.
                     auto body_stmt = ExpectLocalStatement();
                     if (body_stmt)
-                        func_stmt.children.push_back(std::move(*body_stmt));
+                        m_ChildStack.push_back(*body_stmt);
                     else
                     {
                         CompileError(*m_CurrentToken, "Expected a statement.");
@@ -184,10 +324,10 @@ namespace relang::refront {
                                  "Expected a function return type specifier or a function scope start.");
                 }
 
-                // Pop the function's parameter list symbol table.
-                m_SymbolTableStack.pop_back();
+                // Pop the function's parameter list scope.
+                m_Symbols.PopScope();
 
-                return func_stmt;
+                return EndNode(frame, func_stmt);
             }
             else
             {
@@ -198,29 +338,67 @@ namespace relang::refront {
         return std::nullopt;
     }
 
-    Statement Parser::ExpectFunctionParameterList()
+    std::optional<NodeIndex> Parser::ExpectImportDirective()
     {
-        Statement params{};
+        if (m_CurrentToken->type == TokenType::KeywordImport)
+        {
+            // Consume the import keyword.
+            auto import_token = *Consume();
+
+            // Our import directive, named after the module's path.
+            Node import{};
+            auto frame = BeginNode();
+            m_TokenStack.push_back(import_token);
+            if (m_CurrentToken->type == TokenType::StringLiteral)
+            {
+                auto path_token = *Consume();
+                import.name     = path_token.span.text;
+                import.kind     = StatementKind::ImportDirective;
+                m_TokenStack.push_back(path_token);
+            }
+            else
+            {
+                CompileError(import_token, "Expected a module path after the import keyword.");
+            }
+
+            if (m_CurrentToken->type != TokenType::SemiColon)
+            {
+                CompileError(*m_CurrentToken, "Expected a semicolon after the import directive.");
+            }
+
+            // Consume the semicolon.
+            Consume();
+            return EndNode(frame, import);
+        }
+        return std::nullopt;
+    }
+
+    NodeIndex Parser::ExpectFunctionParameterList()
+    {
+        Node params{};
+        auto frame = BeginNode();
         if (m_CurrentToken->type == TokenType::LeftBrace)
         {
             // Consume the left brace.
             auto prev_token = *Consume();
 
-            // Our possible parameter.
-            Statement parameter{};
-
             // If our token is not eof.
             while (m_CurrentToken->IsValid())
             {
                 // Possible parameter definition.
                 if (m_CurrentToken->type == TokenType::Identifier)
                 {
+                    // Our possible parameter.
+                    Node parameter{};
+                    auto param_frame = BeginNode();
+
                     // Consume the identifier.
                     auto ident = *Consume();
 
-                    parameter.name = ident.span.text;
-                    parameter.kind = StatementKind::FunctionParameter;
-                    parameter.tokens.push_back(std::move(ident));
+                    parameter.name  = ident.span.text;
+                    parameter.ident = m_Tree.InternIdentifier(parameter.name);
+                    parameter.kind  = StatementKind::FunctionParameter;
+                    m_TokenStack.push_back(ident);
 
                     // Next, we expect the token to be valid and a colon because
                     // types are defined in the following syntax: identifier: type, ...
@@ -240,7 +418,7 @@ namespace relang::refront {
                             // so throw a compile error and exit.
                             auto type_opt = Type::FromToken(type_token);
                             if (type_opt)
-                                parameter.type = std::move(*type_opt);
+                                parameter.type = m_Tree.InternType(*type_opt);
                             else
                             {
                                 CompileError(type_token, "Expected a type, instead got a {}", type_token.ToString());
@@ -256,11 +434,12 @@ namespace relang::refront {
                         CompileError(*m_CurrentToken, "Expected a type specifier for the parameter.");
                     }
 
-                    // Append our parameter to the function's current symbol table.
-                    m_SymbolTableStack.back().AddSymbol(Symbol{ .name = parameter.name, .statement = parameter });
-
                     // Finally, push our parameter statement to our parameter list.
-                    params.children.push_back(std::move(parameter));
+                    auto param_index = EndNode(param_frame, parameter);
+                    m_ChildStack.push_back(param_index);
+
+                    // Append our parameter to the function's scope.
+                    m_Symbols.Add(parameter.ident, Symbol{ .node = param_index });
                 }
                 else if (m_CurrentToken->type == TokenType::Comma)
                 {
@@ -293,10 +472,10 @@ namespace relang::refront {
         {
             CompileError(*m_CurrentToken, "Expected a parameter list.");
         }
-        return params;
+        return EndNode(frame, params);
     }
 
-    std::optional<Statement> Parser::ExpectLocalStatement()
+    std::optional<NodeIndex> Parser::ExpectLocalStatement()
     {
         // For keywords and block statements we do not want to check for a
         // semicolon because, well, block statements end with the closing curly
@@ -332,7 +511,7 @@ namespace relang::refront {
 
             // If we don't have a result then it is a no-op statement.
             if (!result)
-                return Statement{ .kind = StatementKind::NoOperationStatement };
+                return EndNode(BeginNode(), Node{ .kind = StatementKind::NoOperationStatement });
         }
         else
         {
@@ -342,21 +521,22 @@ namespace relang::refront {
         return result;
     }
 
-    std::optional<ast::Statement> Parser::ExpectBlockStatement()
+    std::optional<NodeIndex> Parser::ExpectBlockStatement()
     {
         // Check for a start of a block statement.
         if (m_CurrentToken->type == TokenType::LeftCurlyBrace)
         {
-            // Create a new symbol table for our compound statement and push it onto the stack.
-            m_SymbolTableStack.push_back(SymbolTable{});
+            // Open a new scope for our compound statement.
+            m_Symbols.PushScope();
 
             // Consume the left curly brace.
             auto brace_token = *Consume();
 
             // Our block statement.
-            Statement block_stmt;
+            Node block_stmt{};
+            auto frame      = BeginNode();
             block_stmt.kind = StatementKind::BlockStatement;
-            block_stmt.tokens.push_back(std::move(brace_token));
+            m_TokenStack.push_back(brace_token);
 
             // Iterate through the tokens until we hit a closing curly brace.
             while (m_CurrentToken->type != TokenType::RightCurlyBrace)
@@ -371,22 +551,22 @@ namespace relang::refront {
                     // Recursevly parse statements and append them to our block statement (if any).
                     auto stmt = ExpectLocalStatement();
                     if (stmt)
-                        block_stmt.children.push_back(std::move(*stmt));
+                        m_ChildStack.push_back(*stmt);
                 }
             }
 
             // Consume the closing curly brace.
             brace_token = *Consume();
-            block_stmt.tokens.push_back(std::move(brace_token));
+            m_TokenStack.push_back(brace_token);
 
-            // Pop our compound statement's symbol table out and finally return our compound statement.
-            m_SymbolTableStack.pop_back();
-            return block_stmt;
+            // Close our compound statement's scope and finally return our compound statement.
+            m_Symbols.PopScope();
+            return EndNode(frame, block_stmt);
         }
         return std::nullopt;
     }
 
-    std::optional<ast::Statement> Parser::ExpectVariableDeclaration()
+    std::optional<NodeIndex> Parser::ExpectVariableDeclaration()
     {
         if (m_CurrentToken->IsValid() && m_CurrentToken.value().type == TokenType::KeywordLet)
         {
@@ -395,16 +575,18 @@ namespace relang::refront {
             Token ident_token{};
 
             // Our variable declaration statement.
-            Statement var_decl{};
+            Node var_decl{};
+            auto frame    = BeginNode();
             var_decl.kind = StatementKind::VariableDeclaration;
-            var_decl.tokens.push_back(std::move(let_token));
+            m_TokenStack.push_back(let_token);
 
             // The following token must be valid and an identifier.
             if (m_CurrentToken->IsValid() && m_CurrentToken.value().type == TokenType::Identifier)
             {
-                ident_token   = *Consume();
-                var_decl.name = ident_token.span.text;
-                var_decl.tokens.push_back(ident_token);
+                ident_token    = *Consume();
+                var_decl.name  = ident_token.span.text;
+                var_decl.ident = m_Tree.InternIdentifier(var_decl.name);
+                m_TokenStack.push_back(ident_token);
             }
             else
             {
@@ -417,6 +599,9 @@ namespace relang::refront {
                 CompileError(*m_CurrentToken, "Expected a colon type specifier.");
             }
 
+            // The variable's type, kept around by value since the checks below need it.
+            Type var_type{};
+
             // The following token now must be a type.
             if (m_CurrentToken->IsValid())
             {
@@ -447,7 +632,8 @@ namespace relang::refront {
                             CompileError(rsq_bracket, "Expected a closing square bracket.");
                         }
                     }
-                    var_decl.type = std::move(*type_opt);
+                    var_type      = std::move(*type_opt);
+                    var_decl.type = m_Tree.InternType(var_type);
                 }
                 else
                 {
@@ -469,9 +655,10 @@ namespace relang::refront {
                     auto equals_token = *Consume();
 
                     // Our initializer statement.
-                    Statement init_stmt{};
-                    init_stmt.tokens.push_back(std::move(equals_token));
-                    init_stmt.kind = StatementKind::Initializer;
+                    Node init_stmt{};
+                    auto init_frame = BeginNode();
+                    init_stmt.kind  = StatementKind::Initializer;
+                    m_TokenStack.push_back(equals_token);
 
                     // Save the token before expression parsing.
                     auto pre_expr_token = *m_CurrentToken;
@@ -480,44 +667,46 @@ namespace relang::refront {
                     auto init_expr = ExpectExpression();
                     if (init_expr)
                     {
+                        const auto& init_node = m_Tree[*init_expr];
+
                         // Check if our variable is an array.
-                        if (var_decl.type.IsArray())
+                        if (var_type.IsArray())
                         {
                             // If the lengths mismatch then it's an error.
-                            if (init_expr->children.size() != var_decl.type.length)
+                            if (init_node.children.count != var_type.length)
                             {
-                                CompileError(init_expr->tokens[0],
+                                CompileError(m_Tree.GetTokens(init_node)[0],
                                              "'{}' is an array of {} elements but is initialized with an initializer "
                                              "list of length {}.",
-                                             var_decl.name, var_decl.type.length, init_expr->children.size());
+                                             var_decl.name, var_type.length, init_node.children.count);
                             }
 
                             // Check if there's a type mismatch.
-                            for (const auto& e : init_expr->children)
+                            for (const auto& e : m_Tree.GetChildren(init_node))
                             {
                                 // Compare the ELEMENT types.
-                                if (e.type.ftype != var_decl.type.ftype)
+                                if (m_Tree.GetType(e).ftype != var_type.ftype)
                                 {
                                     CompileError(
-                                        e.tokens.at(0),
+                                        m_Tree.GetTokens(e)[0],
                                         "Type mistmatch. Cannot perform implicit conversion from '{}' to '{}'.",
-                                        e.type.ToString(), var_decl.type.ToString());
+                                        m_Tree.GetType(e).ToString(), var_type.ToString());
                                 }
                             }
                         }
                         else
                         {
                             // Check if there's a type mismatch between the initializer expression and the variable.
-                            if (init_expr->type != var_decl.type)
+                            if (m_Tree.GetType(init_node) != var_type)
                             {
-                                CompileError(init_stmt.tokens[0],
+                                CompileError(equals_token,
                                              "Type mismatch. Cannot perform implicit conversion from '{}' to '{}'.",
-                                             init_expr->type.ToString(), var_decl.type.ToString());
+                                             m_Tree.GetType(init_node).ToString(), var_type.ToString());
                             }
                         }
 
                         // If we reached here then everything is fine so just append our initializer and move on.
-                        init_stmt.children.push_back(std::move(*init_expr));
+                        m_ChildStack.push_back(*init_expr);
                     }
                     else
                     {
@@ -525,31 +714,30 @@ namespace relang::refront {
                     }
 
                     // Append our initializer statement.
-                    var_decl.children.push_back(std::move(init_stmt));
+                    m_ChildStack.push_back(EndNode(init_frame, init_stmt));
                 }
 
-                // Check if the variable already exists in our block's symbol table.
-                if (m_SymbolTableStack.back().ContainsSymbol(var_decl.name))
+                // Check if the variable already exists in our block's scope.
+                if (const auto* sym = m_Symbols.FindInCurrentScope(var_decl.ident))
                 {
-                    auto& sym          = m_SymbolTableStack.back().GetSymbol(var_decl.name);
-                    auto& redecl_token = sym.statement.tokens[0];
-                    CompileError(var_decl.tokens[0],
+                    auto& redecl_token = m_Tree.GetTokens(m_Tree[sym->node])[0];
+                    CompileError(let_token,
                                  "Redeclaration of an already existing name '{}' in the same context previously "
                                  "defined @ line ({}, {}).",
                                  var_decl.name, redecl_token.span.line, redecl_token.span.cur);
                 }
-                else
-                {
-                    // Append our new variable to our symbol table and return it.
-                    m_SymbolTableStack.back().AddSymbol(Symbol{ .name = ident_token.span.text, .statement = var_decl });
-                }
-                return var_decl;
+
+                // Append our new variable to our scope and return it.
+                auto index = EndNode(frame, var_decl);
+                m_Symbols.Add(var_decl.ident, Symbol{ .node = index });
+                return index;
             }
+            DiscardNode(frame);
         }
         return std::nullopt;
     }
 
-    std::optional<ast::Statement> Parser::ExpectKeyword()
+    std::optional<NodeIndex> Parser::ExpectKeyword()
     {
         // If our token is valid and an actual keyword (obviously).
         if (m_CurrentToken->IsValid() && m_CurrentToken.value().IsKeyword())
@@ -565,9 +753,10 @@ namespace relang::refront {
                     auto if_keyword = *Consume();
 
                     // Our If statement.
-                    Statement if_stmt{};
+                    Node if_stmt{};
+                    auto frame   = BeginNode();
                     if_stmt.kind = StatementKind::IfStatement;
-                    if_stmt.tokens.push_back(std::move(if_keyword));
+                    m_TokenStack.push_back(if_keyword);
 
                     // Save the token.
                     auto pre_cond_token = *m_CurrentToken;
@@ -577,10 +766,10 @@ namespace relang::refront {
                     if (condition)
                     {
                         // Check if the expression type is a boolean.
-                        if (condition->type == Type::Boolean)
+                        if (GetType(*condition) == Type::Boolean)
                         {
                             // Append our condition statement.
-                            if_stmt.children.push_back(std::move(*condition));
+                            m_ChildStack.push_back(*condition);
 
                             // Save the token.
                             auto pre_body_token = *m_CurrentToken;
@@ -588,20 +777,20 @@ namespace relang::refront {
                             // The body for the if statement.
                             auto body_stmt = ExpectLocalStatement();
                             if (body_stmt)
-                                if_stmt.children.push_back(std::move(*body_stmt));
+                                m_ChildStack.push_back(*body_stmt);
                             else
                             {
                                 CompileError(pre_body_token, "Expected a body for the if statement.");
                             }
 
                             // Finally return our if statement.
-                            return if_stmt;
+                            return EndNode(frame, if_stmt);
                         }
                         else
                         {
                             CompileError(pre_cond_token,
                                          "Type mismatch. Cannot perform implicit conversion from '{}' to '{}'.",
-                                         condition->type.ToString(), Type::Boolean.ToString());
+                                         GetType(*condition).ToString(), Type::Boolean.ToString());
                         }
                     }
                     else
@@ -615,9 +804,10 @@ namespace relang::refront {
                     auto while_keyword = *Consume();
 
                     // Our If statement.
-                    Statement while_stmt{};
+                    Node while_stmt{};
+                    auto frame      = BeginNode();
                     while_stmt.kind = StatementKind::WhileStatement;
-                    while_stmt.tokens.push_back(std::move(while_keyword));
+                    m_TokenStack.push_back(while_keyword);
 
                     // Save the token.
                     auto pre_cond_token = *m_CurrentToken;
@@ -627,10 +817,10 @@ namespace relang::refront {
                     if (condition)
                     {
                         // Check if the expression type is a boolean.
-                        if (condition->type == Type::Boolean)
+                        if (GetType(*condition) == Type::Boolean)
                         {
                             // Append our condition statement.
-                            while_stmt.children.push_back(std::move(*condition));
+                            m_ChildStack.push_back(*condition);
 
                             // Save the token.
                             auto pre_body_token = *m_CurrentToken;
@@ -638,20 +828,20 @@ namespace relang::refront {
                             // The body for the if statement.
                             auto body_stmt = ExpectLocalStatement();
                             if (body_stmt)
-                                while_stmt.children.push_back(std::move(*body_stmt));
+                                m_ChildStack.push_back(*body_stmt);
                             else
                             {
                                 CompileError(pre_body_token, "Expected a body for the while statement.");
                             }
 
                             // Finally return our while statement.
-                            return while_stmt;
+                            return EndNode(frame, while_stmt);
                         }
                         else
                         {
                             CompileError(pre_cond_token,
                                          "Type mismatch. Cannot perform implicit conversion from '{}' to '{}'.",
-                                         condition->type.ToString(), Type::Boolean.ToString());
+                                         GetType(*condition).ToString(), Type::Boolean.ToString());
                         }
                     }
                     else
@@ -665,20 +855,21 @@ namespace relang::refront {
                     Consume();
 
                     // The return statement.
-                    Statement stmt{};
-                    stmt.kind = StatementKind::ReturnStatement;
+                    Node stmt{};
+                    auto frame = BeginNode();
+                    stmt.kind  = StatementKind::ReturnStatement;
 
                     // If an expression follows our return statement.
                     auto exp = ExpectExpression();
                     if (exp)
-                        stmt.children.push_back(std::move(*exp));
+                        m_ChildStack.push_back(*exp);
 
                     // Check for the semicolon of course.
                     if (m_CurrentToken->IsValid() && m_CurrentToken.value().type == TokenType::SemiColon)
                     {
                         // Consume the semicolon.
                         Consume();
-                        return stmt;
+                        return EndNode(frame, stmt);
                     }
                     else
                     {
@@ -692,12 +883,12 @@ namespace relang::refront {
         return std::nullopt;
     }
 
-    std::optional<Statement> Parser::ExpectExpression()
+    std::optional<NodeIndex> Parser::ExpectExpression()
     {
         return ExpectCondition();
     }
 
-    std::optional<Statement> Parser::ExpectPrimaryExpression()
+    std::optional<NodeIndex> Parser::ExpectPrimaryExpression()
     {
         // Check if it's a function call expression.
         auto result = ExpectAssignment();
@@ -727,56 +918,38 @@ namespace relang::refront {
         return std::nullopt;
     }
 
-    std::optional<Statement> Parser::ExpectLiteral()
+    std::optional<NodeIndex> Parser::ExpectLiteral()
     {
         // If our token is valid.
         if (m_CurrentToken->IsValid())
         {
             // Check for the type of the literal.
+            std::optional<Type> type{};
             switch (m_CurrentToken->type)
             {
                 using enum TokenType;
 
-                case NumberLiteral: {
-                    auto      token = *Consume();
-                    Statement stmt{};
-                    stmt.kind = StatementKind::LiteralExpression;
-                    stmt.type = Type::Integer64;
-                    stmt.tokens.push_back(std::move(token));
-                    return stmt;
-                }
-                case StringLiteral: {
-                    auto      token = *Consume();
-                    Statement stmt{};
-                    stmt.kind = StatementKind::LiteralExpression;
-                    stmt.type = Type::String(token);
-                    stmt.tokens.push_back(std::move(token));
-                    return stmt;
-                }
-                case CharacterLiteral: {
-                    auto      token = *Consume();
-                    Statement stmt{};
-                    stmt.kind = StatementKind::LiteralExpression;
-                    stmt.type = Type::Character;
-                    stmt.tokens.push_back(std::move(token));
-                    return stmt;
-                }
+                case NumberLiteral: type = Type::Integer64; break;
+                case StringLiteral: type = Type::String(*m_CurrentToken); break;
+                case CharacterLiteral: type = Type::Character; break;
                 case KeywordTrue:
-                case KeywordFalse: {
-                    auto      token = *Consume();
-                    Statement stmt{};
-                    stmt.kind = StatementKind::LiteralExpression;
-                    stmt.type = Type::Boolean;
-                    stmt.tokens.push_back(std::move(token));
-                    return stmt;
-                }
+                case KeywordFalse: type = Type::Boolean; break;
                 default: break;
             }
+
+            if (type)
+            {
+                auto token = *Consume();
+                auto frame = BeginNode();
+                m_TokenStack.push_back(token);
+                return EndNode(frame,
+                               Node{ .kind = StatementKind::LiteralExpression, .type = m_Tree.InternType(*type) });
+            }
         }
         return std::nullopt;
     }
 
-    std::optional<Statement> Parser::ExpectIdentifierName()
+    std::optional<NodeIndex> Parser::ExpectIdentifierName()
     {
         // If the current token is infact an identifier.
         if (m_CurrentToken->IsValid() && m_CurrentToken.value().type == TokenType::Identifier)
@@ -785,33 +958,32 @@ namespace relang::refront {
             auto ident_token = *Consume();
 
             // Create our identifier statement.
-            Statement name_stmt{};
-            name_stmt.kind = StatementKind::IdentifierName;
-            name_stmt.name = ident_token.span.text;
+            Node name_stmt{};
+            name_stmt.kind  = StatementKind::IdentifierName;
+            name_stmt.name  = ident_token.span.text;
+            name_stmt.ident = m_Tree.InternIdentifier(name_stmt.name);
 
-            // Perform a symbol table lookup.
-            for (auto it = m_SymbolTableStack.rbegin(); it != m_SymbolTableStack.rend(); ++it)
-            {
-                const auto& e = *it;
-                if (e.ContainsSymbol(name_stmt.name))
-                    name_stmt.type = e.GetSymbol(name_stmt.name).statement.type;
-            }
+            // Perform a symbol table lookup, the innermost declaration wins.
+            if (const auto* sym = m_Symbols.Find(name_stmt.ident))
+                name_stmt.type = m_Tree[sym->node].type;
 
             // If the type is still void then the lookup most likely failed.
-            if (name_stmt.type.IsVoid())
+            if (m_Tree.GetType(name_stmt).IsVoid())
             {
                 CompileError(ident_token, "The name '{}' does not exist in the current context.", name_stmt.name);
             }
             else
             {
                 // Else everything is fine so return our identifier name reference statement.
-                return name_stmt;
+                auto frame = BeginNode();
+                m_TokenStack.push_back(ident_token);
+                return EndNode(frame, name_stmt);
             }
         }
         return std::nullopt;
     }
 
-    std::optional<Statement> Parser::ExpectInitializerList()
+    std::optional<NodeIndex> Parser::ExpectInitializerList()
     {
         // Check if the token is infact an opening curly brace.
         if (m_CurrentToken->type == TokenType::LeftCurlyBrace)
@@ -820,9 +992,10 @@ namespace relang::refront {
             auto left_curly = *Consume();
 
             // Our initializer list statement.
-            Statement init_list{};
+            Node init_list{};
+            auto frame     = BeginNode();
             init_list.kind = StatementKind::InitializerList;
-            init_list.tokens.push_back(std::move(left_curly));
+            m_TokenStack.push_back(left_curly);
 
             // Parse the tokens until we hit a closing curly brace.
             while (m_CurrentToken->type != TokenType::RightCurlyBrace)
@@ -840,7 +1013,7 @@ namespace relang::refront {
                     {
                         CompileError(*m_CurrentToken, "Expected a closing curly brace.");
                     }
-                    init_list.children.push_back(std::move(*expr));
+                    m_ChildStack.push_back(*expr);
                 }
                 else
                 {
@@ -852,10 +1025,16 @@ namespace relang::refront {
             if (auto closing_curly = *Consume(); closing_curly.IsValid())
             {
                 // Consume and append our closing curly brace to the initializer list statement.
-                init_list.tokens.push_back(closing_curly);
-                init_list.type        = init_list.children.back().type;
-                init_list.type.length = init_list.children.size();
-                return init_list;
+                m_TokenStack.push_back(closing_curly);
+
+                const auto element_count = m_ChildStack.size() - frame.children;
+                if (element_count != 0)
+                {
+                    auto type      = GetType(m_ChildStack.back());
+                    type.length    = element_count;
+                    init_list.type = m_Tree.InternType(type);
+                }
+                return EndNode(frame, init_list);
             }
             else
             {
@@ -865,7 +1044,7 @@ namespace relang::refront {
         return std::nullopt;
     }
 
-    std::optional<ast::Statement> Parser::ExpectFunctionCall()
+    std::optional<NodeIndex> Parser::ExpectFunctionCall()
     {
         // Check for the identifier.
         if (m_CurrentToken->type == TokenType::Identifier)
@@ -876,57 +1055,58 @@ namespace relang::refront {
                 // Now we definitely know that it's a function call.
                 auto ident_token = *Consume();
 
-                // Try and find the function.
-                Statement ref_fn{};
-                for (const auto& fn : m_GlobalStatements)
-                {
-                    if (fn.kind == StatementKind::FunctionDeclaration)
-                    {
-                        if (fn.name == ident_token.span.text)
-                            ref_fn = fn;
-                    }
-                }
+                // Try and find the function, locals do not hide functions.
+                const auto               ident = m_Tree.InternIdentifier(ident_token.span.text);
+                std::optional<NodeIndex> ref_fn{};
+                if (const auto* sym = m_Symbols.FindGlobal(ident))
+                    ref_fn = sym->node;
 
                 // If the function was not found.
-                if (ref_fn.kind == StatementKind::None)
+                if (!ref_fn)
                 {
                     CompileError(ident_token, "The name '{}' does not exist in the current context.",
                                  ident_token.span.text);
                 }
 
                 // Our function call statement.
-                Statement func_call{};
-                func_call.name = ident_token.span.text;
-                func_call.kind = StatementKind::FunctionCallExpression;
-                func_call.type = ref_fn.type;
-                func_call.tokens.push_back(std::move(ident_token));
+                Node func_call{};
+                auto frame     = BeginNode();
+                func_call.name  = ident_token.span.text;
+                func_call.ident = ident;
+                func_call.kind  = StatementKind::FunctionCallExpression;
+                func_call.type = m_Tree[*ref_fn].type;
+                m_TokenStack.push_back(ident_token);
 
                 auto arg_list = ExpectFunctionArgumentList();
 
                 // Check for a type mismatch.
-                for (usize i = 0; i < arg_list.children.size(); ++i)
+                const auto& args   = m_Tree[arg_list];
+                const auto& params = m_Tree.GetChildren(m_Tree[*ref_fn])[0];
+                for (usize i = 0; i < args.children.count; ++i)
                 {
-                    if (arg_list.children[i].type != ref_fn.children[0].children[i].type)
+                    const auto& arg_type   = m_Tree.GetType(m_Tree.GetChildren(args)[i]);
+                    const auto& param_type = m_Tree.GetType(m_Tree.GetChildren(params)[i]);
+                    if (arg_type != param_type)
                     {
                         CompileError(ident_token,
                                      "Cannot perform implicit conversion from '{}' to '{}'. No matching function "
                                      "call to '{}'.",
-                                     arg_list.children[i].type.ToString(),
-                                     ref_fn.children[0].children[i].type.ToString(), func_call.name);
+                                     arg_type.ToString(), param_type.ToString(), func_call.name);
                     }
                 }
 
                 // Finally, return our function call statement.
-                func_call.children.push_back(std::move(arg_list));
-                return func_call;
+                m_ChildStack.push_back(arg_list);
+                return EndNode(frame, func_call);
             }
         }
         return std::nullopt;
     }
 
-    ast::Statement Parser::ExpectFunctionArgumentList()
+    NodeIndex Parser::ExpectFunctionArgumentList()
     {
-        Statement args{};
+        Node args{};
+        auto frame = BeginNode();
         if (m_CurrentToken->type == TokenType::LeftBrace)
         {
             // Consume the left brace.
@@ -950,7 +1130,7 @@ namespace relang::refront {
                     auto expr = ExpectExpression();
                     if (expr)
                     {
-                        args.children.push_back(std::move(*expr));
+                        m_ChildStack.push_back(*expr);
                     }
                     else
                     {
@@ -974,10 +1154,10 @@ namespace relang::refront {
         {
             CompileError(*m_CurrentToken, "Expected an argument list.");
         }
-        return args;
+        return EndNode(frame, args);
     }
 
-    std::optional<ast::Statement> Parser::ExpectAssignment()
+    std::optional<NodeIndex> Parser::ExpectAssignment()
     {
         if (m_CurrentToken->type == TokenType::Identifier)
         {
@@ -994,20 +1174,21 @@ namespace relang::refront {
                 auto rhv = ExpectExpression();
                 if (rhv)
                 {
-                    if (rhv->type == lhv.type)
+                    if (GetType(*rhv) == GetType(lhv))
                     {
-                        Statement assign_expr{};
-                        assign_expr.type = lhv.type;
+                        Node assign_expr{};
+                        auto frame       = BeginNode();
+                        assign_expr.type = m_Tree[lhv].type;
                         assign_expr.kind = StatementKind::AssignmentExpression;
-                        assign_expr.children.push_back(std::move(lhv));
-                        assign_expr.children.push_back(std::move(*rhv));
-                        return assign_expr;
+                        m_ChildStack.push_back(lhv);
+                        m_ChildStack.push_back(*rhv);
+                        return EndNode(frame, assign_expr);
                     }
                     else
                     {
                         CompileError(pre_rhv_token,
                                      "Type mismatch. Cannot perform implicit conversion from '{}' to '{}'.",
-                                     rhv->type.ToString(), lhv.type.ToString());
+                                     GetType(*rhv).ToString(), GetType(lhv).ToString());
                     }
                 }
                 else
@@ -1019,7 +1200,7 @@ namespace relang::refront {
         return std::nullopt;
     }
 
-    std::optional<ast::Statement> Parser::ExpectAddition()
+    std::optional<NodeIndex> Parser::ExpectAddition()
     {
         auto result = ExpectMultiplication();
         while (m_CurrentToken->type == TokenType::Plus || m_CurrentToken->type == TokenType::Minus)
@@ -1028,38 +1209,39 @@ namespace relang::refront {
             auto rhv_expr = ExpectMultiplication();
 
             // Our multiplication expression.
-            Statement binary_expr{};
+            Node binary_expr{};
 
             if (result)
             {
                 binary_expr.kind = (op_token.type == TokenType::Plus) ? StatementKind::AdditionExpression
                                                                       : StatementKind::SubtractionExpression;
-                switch (result->type.ftype)
+                switch (GetType(*result).ftype)
                 {
                     // We support fundamental types for now.
                     using enum FundamentalType;
 
                     case Integer32:
                     case Integer64: {
-                        if (result->type == rhv_expr->type)
+                        if (GetType(*result) == GetType(*rhv_expr))
                         {
-                            binary_expr.type = result->type;
-                            binary_expr.tokens.push_back(std::move(op_token));
-                            binary_expr.children.push_back(std::move(*result));
-                            binary_expr.children.push_back(std::move(*rhv_expr));
-                            result = std::move(binary_expr);
+                            auto frame       = BeginNode();
+                            binary_expr.type = m_Tree[*result].type;
+                            m_TokenStack.push_back(op_token);
+                            m_ChildStack.push_back(*result);
+                            m_ChildStack.push_back(*rhv_expr);
+                            result = EndNode(frame, binary_expr);
                         }
                         else
                         {
                             CompileError(*m_CurrentToken,
                                          "Type mismatch. Cannot perform implicit conversion from '{}' to '{}'.",
-                                         result->type.ToString(), rhv_expr->type.ToString());
+                                         GetType(*result).ToString(), GetType(*rhv_expr).ToString());
                         }
                         break;
                     }
                     default: {
                         CompileError(op_token, "Cannot perform '{}' on type {}.", op_token.span.text,
-                                     result->type.ToString());
+                                     GetType(*result).ToString());
                         break;
                     }
                 }
@@ -1073,7 +1255,7 @@ namespace relang::refront {
         return result;
     }
 
-    std::optional<ast::Statement> Parser::ExpectMultiplication()
+    std::optional<NodeIndex> Parser::ExpectMultiplication()
     {
         auto result = ExpectPrimaryExpression();
         while (m_CurrentToken->type == TokenType::Asterisk || m_CurrentToken->type == TokenType::ForwardSlash)
@@ -1082,39 +1264,40 @@ namespace relang::refront {
             auto rhv_expr = ExpectPrimaryExpression();
 
             // Our multiplication expression.
-            Statement binary_expr{};
+            Node binary_expr{};
 
             if (result)
             {
                 binary_expr.kind = (op_token.type == TokenType::Asterisk) ? StatementKind::MultiplicationExpression
                                                                           : StatementKind::DivisionExpression;
-                switch (result->type.ftype)
+                switch (GetType(*result).ftype)
                 {
                     // We support fundamental types for now.
                     using enum FundamentalType;
 
                     case Integer32:
                     case Integer64: {
-                        if (result->type == rhv_expr->type)
+                        if (GetType(*result) == GetType(*rhv_expr))
                         {
-                            binary_expr.type = result->type;
-                            binary_expr.tokens.push_back(std::move(op_token));
-                            binary_expr.children.push_back(std::move(*result));
-                            binary_expr.children.push_back(std::move(*rhv_expr));
-                            result = std::move(binary_expr);
+                            auto frame       = BeginNode();
+                            binary_expr.type = m_Tree[*result].type;
+                            m_TokenStack.push_back(op_token);
+                            m_ChildStack.push_back(*result);
+                            m_ChildStack.push_back(*rhv_expr);
+                            result = EndNode(frame, binary_expr);
                         }
                         else
                         {
                             CompileError(*m_CurrentToken,
                                          "Type mismatch. Cannot perform implicit conversion from '{}' to '{}'.",
-                                         result->type.ToString(), rhv_expr->type.ToString());
+                                         GetType(*result).ToString(), GetType(*rhv_expr).ToString());
                         }
 
                         break;
                     }
                     default: {
                         CompileError(op_token, "Cannot perform '{}' on type {}.", op_token.span.text,
-                                     result->type.ToString());
+                                     GetType(*result).ToString());
                         break;
                     }
                 }
@@ -1128,7 +1311,7 @@ namespace relang::refront {
         return result;
     }
 
-    std::optional<ast::Statement> Parser::ExpectCondition()
+    std::optional<NodeIndex> Parser::ExpectCondition()
     {
         auto result = ExpectAddition();
 
@@ -1142,7 +1325,7 @@ namespace relang::refront {
             auto rhv_expr = ExpectAddition();
 
             // Our multiplication expression.
-            Statement binary_expr{};
+            Node binary_expr{};
 
             if (result)
             {
@@ -1160,19 +1343,20 @@ namespace relang::refront {
                 }
 
                 // FIXME: This is buggy but whatever.
-                if (result->type == rhv_expr->type)
+                if (GetType(*result) == GetType(*rhv_expr))
                 {
-                    binary_expr.type = Type::Boolean;
-                    binary_expr.tokens.push_back(std::move(op_token));
-                    binary_expr.children.push_back(std::move(*result));
-                    binary_expr.children.push_back(std::move(*rhv_expr));
-                    result = std::move(binary_expr);
+                    auto frame       = BeginNode();
+                    binary_expr.type = m_Tree.InternType(Type::Boolean);
+                    m_TokenStack.push_back(op_token);
+                    m_ChildStack.push_back(*result);
+                    m_ChildStack.push_back(*rhv_expr);
+                    result = EndNode(frame, binary_expr);
                 }
                 else
                 {
                     CompileError(*m_CurrentToken,
                                  "Type mismatch. Cannot perform implicit conversion from '{}' to '{}'.",
-                                 result->type.ToString(), rhv_expr->type.ToString());
+                                 GetType(*result).ToString(), GetType(*rhv_expr).ToString());
                 }
             }
             else
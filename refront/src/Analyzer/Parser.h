@@ -3,10 +3,14 @@
 
 #include <fmt/core.h>
 #include <nlohmann/json.hpp>
+#include <ranges>
+#include <span>
 #include <stack>
+#include <unordered_map>
 #include <vector>
 
 #include "Lexer.h"
+#include "SymbolTable.h"
 
 namespace relang::refront {
     namespace ast {
@@ -105,77 +109,142 @@ namespace relang::refront {
             }
         };
 
-        struct Statement
-        {
-        public:
-            std::string            name{};
-            StatementKind          kind{};
-            std::vector<Statement> children{};
-            Type                   type{};
-            std::vector<Token>     tokens{};
+        using NodeIndex = u32;
+        using TypeIndex = u32;
 
-        public:
-            std::optional<Token> GetToken(const TokenType& type) const noexcept;
-        };
+        constexpr NodeIndex NullNode = ~NodeIndex{};
 
-        using SyntaxTree = std::vector<ast::Statement>;
+        // A [begin, begin + count) slice of one of the syntax tree's flat arrays.
+        struct NodeRange
+        {
+            u32 begin{};
+            u32 count{};
+        };
 
-        struct Symbol
+        // Nodes own no memory, children and tokens are ranges into the tree's arrays, the name is a view into the
+        // source and the type an index into the tree's type table. Names that refer to a symbol are also interned.
+        struct Node
         {
-            std::string    name{};
-            ast::Statement statement;
+        public:
+            StatementKind    kind{};
+            TypeIndex        type{};
+            IdentId          ident = NoIdent;
+            std::string_view name{};
+            NodeRange        children{};
+            NodeRange        tokens{};
         };
 
-        struct SymbolTable
+        // Names and token texts are views into the parsed source, which must outlive the tree.
+        class SyntaxTree
         {
         private:
-            std::unordered_map<std::string, Symbol> m_Symbols{};
+            std::vector<Node>                          m_Nodes{};
+            std::vector<NodeIndex>                     m_Children{};
+            std::vector<Token>                         m_Tokens{};
+            std::vector<Type>                          m_Types{};
+            std::unordered_map<std::string, TypeIndex> m_TypeIndices{};
+            std::vector<NodeIndex>                     m_Globals{};
+            IdentifierTable                            m_Identifiers{};
 
         public:
-            void          AddSymbol(Symbol symbol) noexcept;
-            bool          ContainsSymbol(const std::string& name) const noexcept;
-            Symbol&       GetSymbol(const std::string& name) noexcept;
-            const Symbol& GetSymbol(const std::string& name) const noexcept;
+            SyntaxTree();
+
+        public:
+            inline usize       GetNodeCount() const noexcept { return m_Nodes.size(); }
+            inline const Node& operator[](const NodeIndex index) const noexcept { return m_Nodes[index]; }
+            inline NodeIndex   IndexOf(const Node& node) const noexcept { return (NodeIndex)(&node - m_Nodes.data()); }
+            inline const Type& GetType(const Node& node) const noexcept { return m_Types[node.type]; }
+            inline std::span<const Token> GetTokens(const Node& node) const noexcept
+            {
+                return std::span<const Token>{ m_Tokens }.subspan(node.tokens.begin, node.tokens.count);
+            }
+            inline auto GetChildren(const Node& node) const noexcept
+            {
+                return std::span<const NodeIndex>{ m_Children }.subspan(node.children.begin, node.children.count) |
+                       std::views::transform([this](const NodeIndex i) -> const Node& { return m_Nodes[i]; });
+            }
+            inline auto GetGlobals() const noexcept
+            {
+                return std::span<const NodeIndex>{ m_Globals } |
+                       std::views::transform([this](const NodeIndex i) -> const Node& { return m_Nodes[i]; });
+            }
+            inline const IdentifierTable& GetIdentifiers() const noexcept { return m_Identifiers; }
+
+        public:
+            NodeIndex            AddNode(const Node& node, std::span<const NodeIndex> children,
+                                         std::span<const Token> tokens);
+            NodeIndex            ImportDeclaration(const SyntaxTree& module, const Node& fn);
+            void                 AddGlobal(const NodeIndex index);
+            TypeIndex            InternType(const Type& type);
+            IdentId              InternIdentifier(const std::string_view name);
+            std::optional<Token> GetFirstToken(const Node& node) const noexcept;
+            std::optional<Token> GetToken(const Node& node, const TokenType& type) const noexcept;
+
+            friend class TreeWriter;
+            friend class TreeReader;
+        };
+
+        struct Symbol
+        {
+            NodeIndex node = NullNode; // The declaration.
         };
     } // namespace ast
 
     class Parser
     {
     private:
-        std::string_view              m_Source{};
-        Lexer                         m_Lexer{};
-        std::optional<Token>          m_CurrentToken{};
-        std::vector<ast::Statement>   m_GlobalStatements{};
-        std::vector<ast::SymbolTable> m_SymbolTableStack{};
+        // Marks where a node under construction starts on the parser's child and token stacks.
+        struct NodeFrame
+        {
+            usize children{};
+            usize tokens{};
+        };
+
+    private:
+        std::string_view               m_Source{};
+        TokenStream                    m_Tokens{}; // What follows the current token.
+        std::optional<Token>           m_CurrentToken{};
+        ast::SyntaxTree                m_Tree{};
+        std::vector<ast::NodeIndex>    m_ChildStack{};
+        std::vector<Token>             m_TokenStack{};
+        ScopedSymbolTable<ast::Symbol> m_Symbols{}; // Functions in the outermost scope, then parameters and locals.
 
     public:
         explicit Parser(const std::string_view source) noexcept;
 
     public:
-        std::vector<ast::Statement> Parse();
+        void            Import(const ast::SyntaxTree& module);
+        ast::SyntaxTree Parse();
+
+    public:
+        static std::vector<std::string_view> ScanImports(const std::string_view source);
 
     private:
         std::optional<Token>          Consume() noexcept;
-        std::optional<Token>          Peek() noexcept;
-        std::optional<ast::Statement> GetStatement(const ast::StatementKind kind) const noexcept;
-        std::optional<ast::Statement> ExpectFunctionDecl();
-        std::optional<ast::Statement> ExpectImportDirective();
-        ast::Statement                ExpectFunctionParameterList();
-        std::optional<ast::Statement> ExpectLocalStatement();
-        std::optional<ast::Statement> ExpectBlockStatement();
-        std::optional<ast::Statement> ExpectVariableDeclaration();
-        std::optional<ast::Statement> ExpectKeyword();
-        std::optional<ast::Statement> ExpectExpression();
-        std::optional<ast::Statement> ExpectPrimaryExpression();
-        std::optional<ast::Statement> ExpectLiteral();
-        std::optional<ast::Statement> ExpectIdentifierName();
-        std::optional<ast::Statement> ExpectInitializerList();
-        std::optional<ast::Statement> ExpectFunctionCall();
-        ast::Statement                ExpectFunctionArgumentList();
-        std::optional<ast::Statement> ExpectAssignment();
-        std::optional<ast::Statement> ExpectAddition();
-        std::optional<ast::Statement> ExpectCondition();
-        std::optional<ast::Statement> ExpectMultiplication();
+        std::optional<Token>          Peek(const usize distance = 1);
+        NodeFrame                     BeginNode() const noexcept;
+        ast::NodeIndex                EndNode(const NodeFrame& frame, const ast::Node& node);
+        void                          DiscardNode(const NodeFrame& frame) noexcept;
+        const ast::Type&              GetType(const ast::NodeIndex index) const noexcept;
+        std::optional<ast::NodeIndex> GetStatement(const ast::StatementKind kind) const noexcept;
+        std::optional<ast::NodeIndex> ExpectFunctionDecl();
+        std::optional<ast::NodeIndex> ExpectImportDirective();
+        ast::NodeIndex                ExpectFunctionParameterList();
+        std::optional<ast::NodeIndex> ExpectLocalStatement();
+        std::optional<ast::NodeIndex> ExpectBlockStatement();
+        std::optional<ast::NodeIndex> ExpectVariableDeclaration();
+        std::optional<ast::NodeIndex> ExpectKeyword();
+        std::optional<ast::NodeIndex> ExpectExpression();
+        std::optional<ast::NodeIndex> ExpectPrimaryExpression();
+        std::optional<ast::NodeIndex> ExpectLiteral();
+        std::optional<ast::NodeIndex> ExpectIdentifierName();
+        std::optional<ast::NodeIndex> ExpectInitializerList();
+        std::optional<ast::NodeIndex> ExpectFunctionCall();
+        ast::NodeIndex                ExpectFunctionArgumentList();
+        std::optional<ast::NodeIndex> ExpectAssignment();
+        std::optional<ast::NodeIndex> ExpectAddition();
+        std::optional<ast::NodeIndex> ExpectCondition();
+        std::optional<ast::NodeIndex> ExpectMultiplication();
     };
 } // namespace relang::refront
 
@@ -265,15 +334,29 @@ namespace nlohmann {
     };
 
     template <>
-    struct adl_serializer<relang::refront::ast::Statement>
+    struct adl_serializer<relang::refront::ast::SyntaxTree>
     {
-        static void to_json(ordered_json& j, const relang::refront::ast::Statement& s)
+        static void to_json(ordered_json& j, const relang::refront::ast::SyntaxTree& tree)
+        {
+            j = ordered_json::array();
+            for (const auto& s : tree.GetGlobals())
+                j.push_back(NodeToJson(tree, s));
+        }
+
+        static ordered_json NodeToJson(const relang::refront::ast::SyntaxTree& tree,
+                                       const relang::refront::ast::Node&       s)
         {
-            j["name"]     = s.name;
+            ordered_json j;
+            j["name"]     = std::string{ s.name };
             j["kind"]     = s.kind;
-            j["children"] = s.children;
-            j["type"]     = s.type;
-            j["tokens"]   = s.tokens;
+            j["children"] = ordered_json::array();
+            for (const auto& c : tree.GetChildren(s))
+                j["children"].push_back(NodeToJson(tree, c));
+            j["type"]   = tree.GetType(s);
+            j["tokens"] = ordered_json::array();
+            for (const auto& t : tree.GetTokens(s))
+                j["tokens"].push_back(t);
+            return j;
         }
     };
 } // namespace nlohmann
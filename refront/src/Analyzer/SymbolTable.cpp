@@ -0,0 +1,11 @@
+#include "SymbolTable.h"
+
+namespace relang::refront {
+    IdentId IdentifierTable::Intern(const std::string_view name)
+    {
+        auto [it, inserted] = m_Ids.try_emplace(name, (IdentId)m_Names.size());
+        if (inserted)
+            m_Names.push_back(name);
+        return it->second;
+    }
+} // namespace relang::refront
@@ -0,0 +1,105 @@
+#ifndef CMC_ANALYZER_SYMBOL_TABLE_H
+#define CMC_ANALYZER_SYMBOL_TABLE_H
+
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <CommonDef.h>
+
+namespace relang::refront {
+    // Identifiers are interned per syntax tree, the parser hashes a name once and everything after works on the id.
+    using IdentId = u32;
+
+    constexpr IdentId NoIdent = ~IdentId{};
+
+    class IdentifierTable
+    {
+    private:
+        std::unordered_map<std::string_view, IdentId> m_Ids{};
+        std::vector<std::string_view>                 m_Names{}; // Views into the source, like the tree's names.
+
+    public:
+        inline usize            GetCount() const noexcept { return m_Names.size(); }
+        inline std::string_view GetName(const IdentId id) const noexcept { return m_Names[id]; }
+
+    public:
+        IdentId Intern(const std::string_view name);
+    };
+
+    // Every scope's symbols in one table indexed by identifier. Each id points at its innermost binding, which
+    // remembers the binding it shadows, so a lookup is an index rather than a hash per scope and leaving a scope
+    // only restores the names it bound.
+    template <typename T>
+    class ScopedSymbolTable
+    {
+    private:
+        static constexpr u32 NoBinding = ~u32{};
+
+        struct Binding
+        {
+            T       symbol{};
+            IdentId id{};
+            u32     shadowed{}; // The binding of the same id this one hides.
+        };
+
+    private:
+        std::vector<u32>     m_Innermost{}; // Per identifier.
+        std::vector<Binding> m_Bindings{};
+        std::vector<u32>     m_Scopes{}; // Where each open scope's bindings start.
+
+    public:
+        inline void PushScope() { m_Scopes.push_back((u32)m_Bindings.size()); }
+        inline void PopScope()
+        {
+            for (; m_Bindings.size() != m_Scopes.back(); m_Bindings.pop_back())
+                m_Innermost[m_Bindings.back().id] = m_Bindings.back().shadowed;
+            m_Scopes.pop_back();
+        }
+
+        // Binding a name twice in the same scope replaces the first binding.
+        inline void Add(const IdentId id, T symbol)
+        {
+            if (id >= m_Innermost.size())
+                m_Innermost.resize(id + 1, NoBinding);
+            if (auto* bound = FindInCurrentScope(id))
+            {
+                *bound = std::move(symbol);
+                return;
+            }
+            m_Bindings.push_back(Binding{ .symbol = std::move(symbol), .id = id, .shadowed = m_Innermost[id] });
+            m_Innermost[id] = (u32)m_Bindings.size() - 1;
+        }
+
+        inline T* Find(const IdentId id) noexcept
+        {
+            if (id >= m_Innermost.size() || m_Innermost[id] == NoBinding)
+                return nullptr;
+            return &m_Bindings[m_Innermost[id]].symbol;
+        }
+
+        inline T* FindInCurrentScope(const IdentId id) noexcept
+        {
+            if (id >= m_Innermost.size() || m_Innermost[id] == NoBinding || m_Innermost[id] < m_Scopes.back())
+                return nullptr;
+            return &m_Bindings[m_Innermost[id]].symbol;
+        }
+
+        // Looks past whatever shadows the name for its binding in the outermost scope.
+        inline T* FindGlobal(const IdentId id) noexcept
+        {
+            if (id >= m_Innermost.size() || m_Innermost[id] == NoBinding)
+                return nullptr;
+
+            auto binding = m_Innermost[id];
+            while (m_Bindings[binding].shadowed != NoBinding)
+                binding = m_Bindings[binding].shadowed;
+            return (binding < GlobalEnd()) ? &m_Bindings[binding].symbol : nullptr;
+        }
+
+    private:
+        inline usize GlobalEnd() const noexcept { return (m_Scopes.size() < 2) ? m_Bindings.size() : m_Scopes[1]; }
+    };
+} // namespace relang::refront
+
+#endif // CMC_ANALYZER_SYMBOL_TABLE_H
@@ -0,0 +1,221 @@
+#include "TreeFile.h"
+
+namespace relang::refront::ast {
+    namespace {
+        static_assert(sizeof(TreeFileHeader) % 8 == 0 && sizeof(NodeRecord) == 40 && sizeof(TokenRecord) == 32 &&
+                          sizeof(TypeRecord) == 24,
+                      "Tree file records are laid out by hand.");
+
+        constexpr usize Align(const usize offset) noexcept
+        {
+            return (offset + 7) & ~usize{ 7 };
+        }
+
+        template <typename T>
+        void WriteRecord(std::ostream& stream, const T& record)
+        {
+            stream.write((const char*)&record, sizeof(T));
+        }
+
+        void WriteIndices(std::ostream& stream, const std::vector<NodeIndex>& indices)
+        {
+            stream.write((const char*)indices.data(), indices.size() * sizeof(NodeIndex));
+            for (usize i = indices.size() * sizeof(NodeIndex); i != Align(i); ++i)
+                stream.put('\0');
+        }
+
+        // Hands out consecutive slices of the string blob, in the order the strings are written in.
+        struct StringAllocator
+        {
+            u64 size{};
+
+            StringRef operator()(const std::string_view text) noexcept
+            {
+                const auto ref = StringRef{ .offset = (u32)size, .size = (u32)text.size() };
+                size += text.size();
+                return ref;
+            }
+        };
+
+        // Reads count records at offset if they fit, advancing offset past the section.
+        template <typename T>
+        bool TakeSection(std::span<const u8> bytes, usize& offset, const usize count, std::span<const T>& section)
+        {
+            if (offset + count * sizeof(T) > bytes.size())
+                return false;
+            section = std::span<const T>{ (const T*)(bytes.data() + offset), count };
+            offset  = Align(offset + count * sizeof(T));
+            return true;
+        }
+    } // namespace
+
+    bool TreeWriter::Write(const SyntaxTree& tree, std::ostream& stream)
+    {
+        // Every string is written once per reference: node names, token texts, type names, then identifiers.
+        const auto&     identifiers = tree.m_Identifiers;
+        StringAllocator strings{};
+        for (const auto& node : tree.m_Nodes)
+            strings(node.name);
+        for (const auto& token : tree.m_Tokens)
+            strings(token.span.text);
+        for (const auto& type : tree.m_Types)
+            strings(type.name);
+        for (usize i = 0; i < identifiers.GetCount(); ++i)
+            strings(identifiers.GetName((IdentId)i));
+
+        const auto header = TreeFileHeader{ .nodeCount       = (u32)tree.m_Nodes.size(),
+                                            .childCount      = (u32)tree.m_Children.size(),
+                                            .tokenCount      = (u32)tree.m_Tokens.size(),
+                                            .typeCount       = (u32)tree.m_Types.size(),
+                                            .globalCount     = (u32)tree.m_Globals.size(),
+                                            .identifierCount = (u32)identifiers.GetCount(),
+                                            .stringsSize     = strings.size };
+        if (strings.size > ~u32{})
+            return false;
+        WriteRecord(stream, header);
+
+        strings = StringAllocator{};
+        for (const auto& node : tree.m_Nodes)
+        {
+            WriteRecord(stream, NodeRecord{ .kind     = node.kind,
+                                            .type     = node.type,
+                                            .ident    = node.ident,
+                                            .name     = strings(node.name),
+                                            .children = node.children,
+                                            .tokens   = node.tokens });
+        }
+        WriteIndices(stream, tree.m_Children);
+
+        for (const auto& token : tree.m_Tokens)
+        {
+            WriteRecord(stream, TokenRecord{ .type = token.type,
+                                             .line = token.span.line,
+                                             .cur  = token.span.cur,
+                                             .text = strings(token.span.text),
+                                             .num  = token.num });
+        }
+
+        for (const auto& type : tree.m_Types)
+        {
+            WriteRecord(stream, TypeRecord{ .name   = strings(type.name),
+                                            .length = type.length,
+                                            .ftype  = type.ftype,
+                                            .size   = type.size });
+        }
+        WriteIndices(stream, tree.m_Globals);
+
+        for (usize i = 0; i < identifiers.GetCount(); ++i)
+            WriteRecord(stream, strings(identifiers.GetName((IdentId)i)));
+
+        for (const auto& node : tree.m_Nodes)
+            stream << node.name;
+        for (const auto& token : tree.m_Tokens)
+            stream << token.span.text;
+        for (const auto& type : tree.m_Types)
+            stream << type.name;
+        for (usize i = 0; i < identifiers.GetCount(); ++i)
+            stream << identifiers.GetName((IdentId)i);
+        return (bool)stream;
+    }
+
+    TreeReader::TreeReader(const std::span<const u8> bytes) noexcept
+    {
+        if (bytes.size() < sizeof(TreeFileHeader) || (uintptr_t)bytes.data() % 8 != 0)
+            return;
+
+        const auto* header = (const TreeFileHeader*)bytes.data();
+        if (header->magic != TREE_FILE_MAGIC || header->version != TREE_FILE_VERSION)
+            return;
+
+        usize offset = sizeof(TreeFileHeader);
+        if (!TakeSection(bytes, offset, header->nodeCount, m_Nodes) ||
+            !TakeSection(bytes, offset, header->childCount, m_Children) ||
+            !TakeSection(bytes, offset, header->tokenCount, m_Tokens) ||
+            !TakeSection(bytes, offset, header->typeCount, m_Types) ||
+            !TakeSection(bytes, offset, header->globalCount, m_Globals) ||
+            !TakeSection(bytes, offset, header->identifierCount, m_Identifiers) ||
+            offset + header->stringsSize > bytes.size())
+            return;
+
+        m_Strings = std::string_view{ (const char*)bytes.data() + offset, header->stringsSize };
+        m_Header  = header;
+    }
+
+    std::optional<SyntaxTree> TreeReader::Read() const
+    {
+        if (!IsValid())
+            return std::nullopt;
+
+        // The file may come from anywhere, so every index and slice is checked before the tree gets to rely on it.
+        const auto string = [&](const StringRef ref) { return (u64)ref.offset + ref.size <= m_Strings.size(); };
+        const auto range  = [](const NodeRange range, const usize size)
+        { return (u64)range.begin + range.count <= size; };
+
+        SyntaxTree tree{};
+        tree.m_Types.clear();
+        tree.m_TypeIndices.clear();
+        for (const auto& record : m_Types)
+        {
+            if (!string(record.name) || record.ftype > FundamentalType::UserDefined)
+                return std::nullopt;
+
+            // Types are unique within a tree, interning them again keeps every index where it was.
+            const auto type = Type{ .name   = std::string{ GetString(record.name) },
+                                    .ftype  = record.ftype,
+                                    .length = record.length,
+                                    .size   = record.size };
+            if (tree.InternType(type) != tree.m_Types.size() - 1)
+                return std::nullopt;
+        }
+
+        tree.m_Tokens.reserve(m_Tokens.size());
+        for (const auto& record : m_Tokens)
+        {
+            if (!string(record.text) || record.type > TokenType::Eof)
+                return std::nullopt;
+            tree.m_Tokens.push_back(Token{
+                .type = record.type,
+                .span = TextSpan{ .line = record.line, .cur = record.cur, .text = GetString(record.text) },
+                .num  = record.num });
+        }
+
+        // Interning the names again in id order has to hand out the same ids, which also rules out duplicates.
+        for (usize i = 0; i < m_Identifiers.size(); ++i)
+        {
+            if (!string(m_Identifiers[i]) || tree.InternIdentifier(GetString(m_Identifiers[i])) != i)
+                return std::nullopt;
+        }
+
+        tree.m_Nodes.reserve(m_Nodes.size());
+        for (const auto& record : m_Nodes)
+        {
+            if (!string(record.name) || record.kind > StatementKind::LiteralExpression ||
+                record.type >= m_Types.size() || (record.ident != NoIdent && record.ident >= m_Identifiers.size()) ||
+                !range(record.children, m_Children.size()) ||
+                !range(record.tokens, m_Tokens.size()))
+                return std::nullopt;
+
+            // Children are always added before their parent, which also rules out cycles.
+            for (const auto child : m_Children.subspan(record.children.begin, record.children.count))
+            {
+                if (child >= tree.m_Nodes.size())
+                    return std::nullopt;
+            }
+            tree.m_Nodes.push_back(Node{ .kind     = record.kind,
+                                         .type     = record.type,
+                                         .ident    = record.ident,
+                                         .name     = GetString(record.name),
+                                         .children = record.children,
+                                         .tokens   = record.tokens });
+        }
+
+        for (const auto index : m_Globals)
+        {
+            if (index >= m_Nodes.size())
+                return std::nullopt;
+        }
+        tree.m_Children.assign(m_Children.begin(), m_Children.end());
+        tree.m_Globals.assign(m_Globals.begin(), m_Globals.end());
+        return tree;
+    }
+} // namespace relang::refront::ast
@@ -0,0 +1,111 @@
+#ifndef CMC_ANALYZER_TREE_FILE_H
+#define CMC_ANALYZER_TREE_FILE_H
+
+#include <ostream>
+#include <span>
+
+#include "Parser.h"
+
+namespace relang::refront::ast {
+    // A syntax tree on disk (.rfa). The tree's flat arrays are written out as fixed size records, each section 8 byte
+    // aligned, followed by one blob holding every name and token text. A reader can use a mapped file in place,
+    // names are views into it just like they are views into the source of a parsed tree.
+    //
+    // header | nodes | children | tokens | types | globals | identifiers | strings
+    constexpr u32 TREE_FILE_MAGIC   = 0x41465200; // "\0RFA"
+    constexpr u32 TREE_FILE_VERSION = 3;
+
+    struct TreeFileHeader
+    {
+        u32 magic   = TREE_FILE_MAGIC;
+        u32 version = TREE_FILE_VERSION;
+        u32 nodeCount{};
+        u32 childCount{};
+        u32 tokenCount{};
+        u32 typeCount{};
+        u32 globalCount{};
+        u32 identifierCount{};
+        u64 stringsSize{};
+    };
+
+    // A [offset, offset + size) slice of the string blob.
+    struct StringRef
+    {
+        u32 offset{};
+        u32 size{};
+    };
+
+    struct NodeRecord
+    {
+        StatementKind kind{};
+        u8            reserved[3]{};
+        TypeIndex     type{};
+        IdentId       ident = NoIdent;
+        StringRef     name{};
+        NodeRange     children{};
+        NodeRange     tokens{};
+        u32           reserved2{}; // Keeps the record, and so the sections after it, 8 byte aligned.
+    };
+
+    struct TokenRecord
+    {
+        TokenType type{};
+        u32       line{};
+        u32       cur{};
+        StringRef text{};
+        u32       reserved{};
+        i64       num{};
+    };
+
+    // User defined types are referred to by name only, their fields are not kept.
+    struct TypeRecord
+    {
+        StringRef       name{};
+        u64             length{};
+        FundamentalType ftype{};
+        i8              size{};
+        u8              reserved[6]{};
+    };
+
+    class TreeWriter
+    {
+    public:
+        // Writes the records out as it goes, the strings are gathered in a second pass instead of being buffered.
+        static bool Write(const SyntaxTree& tree, std::ostream& stream);
+    };
+
+    class TreeReader
+    {
+    private:
+        const TreeFileHeader*        m_Header = nullptr; // Null when the bytes do not hold a tree.
+        std::span<const NodeRecord>  m_Nodes{};
+        std::span<const NodeIndex>   m_Children{};
+        std::span<const TokenRecord> m_Tokens{};
+        std::span<const TypeRecord>  m_Types{};
+        std::span<const NodeIndex>   m_Globals{};
+        std::span<const StringRef>   m_Identifiers{}; // In id order.
+        std::string_view             m_Strings{};
+
+    public:
+        // The bytes have to be 8 byte aligned and outlive the reader along with any tree read from it.
+        explicit TreeReader(std::span<const u8> bytes) noexcept;
+
+    public:
+        inline bool                         IsValid() const noexcept { return m_Header != nullptr; }
+        inline std::span<const NodeRecord>  GetNodes() const noexcept { return m_Nodes; }
+        inline std::span<const NodeIndex>   GetChildren() const noexcept { return m_Children; }
+        inline std::span<const TokenRecord> GetTokens() const noexcept { return m_Tokens; }
+        inline std::span<const TypeRecord>  GetTypes() const noexcept { return m_Types; }
+        inline std::span<const NodeIndex>   GetGlobals() const noexcept { return m_Globals; }
+        inline std::span<const StringRef>   GetIdentifiers() const noexcept { return m_Identifiers; }
+        inline std::string_view             GetString(const StringRef ref) const noexcept
+        {
+            return m_Strings.substr(ref.offset, ref.size);
+        }
+
+    public:
+        std::optional<SyntaxTree> Read() const;
+    };
+} // namespace relang::refront::ast
+
+#endif // CMC_ANALYZER_TREE_FILE_H
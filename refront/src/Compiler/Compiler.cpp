@@ -1,8 +1,14 @@
 #include "Compiler.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <optional>
+
 namespace relang::refront {
     using ast::FundamentalType;
-    using ast::Statement;
+    using ast::Node;
     using ast::StatementKind;
     using ast::SyntaxTree;
     using ast::Type;
@@ -10,34 +16,64 @@ namespace relang::refront {
     using namespace relang::blend;
 
     namespace codegen {
-        void SymbolTable::AddSymbol(Symbol symbol) noexcept
+        void CompiledCode::BuildLineTable(const ast::SyntaxTree& tree)
         {
-            m_Symbol[symbol.name] = std::move(symbol);
-            m_Offset += symbol.size;
-        }
+            m_LineTable.clear();
+            for (usize i = 0; i < m_DebugNodes.size(); ++i)
+            {
+                if (m_DebugNodes[i] == ast::NullNode)
+                    continue;
 
-        bool SymbolTable::ContainsSymbol(const std::string& name) const noexcept
-        {
-            return m_Symbol.contains(name);
-        }
+                auto token = tree.GetFirstToken(tree[m_DebugNodes[i]]);
+                if (!token)
+                    continue;
 
-        Symbol& SymbolTable::GetSymbol(const std::string& name) noexcept
-        {
-            return m_Symbol[name];
+                // Only start a new row when the location changes, consecutive instructions mostly share one.
+                const auto& span = token->span;
+                if (m_LineTable.empty() || m_LineTable.back().line != span.line || m_LineTable.back().cur != span.cur)
+                    m_LineTable.push_back(LineEntry{ .index = (u32)i, .line = span.line, .cur = span.cur });
+            }
         }
 
-        const Symbol& SymbolTable::GetSymbol(const std::string& name) const noexcept
+        bool CompiledCode::WriteToBinary(const std::string& path) const
         {
-            return ((SymbolTable*)this)->GetSymbol(name);
+            std::ofstream fs(path, std::ios::binary);
+            if (!fs.is_open())
+                return false;
+
+            u8    indic             = blend::DATA_SECTION_INDIC;
+            usize data_section_size = m_Data.size() * sizeof(u8);
+            usize code_section_size = m_Code.size() * sizeof(blend::Instruction);
+            usize line_table_size   = m_LineTable.size() * sizeof(LineEntry);
+
+            fs.write((const char*)&indic, sizeof(u8));
+            fs.write((const char*)&data_section_size, sizeof(usize));
+            fs.write((const char*)m_Data.data(), data_section_size);
+
+            indic = blend::BSS_SECTION_INDIC;
+            fs.write((const char*)&indic, sizeof(u8));
+            fs.write((const char*)&m_BssSize, sizeof(usize));
+
+            indic = blend::CODE_SECTION_INDIC;
+            fs.write((const char*)&indic, sizeof(u8));
+            fs.write((const char*)&code_section_size, sizeof(usize));
+            fs.write((const char*)m_Code.data(), code_section_size);
+
+            indic = blend::LINE_TABLE_SECTION_INDIC;
+            fs.write((const char*)&indic, sizeof(u8));
+            fs.write((const char*)&line_table_size, sizeof(usize));
+            fs.write((const char*)m_LineTable.data(), line_table_size);
+            return true;
         }
 
-        std::pair<blend::Instruction, ast::Statement> MakeInst(const blend::Instruction& inst,
-                                                               const ast::Statement&     stmt) noexcept
+        std::pair<blend::Instruction, ast::NodeIndex> MakeInst(const blend::Instruction& inst,
+                                                               const ast::NodeIndex      node) noexcept
         {
-            return std::pair<blend::Instruction, ast::Statement>{ inst, stmt };
+            return std::pair<blend::Instruction, ast::NodeIndex>{ inst, node };
         }
     } // namespace codegen
 
+
     using namespace codegen;
 
     RegType GetReg(const u8 idx) noexcept
@@ -46,297 +82,873 @@ namespace relang::refront {
         return r + idx;
     }
 
-    Compiler::Compiler(SyntaxTree tree) : m_Tree(std::move(tree))
-    {
-    }
+    namespace {
+        // R0 carries return values and the dividend, R3 receives the remainder and R1/R2 hold spilled operands for
+        // the duration of a single instruction. The rest is handed to the register allocator.
+        constexpr RegType ScratchA = RegType::R1;
+        constexpr RegType ScratchB = RegType::R2;
 
-    CompiledCode Compiler::Compile()
-    {
-        for (const auto& s : m_Tree)
+        const auto RegisterPool = []
+        {
+            std::vector<RegType> pool{};
+            for (u8 i = RegType::R4; i <= RegType::R31; ++i)
+                pool.push_back(GetReg(i));
+            return pool;
+        }();
+
+        // Calls to these are lowered to the print instructions, their declarations only exist to satisfy the parser.
+        bool IsBuiltin(const std::string_view name) noexcept
         {
-            switch (s.kind)
+            return name == "printi64" || name == "printstr";
+        }
+
+        std::optional<ir::Condition> GetCondition(const StatementKind kind) noexcept
+        {
+            switch (kind)
             {
                 using enum StatementKind;
 
-                case FunctionDeclaration: CompileFunctionBody(s); break;
+                case EqualsExpression: return ir::Condition::Equal;
+                case NotEqualsExpression: return ir::Condition::NotEqual;
+                case GreaterExpression: return ir::Condition::Greater;
+                case LesserExpression: return ir::Condition::Less;
+                case GreaterThanExpression:
+                case GreaterThanOrEqualExpression: return ir::Condition::GreaterEqual;
+                case LesserThanExpression:
+                case LesserThanOrEqualExpression: return ir::Condition::LessEqual;
+                default: return std::nullopt;
+            }
+        }
 
-                default: break;
+        // The VM derives the overflow flag of a subtraction with the addition formula, which breaks its signed
+        // jumps, so every condition is turned into a zero or sign test of op1 - op2 with the operands ordered to
+        // suit. Returns the compare and the jump taken when the condition holds.
+        std::pair<Instruction, OpCode> MakeCompare(const ir::Condition cond, const RegType lhs,
+                                                   const RegType rhs) noexcept
+        {
+            switch (cond)
+            {
+                using enum ir::Condition;
+
+                case Equal: return { { .opcode = OpCode::Cmp, .sreg = rhs, .dreg = lhs }, OpCode::Jz };
+                case NotEqual: return { { .opcode = OpCode::Cmp, .sreg = rhs, .dreg = lhs }, OpCode::Jnz };
+                case Less: return { { .opcode = OpCode::Cmp, .sreg = rhs, .dreg = lhs }, OpCode::Js };
+                case GreaterEqual: return { { .opcode = OpCode::Cmp, .sreg = rhs, .dreg = lhs }, OpCode::Jns };
+                case Greater: return { { .opcode = OpCode::Cmp, .sreg = lhs, .dreg = rhs }, OpCode::Js };
+                case LessEqual: return { { .opcode = OpCode::Cmp, .sreg = lhs, .dreg = rhs }, OpCode::Jns };
             }
+            return { { .opcode = OpCode::Cmp, .sreg = rhs, .dreg = lhs }, OpCode::Jz };
         }
-        m_CompiledCode << MakeInst({ .opcode = OpCode::End });
-        return m_CompiledCode;
-    }
 
-    void Compiler::CompileFunctionBody(const Statement& fnStmt)
-    {
-        for (const auto& s : fnStmt.children)
+        // The operand of pushm and popm, or the frame instructions' disp, for a set of registers.
+        u64 GetRegisterMask(const std::span<const RegType> regs) noexcept
+        {
+            u64 mask = 0;
+            for (const auto reg : regs)
+                mask |= u64{ 1 } << reg;
+            return mask;
+        }
+
+        i32 GetSlotOffset(const i32 slot) noexcept
+        {
+            // Spill slots sit right below the saved frame pointer.
+            return -(slot + 1) * (i32)sizeof(u64);
+        }
+
+        // Chains of if x == k tests, each falling into the next one's block, are turned into a jump table once they
+        // have enough cases packed closely enough. Returns the table for every block heading such a chain, the
+        // blocks after it hold nothing else but the test and get marked as folded into it.
+        std::vector<std::optional<SwitchTable>> FindSwitches(const ir::Function& fn, std::vector<bool>& folded)
         {
-            if (s.kind == StatementKind::BlockStatement)
+            constexpr usize MinCases = 4;
+
+            // Only registers defined once can be taken for their constant.
+            std::vector<u32>                defs(fn.regCount);
+            std::vector<std::optional<i64>> constants(fn.regCount);
+            for (const auto& block : fn.blocks)
             {
-                CompileBlockStatement(s);
+                for (const auto& inst : block.code)
+                {
+                    if (inst.dst == ir::NoReg)
+                        continue;
+                    ++defs[inst.dst];
+                    if (inst.op == ir::OpCode::Const)
+                        constants[inst.dst] = inst.imm;
+                }
             }
+            const auto constant = [&](const ir::VReg reg)
+            { return (defs[reg] == 1) ? constants[reg] : std::nullopt; };
+
+            struct Test
+            {
+                ir::VReg       value{};
+                i64            key{};
+                ir::BlockIndex match{};
+                ir::BlockIndex next{};
+            };
+            const auto get_test = [&](const ir::BlockIndex block) -> std::optional<Test>
+            {
+                const auto& br = fn.blocks[block].code.back();
+                if (br.op != ir::OpCode::Branch ||
+                    (br.cond != ir::Condition::Equal && br.cond != ir::Condition::NotEqual))
+                    return std::nullopt;
+
+                auto value = br.a;
+                auto key   = constant(br.b);
+                if (!key)
+                {
+                    value = br.b;
+                    key   = constant(br.a);
+                }
+                if (!key || constant(value) || br.target == br.alt)
+                    return std::nullopt;
+
+                const bool equal = br.cond == ir::Condition::Equal;
+                return Test{ .value = value,
+                             .key   = *key,
+                             .match = (equal) ? br.target : br.alt,
+                             .next  = (equal) ? br.alt : br.target };
+            };
+
+            const auto liveness = ir::ComputeLiveness(fn);
+            const auto preds    = fn.GetPredecessors();
+            std::vector<std::optional<SwitchTable>> res(fn.blocks.size());
+
+            // Visiting in reverse post order meets a chain at its head before any block further down it.
+            for (const auto head : fn.GetReversePostOrder())
+            {
+                if (folded[head] || fn.blocks[head].code.empty())
+                    continue;
+                auto test = get_test(head);
+                if (!test)
+                    continue;
+
+                const auto                                  value = test->value;
+                std::vector<std::pair<i64, ir::BlockIndex>> cases{ { test->key, test->match } };
+                std::vector<ir::BlockIndex>                 chain{};
+                auto                                        next = test->next;
+                while (next != head && !folded[next] && preds[next].size() == 1)
+                {
+                    // The block may only compute the constant it compares against.
+                    const auto& code     = fn.blocks[next].code;
+                    const bool  foldable = std::all_of(code.begin(), code.end() - 1,
+                                                       [&](const ir::Instruction& inst)
+                                                       {
+                                                           return inst.op == ir::OpCode::Const && inst.dst != value &&
+                                                                  !liveness.IsLiveOut(next, inst.dst);
+                                                       });
+                    const auto  link     = (foldable) ? get_test(next) : std::nullopt;
+                    if (!link || link->value != value ||
+                        std::find(chain.begin(), chain.end(), next) != chain.end())
+                        break;
+
+                    cases.emplace_back(link->key, link->match);
+                    chain.push_back(next);
+                    next = link->next;
+                }
+
+                // Earlier tests win over later ones on the same value, the table keeps the first.
+                std::stable_sort(cases.begin(), cases.end(),
+                                 [](const auto& x, const auto& y) { return x.first < y.first; });
+                cases.erase(std::unique(cases.begin(), cases.end(),
+                                        [](const auto& x, const auto& y) { return x.first == y.first; }),
+                            cases.end());
+
+                const u64 range = (u64)cases.back().first - (u64)cases.front().first;
+                if (cases.size() < MinCases || range >= cases.size() * 2)
+                    continue;
+
+                SwitchTable table{ .value = value, .low = cases.front().first, .fallback = next };
+                table.targets.assign(range + 1, next);
+                for (const auto& [key, target] : cases)
+                    table.targets[(u64)key - (u64)table.low] = target;
+                for (const auto block : chain)
+                    folded[block] = true;
+                res[head] = std::move(table);
+            }
+            return res;
         }
-    }
+    } // namespace
 
-    void Compiler::CompileBlockStatement(const Statement& block)
+    Compiler::Compiler(const SyntaxTree& tree, const ir::OptimizationLevel level) : m_Tree(tree), m_Level(level)
     {
-        m_SymbolTableStack.push_back(SymbolTable{});
+    }
 
-        auto& current_table = m_SymbolTableStack.back();
+    CompiledCode Compiler::Compile()
+    {
+        // Every function gets its entry up front so calls can refer to functions that have not been emitted yet.
+        m_Symbols.PushScope();
+        for (const auto& s : m_Tree.GetGlobals())
+        {
+            if (s.kind == StatementKind::FunctionDeclaration)
+            {
+                m_Symbols.Add(s.ident, Symbol{ .name     = s.name,
+                                               .kind     = SymbolKind::Function,
+                                               .node     = m_Tree.IndexOf(s),
+                                               .function = m_CompiledFunctions.size() });
+
+                // Declarations seeded from imported modules carry the parameter list only.
+                m_CompiledFunctions.push_back(FunctionDefinition{ .name     = std::string{ s.name },
+                                                                  .node     = m_Tree.IndexOf(s),
+                                                                  .external = s.children.count == 1 });
+            }
+        }
 
-        m_CompiledCode << MakeInst({ .opcode = OpCode::Push, .sreg = RegType::BP }, block);
-        m_CompiledCode << MakeInst({ .opcode = OpCode::Mov, .sreg = RegType::SP, .dreg = RegType::BP }, block);
+        for (auto& fn : m_CompiledFunctions)
+        {
+            if (fn.external)
+                continue;
 
-        auto pos = m_CompiledCode.GetSize();
+            CompileFunctionBody(m_Tree[fn.node]);
+            ir::Optimizer{ m_Function, m_Level }.Run();
+            EmitFunction(m_Function, fn);
 
-        // m_CompiledCode << MakeInst({ .opcode = OpCode::Pushar }, block);
+            // The builtins are declared by every module that prints, they never get called so keep them private.
+            if (!IsBuiltin(fn.name))
+                m_CompiledCode.AddExport(Export{ .function = fn.name, .address = fn.address });
+        }
 
-        for (const auto& s : block.children)
+        // The code is relocatable, the linker moves it into place and resolves the calls into other modules.
+        for (const auto& fixup : m_CallFixups)
         {
-            switch (s.kind)
+            const auto& fn = m_CompiledFunctions[fixup.function];
+            if (fn.external)
+                m_CompiledCode.AddImport(Import{ .index = fixup.index, .function = fn.name });
+            else
             {
-                using enum StatementKind;
-
-                case VariableDeclaration: CompileVariableDeclaration(s); break;
-                case FunctionCallExpression: CompileFunctionCall(s); break;
-                case WhileStatement: CompileWhileStatement(s); break;
-                default: break;
+                m_CompiledCode[fixup.index].imm64 = fn.address;
+                m_CompiledCode.AddRelocation(Relocation{ .index = fixup.index });
             }
         }
 
-        m_CompiledCode.InsertAt(
-            pos,
-            MakeInst({ .opcode = OpCode::Sub, .imm64 = (u64)current_table.GetOffset(), .dreg = RegType::SP }, block));
-
-        m_SymbolTableStack.pop_back();
-        // m_CompiledCode << MakeInst({ .opcode = OpCode::Popar }, block);
-        m_CompiledCode << MakeInst({ .opcode = OpCode::Leave }, block);
+        m_CompiledCode.BuildLineTable(m_Tree);
+        return m_CompiledCode;
     }
 
-    void Compiler::CompileVariableDeclaration(const Statement& var)
+    void Compiler::CompileFunctionBody(const Node& fnStmt)
     {
-        // Grab our current block's symbol table.
-        auto& current_table = m_SymbolTableStack.back();
+        m_Function     = ir::Function{ .name = fnStmt.name };
+        m_CurrentBlock = m_Function.NewBlock();
+        m_Symbols.PushScope();
 
-        Symbol sym{};
-        sym.stmt    = var;
-        sym.name    = var.name;
-        sym.kind    = SymbolKind::Variable;
-        sym.size    = (var.type.size / 8) * ((var.type.length == 0) ? 1 : var.type.length);
-        sym.address = current_table.GetOffset();
+        // The parameters come first, then the body.
+        const auto children = m_Tree.GetChildren(fnStmt);
+        for (const auto& param : m_Tree.GetChildren(children[0]))
+        {
+            Symbol sym{};
+            sym.node = m_Tree.IndexOf(param);
+            sym.name = param.name;
+            sym.kind = SymbolKind::Variable;
+            sym.size = m_Tree.GetType(param).size / 8;
+            sym.reg  = Emit({ .op   = ir::OpCode::Param,
+                              .dst  = m_Function.NewReg(),
+                              .imm  = m_Function.paramCount++,
+                              .node = sym.node });
+            m_Symbols.Add(param.ident, sym);
+        }
+
+        if (children.size() > 1)
+            CompileStatement(children[1]);
+
+        // Falling off the end returns.
+        if (!m_Function.IsTerminated(m_CurrentBlock))
+            Emit({ .op = ir::OpCode::Return, .node = m_Tree.IndexOf(fnStmt) });
 
-        // Initialized.
-        if (!var.children.empty())
+        m_Symbols.PopScope();
+    }
+
+    void Compiler::CompileStatement(const Node& stmt)
+    {
+        switch (stmt.kind)
         {
-            auto current_offset = current_table.GetOffset();
+            using enum StatementKind;
 
-            // We know that a variable declaration statement will always have an Initializer statement if initialized
-            // (but of course).
-            /*
-            m_CompiledCode << MakeInst({
-                .opcode = OpCode::Mov, .sreg = RegType::SP, .dreg = GetReg(current_table.GetUsedRegisters()++) });
-            CompileInitializer(var.children[0]);
-            */
+            case BlockStatement: CompileBlockStatement(stmt); break;
+            case VariableDeclaration: CompileVariableDeclaration(stmt); break;
+            case IfStatement: CompileIfStatement(stmt); break;
+            case WhileStatement: CompileWhileStatement(stmt); break;
+            case ReturnStatement: CompileReturnStatement(stmt); break;
+            case NoOperationStatement: break;
 
-            CompileInitializer(var.children[0]);
+            // Expression statements, the value is thrown away.
+            default: CompileExpression(stmt); break;
+        }
+    }
 
-            m_CompiledCode << MakeInst({ .opcode = OpCode::Store,
-                                         .sreg   = GetReg(--current_table.GetUsedRegisters()),
-                                         .dreg   = MemReg(RegType::BP),
-                                         .disp   = current_table.GetOffset(),
-                                         .size   = (i8)var.type.size },
-                                       var);
-
-            /*
-            m_CompiledCode << MakeInst({
-                .opcode = OpCode::Mov, .sreg = GetReg(--current_table.GetUsedRegisters()), .dreg = RegType::SP }, var);
-            */
-            current_table.AddSymbol(sym);
+    void Compiler::CompileBlockStatement(const Node& block)
+    {
+        // Blocks only scope names now, the frame belongs to the whole function.
+        m_Symbols.PushScope();
+        for (const auto& s : m_Tree.GetChildren(block))
+            CompileStatement(s);
+        m_Symbols.PopScope();
+    }
+
+    void Compiler::CompileVariableDeclaration(const Node& var)
+    {
+        const auto& var_type = m_Tree.GetType(var);
+
+        Symbol sym{};
+        sym.node = m_Tree.IndexOf(var);
+        sym.name = var.name;
+        sym.kind = SymbolKind::Variable;
+        sym.size = (var_type.size / 8) * ((var_type.length == 0) ? 1 : var_type.length);
+        sym.reg  = m_Function.NewReg();
+
+        // We know that a variable declaration statement will always have an Initializer statement if initialized
+        // (but of course), uninitialized variables start out zeroed.
+        if (var.children.count != 0)
+        {
+            const auto& init = m_Tree.GetChildren(var)[0];
+            AssignTo(sym.reg, m_Tree.GetChildren(init)[0], CompileInitializer(init));
         }
         else
         {
-            // Just allocate space on the stack.
-            switch (var.type.ftype)
-            {
-                using enum FundamentalType;
-
-                case Boolean:
-                case Character:
-                case Integer32:
-                case Integer64:
-                    m_CompiledCode << MakeInst({ .opcode = OpCode::Store,
-                                                 .dreg   = MemReg(RegType::BP),
-                                                 .disp   = current_table.GetOffset(),
-                                                 .size   = (i8)var.type.size },
-                                               var);
-                    break;
-                // FIXME: Uninitilized strings do not allocate space.
-                case String: break;
-                default: break;
-            }
+            Emit({ .op = ir::OpCode::Const, .dst = sym.reg, .node = sym.node });
         }
+
+        // Only visible once the initializer is done with.
+        m_Symbols.Add(var.ident, sym);
     }
 
-    void Compiler::CompileInitializer(const Statement& init)
+    ir::VReg Compiler::CompileInitializer(const Node& init)
     {
-        // Check if the initializer's value is a value, expression or a initializer list.
-        CompileExpression(init.children[0]);
+        return CompileExpression(m_Tree.GetChildren(init)[0]);
     }
 
-    void Compiler::CompileExpression(const ast::Statement& expr)
+    ir::VReg Compiler::CompileExpression(const Node& expr)
     {
-        auto& current_table = m_SymbolTableStack.back();
+        const auto node = m_Tree.IndexOf(expr);
         switch (expr.kind)
         {
             using enum StatementKind;
 
-            case FunctionCallExpression: {
-                break;
-            }
-            case FunctionArgumentList: {
-                break;
-            }
-            case LiteralExpression: {
-                CompileLiteral(expr);
-                break;
-            }
-            case AdditionExpression:
-            case SubtractionExpression: {
-                CompileExpression(expr.children[0]);
-                CompileExpression(expr.children[1]);
+            case FunctionCallExpression: return CompileFunctionCall(expr);
+            case LiteralExpression: return CompileLiteral(expr);
+            case IdentifierName: return CompileIdentifierName(expr);
 
-                auto&      used_regs = current_table.GetUsedRegisters();
-                const auto op_code   = (expr.kind == AdditionExpression) ? OpCode::Add : OpCode::Sub;
-                m_CompiledCode << MakeInst(
-                    { .opcode = op_code, .sreg = GetReg(--used_regs), .dreg = GetReg(used_regs - 1) }, expr);
-                break;
+            case AdditionExpression:
+            case SubtractionExpression:
+            case MultiplicationExpression:
+            case DivisionExpression: {
+                const auto lhs = CompileExpression(m_Tree.GetChildren(expr)[0]);
+                const auto rhs = CompileExpression(m_Tree.GetChildren(expr)[1]);
+
+                ir::OpCode op{};
+                switch (expr.kind)
+                {
+                    case AdditionExpression: op = ir::OpCode::Add; break;
+                    case SubtractionExpression: op = ir::OpCode::Sub; break;
+                    case MultiplicationExpression: op = ir::OpCode::Mul; break;
+                    default: op = ir::OpCode::Div; break;
+                }
+                return Emit({ .op = op, .dst = m_Function.NewReg(), .a = lhs, .b = rhs, .node = node });
             }
-            case DivisionExpression:
-            case MultiplicationExpression: {
-                CompileExpression(expr.children[0]);
-                CompileExpression(expr.children[1]);
 
-                auto&      used_regs = current_table.GetUsedRegisters();
-                const auto op_code   = (expr.kind == DivisionExpression) ? OpCode::Div : OpCode::Mul;
-                m_CompiledCode << MakeInst(
-                    { .opcode = op_code, .sreg = GetReg(--used_regs), .dreg = GetReg(used_regs - 1) }, expr);
-                break;
+            case EqualsExpression:
+            case NotEqualsExpression:
+            case GreaterExpression:
+            case GreaterThanExpression:
+            case LesserExpression:
+            case LesserThanExpression:
+            case GreaterThanOrEqualExpression:
+            case LesserThanOrEqualExpression: {
+                const auto lhs = CompileExpression(m_Tree.GetChildren(expr)[0]);
+                const auto rhs = CompileExpression(m_Tree.GetChildren(expr)[1]);
+                return Emit({ .op   = ir::OpCode::Compare,
+                              .cond = *GetCondition(expr.kind),
+                              .dst  = m_Function.NewReg(),
+                              .a    = lhs,
+                              .b    = rhs,
+                              .node = node });
             }
 
-            case IdentifierName: {
-                auto& sym = m_SymbolTableStack.back().GetSymbol(expr.name);
-                m_CompiledCode << MakeInst({ .opcode = OpCode::Load,
-                                             .sreg   = MemReg(RegType::BP),
-                                             .dreg   = GetReg(current_table.GetUsedRegisters()++),
-                                             .disp   = sym.address },
-                                           expr);
-                break;
+            case AssignmentExpression: {
+                const auto& lhs   = m_Tree.GetChildren(expr)[0];
+                const auto& rhs   = m_Tree.GetChildren(expr)[1];
+                const auto  value = CompileExpression(rhs);
+                const auto  var   = CompileIdentifierName(lhs);
+                AssignTo(var, rhs, value);
+                return var;
             }
-            default: break;
+
+            // FIXME: Arrays and initializer lists are not lowered yet.
+            default: return Emit({ .op = ir::OpCode::Const, .dst = m_Function.NewReg(), .node = node });
         }
     }
 
-    void Compiler::CompileLiteral(const Statement& literal)
+    ir::VReg Compiler::CompileLiteral(const Node& literal)
     {
-        // Grab our current block's symbol table.
-        auto& current_table = m_SymbolTableStack.back();
-
         // The literal token.
-        auto& literal_token = literal.tokens[0];
+        const auto& literal_token = m_Tree.GetTokens(literal)[0];
+        const auto  node          = m_Tree.IndexOf(literal);
 
         // We support fundamental types only for now.
-        switch (literal.type.ftype)
+        switch (m_Tree.GetType(literal).ftype)
         {
             using enum FundamentalType;
 
-            // For numeric types.
-            case Boolean:
-            case Character:
-            case Integer32:
-            case Integer64: {
-                m_CompiledCode << MakeInst({ .opcode = OpCode::Mov,
-                                             .imm64  = (u64)literal_token.num,
-                                             .dreg   = GetReg(current_table.GetUsedRegisters()++) },
-                                           literal);
-                break;
-            }
             case String: {
-                auto& pool = m_CompiledCode.GetStringPool();
-                if (!pool.contains(literal_token.span.text))
+                auto&      pool = m_CompiledCode.GetStringPool();
+                const auto text = std::string{ literal_token.span.text };
+                if (!pool.contains(text))
                 {
-                    pool[literal_token.span.text] = pool.size();
-                    for (unsigned char c : literal_token.span.text)
+                    pool[text] = m_CompiledCode.GetDataSection().size();
+                    for (unsigned char c : text)
                     {
                         m_CompiledCode << c;
                     }
+                    m_CompiledCode << (u8)'\0';
                 }
-                m_CompiledCode << MakeInst({ .opcode = OpCode::Lea,
-                                             .sreg   = RegType::DS,
-                                             .dreg   = GetReg(current_table.GetUsedRegisters()++),
-                                             .disp   = (i32)pool[literal_token.span.text] },
-                                           literal);
-                break;
+                return Emit(
+                    { .op = ir::OpCode::String, .dst = m_Function.NewReg(), .imm = (i64)pool[text], .node = node });
             }
 
-            default: break;
+            // For numeric types.
+            default:
+                return Emit(
+                    { .op = ir::OpCode::Const, .dst = m_Function.NewReg(), .imm = literal_token.num, .node = node });
         }
     }
 
-    void Compiler::CompileInitializerList(const ast::Statement& initList)
+    ir::VReg Compiler::CompileFunctionCall(const Node& fnCall)
     {
-        // Grab our current block's symbol table.
-        auto& current_table = m_SymbolTableStack.back();
+        const auto node = m_Tree.IndexOf(fnCall);
+
+        // Evaluate every argument before passing any, nested calls would otherwise interleave with ours.
+        std::vector<ir::VReg> args{};
+        for (const auto& arg : m_Tree.GetChildren(m_Tree.GetChildren(fnCall)[0]))
+            args.push_back(CompileExpression(arg));
+
+        if (IsBuiltin(fnCall.name))
+        {
+            const auto op = (fnCall.name == "printi64") ? ir::OpCode::PrintInt : ir::OpCode::PrintStr;
+            for (const auto arg : args)
+                Emit({ .op = op, .a = arg, .node = node });
+            return ir::NoReg;
+        }
 
-        auto prev_offset = current_table.GetOffset();
-        for (const auto& expr : initList.children)
+        if (const auto* fn = m_Symbols.FindGlobal(fnCall.ident))
         {
-            CompileExpression(expr);
-            current_table.GetOffset() += expr.type.size / 8;
+            for (const auto arg : args)
+                Emit({ .op = ir::OpCode::Arg, .a = arg, .node = node });
+            return Emit(
+                { .op = ir::OpCode::Call, .dst = m_Function.NewReg(), .imm = (i64)fn->function, .node = node });
         }
+        return ir::NoReg;
+    }
 
-        current_table.GetOffset() = prev_offset;
+    ir::VReg Compiler::CompileIdentifierName(const Node& ident)
+    {
+        if (auto* sym = LookupSymbol(ident.ident))
+            return sym->reg;
+        return Emit({ .op = ir::OpCode::Const, .dst = m_Function.NewReg(), .node = m_Tree.IndexOf(ident) });
     }
 
-    void Compiler::CompileFunctionCall(const ast::Statement& fnCall)
+    void Compiler::CompileCondition(const Node& cond, const ir::BlockIndex target, const ir::BlockIndex alt)
     {
-        auto& current_table = m_SymbolTableStack.back();
-        if (fnCall.name == "printi64")
+        const auto node = m_Tree.IndexOf(cond);
+
+        // Comparisons branch on their operands directly instead of materializing a bool first.
+        if (auto condition = GetCondition(cond.kind))
         {
-            CompileFunctionArgumentList(fnCall.children[0]);
-            m_CompiledCode << MakeInst({ .opcode = OpCode::PInt, .sreg = GetReg(--current_table.GetUsedRegisters()) },
-                                       fnCall);
+            const auto lhs = CompileExpression(m_Tree.GetChildren(cond)[0]);
+            const auto rhs = CompileExpression(m_Tree.GetChildren(cond)[1]);
+            Emit({ .op     = ir::OpCode::Branch,
+                   .cond   = *condition,
+                   .a      = lhs,
+                   .b      = rhs,
+                   .target = target,
+                   .alt    = alt,
+                   .node   = node });
             return;
         }
-        else if (fnCall.name == "printstr")
+
+        const auto value = CompileExpression(cond);
+        const auto zero  = Emit({ .op = ir::OpCode::Const, .dst = m_Function.NewReg(), .node = node });
+        Emit({ .op     = ir::OpCode::Branch,
+               .cond   = ir::Condition::NotEqual,
+               .a      = value,
+               .b      = zero,
+               .target = target,
+               .alt    = alt,
+               .node   = node });
+    }
+
+    void Compiler::CompileIfStatement(const Node& ifst)
+    {
+        const auto children = m_Tree.GetChildren(ifst);
+
+        // The exit block is created after the body so the blocks are laid out in source order and the body falls
+        // through into it, the branch gets its target patched once it exists.
+        const auto body = m_Function.NewBlock();
+        CompileCondition(children[0], body, 0);
+        const auto branch_block = m_CurrentBlock;
+
+        SwitchToBlock(body);
+        CompileStatement(children[1]);
+
+        const auto exit = m_Function.NewBlock();
+        Emit({ .op = ir::OpCode::Jump, .target = exit, .node = m_Tree.IndexOf(ifst) });
+        m_Function.blocks[branch_block].code.back().alt = exit;
+        SwitchToBlock(exit);
+    }
+
+    void Compiler::CompileWhileStatement(const Node& whst)
+    {
+        const auto children = m_Tree.GetChildren(whst);
+        const auto node     = m_Tree.IndexOf(whst);
+
+        const auto header = m_Function.NewBlock();
+        Emit({ .op = ir::OpCode::Jump, .target = header, .node = node });
+        SwitchToBlock(header);
+
+        const auto body = m_Function.NewBlock();
+        CompileCondition(children[0], body, 0);
+        const auto branch_block = m_CurrentBlock;
+
+        SwitchToBlock(body);
+        CompileStatement(children[1]);
+        Emit({ .op = ir::OpCode::Jump, .target = header, .node = node });
+
+        const auto exit = m_Function.NewBlock();
+        m_Function.blocks[branch_block].code.back().alt = exit;
+        SwitchToBlock(exit);
+    }
+
+    void Compiler::CompileReturnStatement(const Node& retst)
+    {
+        const auto value = (retst.children.count != 0) ? CompileExpression(m_Tree.GetChildren(retst)[0]) : ir::NoReg;
+        Emit({ .op = ir::OpCode::Return, .a = value, .node = m_Tree.IndexOf(retst) });
+    }
+
+    ir::VReg Compiler::Emit(const ir::Instruction& inst)
+    {
+        // Code following a terminator is unreachable but still needs a block to live in.
+        if (m_Function.IsTerminated(m_CurrentBlock))
+            m_CurrentBlock = m_Function.NewBlock();
+
+        m_Function.blocks[m_CurrentBlock].code.push_back(inst);
+        return inst.dst;
+    }
+
+    void Compiler::AssignTo(const ir::VReg var, const Node& expr, const ir::VReg value)
+    {
+        // A freshly computed value can be written straight into the variable instead of being copied over, names and
+        // assignments hand back a variable's own register so those still need the copy.
+        auto& code = m_Function.blocks[m_CurrentBlock].code;
+        if (expr.kind != StatementKind::IdentifierName && expr.kind != StatementKind::AssignmentExpression &&
+            !code.empty() && code.back().dst == value)
         {
-            CompileFunctionArgumentList(fnCall.children[0]);
-            m_CompiledCode << MakeInst({ .opcode = OpCode::PStr, .sreg = GetReg(--current_table.GetUsedRegisters()) },
-                                       fnCall);
+            code.back().dst = var;
             return;
         }
+        Emit({ .op = ir::OpCode::Copy, .dst = var, .a = value, .node = m_Tree.IndexOf(expr) });
+    }
+
+    void Compiler::SwitchToBlock(const ir::BlockIndex block) noexcept
+    {
+        m_CurrentBlock = block;
+    }
+
+    Symbol* Compiler::LookupSymbol(const IdentId ident) noexcept
+    {
+        // Functions share the table but are no variables.
+        auto* sym = m_Symbols.Find(ident);
+        return (sym && sym->kind == SymbolKind::Variable) ? sym : nullptr;
+    }
+
+    void Compiler::EmitFunction(const ir::Function& fn, FunctionDefinition& def)
+    {
+        auto allocation = RegisterAllocator(fn, RegisterPool).Allocate();
+
+        // Registers are callee saved, main has no caller to preserve them for.
+        std::span<const RegType> saved{};
+        if (fn.name != "main")
+            saved = allocation.usedRegisters;
+
+        def.address = m_CompiledCode.GetSize();
+        // Enter saves the callee saved registers below the spill slots itself, the prologue is a single instruction.
+        m_CompiledCode << MakeInst({ .opcode = OpCode::Enter,
+                                     .imm64  = allocation.slotCount * sizeof(u64),
+                                     .disp   = (i32)GetRegisterMask(saved) },
+                                   def.node);
+
+        // Switch lowering is left to the optimizing levels, O0 keeps every test where the source put it.
+        std::vector<bool>                       folded(fn.blocks.size());
+        std::vector<std::optional<SwitchTable>> switches(fn.blocks.size());
+        if (m_Level != ir::OptimizationLevel::O0)
+            switches = FindSwitches(fn, folded);
+
+        std::vector<ir::BlockIndex> layout{};
+        std::copy_if(fn.layout.begin(), fn.layout.end(), std::back_inserter(layout),
+                     [&](const ir::BlockIndex block) { return !folded[block]; });
+
+        std::vector<usize>                                block_addresses(fn.blocks.size());
+        std::vector<std::pair<usize, ir::BlockIndex>>     jumps{};
+        std::vector<std::pair<usize, const SwitchTable*>> tables{}; // Data offset of each jump table.
+        for (usize i = 0; i < layout.size(); ++i)
+        {
+            const auto  block      = layout[i];
+            const auto  next_block = (i + 1 < layout.size()) ? layout[i + 1] : ~ir::BlockIndex{};
+            const auto& code       = fn.blocks[block].code;
+            block_addresses[block] = m_CompiledCode.GetSize();
+            if (!switches[block])
+            {
+                for (const auto& inst : code)
+                    EmitInstruction(inst, allocation, saved, next_block, jumps);
+                continue;
+            }
+
+            for (usize j = 0; j + 1 < code.size(); ++j)
+                EmitInstruction(code[j], allocation, saved, next_block, jumps);
+            tables.emplace_back(EmitSwitch(*switches[block], allocation, code.back().node, next_block, jumps),
+                                &*switches[block]);
+        }
 
-        for (const auto& fn : m_CompiledFunctions)
+        for (const auto& [index, block] : jumps)
         {
-            if (fn.name == fnCall.name)
+            m_CompiledCode[index].imm64 = block_addresses[block];
+            m_CompiledCode.AddRelocation(Relocation{ .index = index });
+        }
+
+        // The entries are code addresses sitting in the data section, they move with the code when linking.
+        auto& data = m_CompiledCode.GetDataSection();
+        for (const auto& [offset, table] : tables)
+        {
+            for (usize i = 0; i < table->targets.size(); ++i)
             {
-                m_CompiledCode << MakeInst({ .opcode = OpCode::Call, .imm64 = fn.address }, fnCall);
-                for (const auto& arg : fnCall.children[0].children)
-                {
-                    CompileExpression(arg);
-                }
+                const usize entry   = offset + (1 + i) * sizeof(u64);
+                const u64   address = block_addresses[table->targets[i]];
+                std::memcpy(data.data() + entry, &address, sizeof(u64));
+                m_CompiledCode.AddRelocation(Relocation{ .index = entry, .field = RelocationField::Data });
             }
         }
     }
 
-    void Compiler::CompileFunctionArgumentList(const ast::Statement& args)
+    usize Compiler::EmitSwitch(const SwitchTable& table, const Allocation& alloc, const ast::NodeIndex node,
+                               const ir::BlockIndex next_block, std::vector<std::pair<usize, ir::BlockIndex>>& jumps)
     {
-        for (const auto& arg : args.children)
+        // jtab indexes from zero, so the value is rebased onto the lowest case. Whatever lies below it wraps around
+        // past the end of the table and falls through just like what lies above it.
+        auto rv = EmitUse(alloc, table.value, ScratchA, node);
+        if (table.low != 0)
+        {
+            if (rv != ScratchA)
+                m_CompiledCode << MakeInst({ .opcode = OpCode::Mov, .sreg = rv, .dreg = ScratchA }, node);
+            m_CompiledCode << MakeInst({ .opcode = OpCode::Mov, .imm64 = (u64)table.low, .dreg = ScratchB }, node);
+            m_CompiledCode << MakeInst({ .opcode = OpCode::Sub, .sreg = ScratchB, .dreg = ScratchA }, node);
+            rv = ScratchA;
+        }
+
+        // The table is a count followed by one address per value, the addresses are filled in once the function's
+        // blocks have been placed.
+        auto&       data   = m_CompiledCode.GetDataSection();
+        const usize offset = data.size();
+        const u64   count  = table.targets.size();
+        data.resize(offset + (1 + count) * sizeof(u64));
+        std::memcpy(data.data() + offset, &count, sizeof(u64));
+
+        m_CompiledCode.AddRelocation(Relocation{
+            .index = m_CompiledCode.GetSize(), .type = RelocationType::Data, .field = RelocationField::Disp });
+        m_CompiledCode << MakeInst({ .opcode = OpCode::Jtab, .sreg = rv, .disp = (i32)offset }, node);
+        if (table.fallback != next_block)
         {
-            CompileExpression(arg);
+            jumps.emplace_back(m_CompiledCode.GetSize(), table.fallback);
+            m_CompiledCode << MakeInst({ .opcode = OpCode::Jump }, node);
         }
+        return offset;
     }
 
-    void Compiler::CompileWhileStatement(const ast::Statement& whst)
+    void Compiler::EmitInstruction(const ir::Instruction& inst, const Allocation& alloc,
+                                   std::span<const RegType> saved, const ir::BlockIndex next_block,
+                                   std::vector<std::pair<usize, ir::BlockIndex>>& jumps)
     {
+        const auto node = inst.node;
+        const auto dest = [&](const ir::VReg reg)
+        { return (alloc.locations[reg].IsSpilled()) ? ScratchA : alloc.locations[reg].reg; };
+        const auto jump = [&](const OpCode opcode, const ir::BlockIndex block)
+        {
+            jumps.emplace_back(m_CompiledCode.GetSize(), block);
+            m_CompiledCode << MakeInst({ .opcode = opcode }, node);
+        };
+
+        switch (inst.op)
+        {
+            using enum ir::OpCode;
+
+            case Const: {
+                const auto rd = dest(inst.dst);
+                m_CompiledCode << MakeInst({ .opcode = OpCode::Mov, .imm64 = (u64)inst.imm, .dreg = rd }, node);
+                EmitDef(alloc, inst.dst, rd, node);
+                break;
+            }
+            case Copy: {
+                const auto& from = alloc.locations[inst.a];
+                const auto& to   = alloc.locations[inst.dst];
+                if (from.reg == to.reg && from.slot == to.slot)
+                    break;
+
+                const auto ra = EmitUse(alloc, inst.a, ScratchA, node);
+                EmitDef(alloc, inst.dst, ra, node);
+                break;
+            }
+            case Add:
+            case Sub:
+            case Mul: {
+                const auto opcode = (inst.op == Add) ? OpCode::Add : (inst.op == Sub) ? OpCode::Sub : OpCode::Mul;
+                auto       ra     = EmitUse(alloc, inst.a, ScratchA, node);
+                auto       rb     = EmitUse(alloc, inst.b, ScratchB, node);
+                auto       rd     = dest(inst.dst);
+
+                // Blend only has the two operand forms, so the result register has to be loaded with the left hand
+                // side first, which would clobber the right hand side if the two share a register.
+                if (rd == rb && rd != ra)
+                {
+                    if (inst.op != Sub)
+                        std::swap(ra, rb);
+                    else
+                        rd = ScratchA;
+                }
+                if (rd != ra)
+                    m_CompiledCode << MakeInst({ .opcode = OpCode::Mov, .sreg = ra, .dreg = rd }, node);
+                m_CompiledCode << MakeInst({ .opcode = opcode, .sreg = rb, .dreg = rd }, node);
+                EmitDef(alloc, inst.dst, rd, node);
+                break;
+            }
+            case Div: {
+                // The dividend lives in R0 and the remainder ends up in R3, neither is ever allocated.
+                const auto ra = EmitUse(alloc, inst.a, ScratchA, node);
+                const auto rb = EmitUse(alloc, inst.b, ScratchB, node);
+                m_CompiledCode << MakeInst({ .opcode = OpCode::Mov, .sreg = ra, .dreg = RegType::R0 }, node);
+                m_CompiledCode << MakeInst({ .opcode = OpCode::Div, .sreg = rb }, node);
+                EmitDef(alloc, inst.dst, RegType::R0, node);
+                break;
+            }
+            case Compare: {
+                const auto ra            = EmitUse(alloc, inst.a, ScratchA, node);
+                const auto rb            = EmitUse(alloc, inst.b, ScratchB, node);
+                const auto rd            = dest(inst.dst);
+                const auto [cmp, opcode] = MakeCompare(inst.cond, ra, rb);
+
+                // Mov leaves the flags alone, so set the result and skip over clearing it when the condition holds.
+                m_CompiledCode << MakeInst(cmp, node);
+                m_CompiledCode << MakeInst({ .opcode = OpCode::Mov, .imm64 = 1, .dreg = rd }, node);
+                m_CompiledCode.AddRelocation(Relocation{ .index = m_CompiledCode.GetSize() });
+                m_CompiledCode << MakeInst({ .opcode = opcode, .imm64 = m_CompiledCode.GetSize() + 2 }, node);
+                m_CompiledCode << MakeInst({ .opcode = OpCode::Mov, .imm64 = 0, .dreg = rd }, node);
+                EmitDef(alloc, inst.dst, rd, node);
+                break;
+            }
+            case String: {
+                const auto rd = dest(inst.dst);
+                m_CompiledCode.AddRelocation(Relocation{
+                    .index = m_CompiledCode.GetSize(), .type = RelocationType::Data, .field = RelocationField::Disp });
+                m_CompiledCode << MakeInst(
+                    { .opcode = OpCode::Lea, .sreg = RegType::DS, .dreg = rd, .disp = (i32)inst.imm }, node);
+                EmitDef(alloc, inst.dst, rd, node);
+                break;
+            }
+            case Param: {
+                // Arguments are pushed in order, so the last one sits right above the saved frame pointer.
+                const auto rd   = dest(inst.dst);
+                const auto disp = (i32)(1 + (m_Function.paramCount - 1 - inst.imm)) * (i32)sizeof(u64);
+                m_CompiledCode << MakeInst(
+                    { .opcode = OpCode::Load, .sreg = MemReg(RegType::BP), .dreg = rd, .disp = disp }, node);
+                EmitDef(alloc, inst.dst, rd, node);
+                break;
+            }
+            case Arg: {
+                const auto ra = EmitUse(alloc, inst.a, ScratchA, node);
+                m_CompiledCode << MakeInst({ .opcode = OpCode::Push, .sreg = ra }, node);
+                break;
+            }
+            case Call: {
+                m_CallFixups.push_back(CallFixup{ .index = m_CompiledCode.GetSize(), .function = (usize)inst.imm });
+                m_CompiledCode << MakeInst({ .opcode = OpCode::Call }, node);
+
+                // Pop the arguments, Blend's immediate add does not work on registers so go through a scratch one.
+                if (const auto arg_count = m_Tree.GetChildren(m_Tree[node])[0].children.count; arg_count != 0)
+                {
+                    m_CompiledCode << MakeInst(
+                        { .opcode = OpCode::Mov, .imm64 = arg_count * sizeof(u64), .dreg = ScratchA }, node);
+                    m_CompiledCode << MakeInst({ .opcode = OpCode::Add, .sreg = ScratchA, .dreg = RegType::SP }, node);
+                }
+                EmitDef(alloc, inst.dst, RegType::R0, node);
+                break;
+            }
+            case PrintInt:
+            case PrintStr: {
+                const auto ra     = EmitUse(alloc, inst.a, ScratchA, node);
+                const auto opcode = (inst.op == PrintInt) ? OpCode::PInt : OpCode::PStr;
+                m_CompiledCode << MakeInst({ .opcode = opcode, .sreg = ra }, node);
+                break;
+            }
+            case Jump: {
+                if (inst.target != next_block)
+                    jump(OpCode::Jump, inst.target);
+                break;
+            }
+            case Branch: {
+                const auto ra = EmitUse(alloc, inst.a, ScratchA, node);
+                const auto rb = EmitUse(alloc, inst.b, ScratchB, node);
+
+                // Branch away from whichever successor comes next and fall through into it.
+                const bool invert        = inst.target == next_block;
+                const auto [cmp, opcode] = MakeCompare((invert) ? ir::Invert(inst.cond) : inst.cond, ra, rb);
+                m_CompiledCode << MakeInst(cmp, node);
+                jump(opcode, (invert) ? inst.alt : inst.target);
+                if (!invert && inst.alt != next_block)
+                    jump(OpCode::Jump, inst.alt);
+                break;
+            }
+            case Return: {
+                if (inst.a != ir::NoReg)
+                {
+                    const auto ra = EmitUse(alloc, inst.a, RegType::R0, node);
+                    if (ra != RegType::R0)
+                        m_CompiledCode << MakeInst({ .opcode = OpCode::Mov, .sreg = ra, .dreg = RegType::R0 }, node);
+                }
+                m_CompiledCode << MakeInst({ .opcode = OpCode::LeaveRet, .disp = (i32)GetRegisterMask(saved) }, node);
+                break;
+            }
+            case Phi: {
+                assert(false && "Phis are turned into copies before the function is emitted.");
+                break;
+            }
+        }
+    }
+
+    RegType Compiler::EmitUse(const Allocation& alloc, const ir::VReg reg, const RegType scratch,
+                              const ast::NodeIndex node)
+    {
+        const auto& loc = alloc.locations[reg];
+        if (!loc.IsSpilled())
+            return loc.reg;
+
+        m_CompiledCode << MakeInst(
+            { .opcode = OpCode::Load, .sreg = MemReg(RegType::BP), .dreg = scratch, .disp = GetSlotOffset(loc.slot) },
+            node);
+        return scratch;
+    }
+
+    void Compiler::EmitDef(const Allocation& alloc, const ir::VReg reg, const RegType value, const ast::NodeIndex node)
+    {
+        if (reg == ir::NoReg)
+            return;
+
+        const auto& loc = alloc.locations[reg];
+        if (loc.IsSpilled())
+        {
+            m_CompiledCode << MakeInst({ .opcode = OpCode::Store,
+                                         .sreg   = value,
+                                         .dreg   = MemReg(RegType::BP),
+                                         .disp   = GetSlotOffset(loc.slot) },
+                                       node);
+        }
+        else if (loc.reg != value)
+        {
+            m_CompiledCode << MakeInst({ .opcode = OpCode::Mov, .sreg = value, .dreg = loc.reg }, node);
+        }
     }
 } // namespace relang::refront
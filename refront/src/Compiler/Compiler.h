@@ -5,6 +5,9 @@
 #include <vector>
 
 #include "../Analyzer/Parser.h"
+#include "IR.h"
+#include "Optimizer.h"
+#include "RegisterAllocator.h"
 
 namespace relang::refront {
     namespace codegen {
@@ -16,67 +19,121 @@ namespace relang::refront {
         };
 
         struct Symbol
+        {
+            std::string_view name{};
+            SymbolKind       kind{};
+            ast::NodeIndex   node = ast::NullNode;
+            usize            size{};
+            ir::VReg         reg = ir::NoReg; // The virtual register holding the variable.
+            usize            function{};      // Index into the compiled function list.
+        };
+
+        struct FunctionDefinition
         {
             std::string    name{};
-            SymbolKind     kind{};
-            ast::Statement stmt{};
-            usize          size{};
-            i32            address{};
+            usize          address{};
+            ast::NodeIndex node     = ast::NullNode;
+            bool           external = false; // Defined by an imported module, calls are resolved when linking.
         };
 
-        struct SymbolTable
+        // A call whose target address is patched in once every function has been emitted.
+        struct CallFixup
         {
-        private:
-            std::unordered_map<std::string, Symbol> m_Symbol{};
-            i32                                     m_Offset{};
-            usize                                   m_UsedRegisters{};
+            usize index{};    // The call instruction.
+            usize function{}; // Index into the compiled function list.
+        };
 
-        public:
-            inline i32&         GetOffset() noexcept { return m_Offset; }
-            inline const i32&   GetOffset() const noexcept { return m_Offset; }
-            inline usize&       GetUsedRegisters() noexcept { return m_UsedRegisters; };
-            inline const usize& GetUsedRegisters() const noexcept { return m_UsedRegisters; };
+        // A chain of equality tests of one register against constants, dispatched through a single jtab.
+        struct SwitchTable
+        {
+            ir::VReg                    value = ir::NoReg;
+            i64                         low{};
+            std::vector<ir::BlockIndex> targets{}; // Indexed by value - low, values without a case go to fallback.
+            ir::BlockIndex              fallback{};
+        };
 
-        public:
-            void          AddSymbol(Symbol symbol) noexcept;
-            bool          ContainsSymbol(const std::string& name) const noexcept;
-            Symbol&       GetSymbol(const std::string& name) noexcept;
-            const Symbol& GetSymbol(const std::string& name) const noexcept;
+        enum class RelocationType : u8
+        {
+            Code,
+            Data
         };
 
-        struct FunctionDefinition
+        enum class RelocationField : u8
+        {
+            Imm64,
+            Disp,
+            Data // A u64 in the data section, index is its offset there.
+        };
+
+        // An instruction field holding an address that moves when modules are linked together.
+        struct Relocation
         {
-            std::string name{};
+            usize           index{};
+            RelocationType  type  = RelocationType::Code;
+            RelocationField field = RelocationField::Imm64;
+        };
+
+        // A call into another module, its imm64 is filled in with the function's linked address.
+        struct Import
+        {
+            usize       index{};
+            std::string function{};
+        };
+
+        // A function the module defines, by its address within the module.
+        struct Export
+        {
+            std::string function{};
             usize       address{};
         };
 
         using StringPool = std::unordered_map<std::string, usize>;
 
+        // A line table row, the instructions from index up to the next row's index were generated for line:cur.
+        struct LineEntry
+        {
+            u32 index{};
+            u32 line{};
+            u32 cur{};
+        };
+
+        using LineTable = std::vector<LineEntry>;
+
         struct CompiledCode
         {
         private:
-            std::vector<std::pair<blend::Instruction, ast::Statement>> m_Code{};
-            std::vector<u8>                                            m_Data{};
-            usize                                                      m_BssSize{};
-            StringPool                                                 m_StringPool{};
+            blend::InstructionList      m_Code{};
+            std::vector<ast::NodeIndex> m_DebugNodes{}; // The syntax node each instruction was generated for.
+            LineTable                   m_LineTable{};
+            std::vector<u8>             m_Data{};
+            usize                       m_BssSize{};
+            StringPool                  m_StringPool{};
+            std::vector<Relocation>     m_Relocations{};
+            std::vector<Import>         m_Imports{};
+            std::vector<Export>         m_Exports{}; // Functions other modules may call.
 
         public:
-            inline usize                  GetSize() const noexcept { return m_Code.size(); }
-            inline const std::vector<u8>& GetDataSection() const noexcept { return m_Data; }
-            inline usize                  GetBssSize() const noexcept { return m_BssSize; }
-            inline StringPool&            GetStringPool() noexcept { return m_StringPool; }
-            inline const StringPool&      GetStringPool() const noexcept { return m_StringPool; }
+            inline usize                              GetSize() const noexcept { return m_Code.size(); }
+            inline std::vector<u8>&                   GetDataSection() noexcept { return m_Data; }
+            inline const std::vector<u8>&             GetDataSection() const noexcept { return m_Data; }
+            inline usize                              GetBssSize() const noexcept { return m_BssSize; }
+            inline StringPool&                        GetStringPool() noexcept { return m_StringPool; }
+            inline const StringPool&                  GetStringPool() const noexcept { return m_StringPool; }
+            inline const std::vector<ast::NodeIndex>& GetDebugNodes() const noexcept { return m_DebugNodes; }
+            inline const LineTable&                   GetLineTable() const noexcept { return m_LineTable; }
 
         public:
-            inline CompiledCode& InsertAt(const usize                                   index,
-                                          std::pair<blend::Instruction, ast::Statement> inst) noexcept
-            {
-                m_Code.insert(m_Code.begin() + index, std::move(inst));
-                return *this;
-            }
-            inline CompiledCode& operator<<(std::pair<blend::Instruction, ast::Statement> inst) noexcept
+            inline void AddRelocation(const Relocation& relocation) { m_Relocations.push_back(relocation); }
+            inline void AddImport(Import import) { m_Imports.push_back(std::move(import)); }
+            inline void AddExport(Export exported) { m_Exports.push_back(std::move(exported)); }
+
+        public:
+            inline blend::Instruction&       operator[](const usize index) noexcept { return m_Code[index]; }
+            inline const blend::Instruction& operator[](const usize index) const noexcept { return m_Code[index]; }
+            inline CompiledCode& operator<<(std::pair<blend::Instruction, ast::NodeIndex> inst) noexcept
             {
-                m_Code.push_back(std::move(inst));
+                m_Code.push_back(inst.first);
+                m_DebugNodes.push_back(inst.second);
                 return *this;
             }
             inline CompiledCode& operator<<(const u8 byte) noexcept
@@ -84,43 +141,67 @@ namespace relang::refront {
                 m_Data.push_back(byte);
                 return *this;
             }
-            inline operator blend::InstructionList() const noexcept
-            {
-                blend::InstructionList list{};
-                for (const auto& e : m_Code)
-                    list.push_back(e.first);
-                return list;
-            }
+            inline operator const blend::InstructionList&() const noexcept { return m_Code; }
+
+        public:
+            void BuildLineTable(const ast::SyntaxTree& tree);
+            bool WriteToBinary(const std::string& path) const;
+
+            friend class Linker;
+            friend class ObjectFile;
         };
 
-        std::pair<blend::Instruction, ast::Statement> MakeInst(const blend::Instruction& inst = blend::Instruction{},
-                                                               const ast::Statement& stmt = ast::Statement{}) noexcept;
+        std::pair<blend::Instruction, ast::NodeIndex> MakeInst(const blend::Instruction& inst = blend::Instruction{},
+                                                               const ast::NodeIndex      node = ast::NullNode) noexcept;
     } // namespace codegen
 
     class Compiler
     {
     private:
-        ast::SyntaxTree                          m_Tree{};
+        const ast::SyntaxTree&                   m_Tree; // Only read, so modules importing it can parse meanwhile.
         codegen::CompiledCode                    m_CompiledCode{};
         std::vector<codegen::FunctionDefinition> m_CompiledFunctions{};
-        std::vector<codegen::SymbolTable>        m_SymbolTableStack{};
+        std::vector<codegen::CallFixup>          m_CallFixups{};
+        ScopedSymbolTable<codegen::Symbol>       m_Symbols{}; // Functions in the outermost scope.
+        ir::Function                             m_Function{};     // The function currently being lowered.
+        ir::BlockIndex                           m_CurrentBlock{}; // The block lowered statements are appended to.
+        ir::OptimizationLevel                    m_Level;
 
     public:
-        Compiler(ast::SyntaxTree tree);
+        Compiler(const ast::SyntaxTree& tree, ir::OptimizationLevel level = ir::OptimizationLevel::O0);
 
     public:
         codegen::CompiledCode Compile();
-        void                  CompileFunctionBody(const ast::Statement& fnStmt);
-        void                  CompileBlockStatement(const ast::Statement& block);
-        void                  CompileVariableDeclaration(const ast::Statement& var);
-        void                  CompileInitializer(const ast::Statement& init);
-        void                  CompileExpression(const ast::Statement& expr);
-        void                  CompileLiteral(const ast::Statement& literal);
-        void                  CompileInitializerList(const ast::Statement& initList);
-        void                  CompileFunctionCall(const ast::Statement& fnCall);
-        void                  CompileIdentifierName(const ast::Statement& ident);
-        void                  CompileFunctionArgumentList(const ast::Statement& args);
-        void                  CompileWhileStatement(const ast::Statement& whst);
+        void                  CompileFunctionBody(const ast::Node& fnStmt);
+        void                  CompileStatement(const ast::Node& stmt);
+        void                  CompileBlockStatement(const ast::Node& block);
+        void                  CompileVariableDeclaration(const ast::Node& var);
+        ir::VReg              CompileInitializer(const ast::Node& init);
+        ir::VReg              CompileExpression(const ast::Node& expr);
+        ir::VReg              CompileLiteral(const ast::Node& literal);
+        ir::VReg              CompileFunctionCall(const ast::Node& fnCall);
+        ir::VReg              CompileIdentifierName(const ast::Node& ident);
+        void                  CompileCondition(const ast::Node& cond, ir::BlockIndex target, ir::BlockIndex alt);
+        void                  CompileIfStatement(const ast::Node& ifst);
+        void                  CompileWhileStatement(const ast::Node& whst);
+        void                  CompileReturnStatement(const ast::Node& retst);
+
+    private:
+        ir::VReg         Emit(const ir::Instruction& inst);
+        void             AssignTo(ir::VReg var, const ast::Node& expr, ir::VReg value);
+        void             SwitchToBlock(ir::BlockIndex block) noexcept;
+        codegen::Symbol* LookupSymbol(IdentId ident) noexcept;
+        void             EmitFunction(const ir::Function& fn, codegen::FunctionDefinition& def);
+        void             EmitInstruction(const ir::Instruction& inst, const codegen::Allocation& alloc,
+                                         std::span<const blend::RegType> saved, ir::BlockIndex next_block,
+                                         std::vector<std::pair<usize, ir::BlockIndex>>& jumps);
+        usize            EmitSwitch(const codegen::SwitchTable& table, const codegen::Allocation& alloc,
+                                    ast::NodeIndex node, ir::BlockIndex next_block,
+                                    std::vector<std::pair<usize, ir::BlockIndex>>& jumps);
+        blend::RegType   EmitUse(const codegen::Allocation& alloc, ir::VReg reg, blend::RegType scratch,
+                                 ast::NodeIndex node);
+        void             EmitDef(const codegen::Allocation& alloc, ir::VReg reg, blend::RegType value,
+                                 ast::NodeIndex node);
     };
 } // namespace relang::refront
 
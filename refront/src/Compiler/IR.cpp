@@ -0,0 +1,304 @@
+#include "IR.h"
+
+#include <algorithm>
+
+namespace relang::refront::ir {
+    namespace {
+        const char* GetOpCodeStr(const OpCode op) noexcept
+        {
+            switch (op)
+            {
+                using enum OpCode;
+
+                case Const: return "const";
+                case Copy: return "copy";
+                case Add: return "add";
+                case Sub: return "sub";
+                case Mul: return "mul";
+                case Div: return "div";
+                case Compare: return "cmp";
+                case String: return "str";
+                case Param: return "param";
+                case Arg: return "arg";
+                case Call: return "call";
+                case PrintInt: return "printi";
+                case PrintStr: return "prints";
+                case Jump: return "jmp";
+                case Branch: return "br";
+                case Return: return "ret";
+                case Phi: return "phi";
+            }
+            return "?";
+        }
+
+        const char* GetConditionStr(const Condition cond) noexcept
+        {
+            switch (cond)
+            {
+                using enum Condition;
+
+                case Equal: return "eq";
+                case NotEqual: return "ne";
+                case Less: return "lt";
+                case LessEqual: return "le";
+                case Greater: return "gt";
+                case GreaterEqual: return "ge";
+            }
+            return "?";
+        }
+    } // namespace
+
+    bool Instruction::IsTerminator() const noexcept
+    {
+        return op == OpCode::Jump || op == OpCode::Branch || op == OpCode::Return;
+    }
+
+    bool Instruction::IsPure() const noexcept
+    {
+        switch (op)
+        {
+            using enum OpCode;
+
+            case Const:
+            case Copy:
+            case Add:
+            case Sub:
+            case Mul:
+            case Div:
+            case Compare:
+            case String:
+            case Param:
+            case Phi: return true;
+            default: return false;
+        }
+    }
+
+    BlockIndex Function::NewBlock()
+    {
+        blocks.emplace_back();
+        layout.push_back((BlockIndex)blocks.size() - 1);
+        return (BlockIndex)blocks.size() - 1;
+    }
+
+    BlockIndex Function::NewBlockBefore(const BlockIndex before)
+    {
+        blocks.emplace_back();
+        const auto block = (BlockIndex)blocks.size() - 1;
+        layout.insert(std::find(layout.begin(), layout.end(), before), block);
+        return block;
+    }
+
+    bool Function::IsTerminated(const BlockIndex block) const noexcept
+    {
+        const auto& code = blocks[block].code;
+        return !code.empty() && code.back().IsTerminator();
+    }
+
+    usize Function::GetSuccessors(const BlockIndex block, BlockIndex (&succ)[2]) const noexcept
+    {
+        if (!IsTerminated(block))
+            return 0;
+
+        const auto& last = blocks[block].code.back();
+        switch (last.op)
+        {
+            case OpCode::Jump: succ[0] = last.target; return 1;
+            case OpCode::Branch:
+                succ[0] = last.target;
+                succ[1] = last.alt;
+                return 2;
+            default: return 0;
+        }
+    }
+
+    void Function::ReplaceSuccessor(const BlockIndex block, const BlockIndex from, const BlockIndex to) noexcept
+    {
+        if (!IsTerminated(block))
+            return;
+
+        auto& last = blocks[block].code.back();
+        if (last.op == OpCode::Jump || last.op == OpCode::Branch)
+        {
+            if (last.target == from)
+                last.target = to;
+        }
+        if (last.op == OpCode::Branch && last.alt == from)
+            last.alt = to;
+    }
+
+    void Function::RemoveBlock(const BlockIndex block)
+    {
+        // Successors no longer come from here, so drop the phi operands flowing out of the block.
+        BlockIndex succ[2]{};
+        const auto succ_count = GetSuccessors(block, succ);
+        for (usize s = 0; s < succ_count; ++s)
+        {
+            for (const auto& inst : blocks[succ[s]].code)
+            {
+                if (inst.op == OpCode::Phi)
+                    std::erase_if(phis[inst.imm], [block](const PhiOperand& op) { return op.block == block; });
+            }
+        }
+
+        blocks[block].code.clear();
+        std::erase(layout, block);
+    }
+
+    std::vector<std::vector<BlockIndex>> Function::GetPredecessors() const
+    {
+        std::vector<std::vector<BlockIndex>> preds(blocks.size());
+        for (const auto b : layout)
+        {
+            BlockIndex succ[2]{};
+            const auto succ_count = GetSuccessors(b, succ);
+            for (usize s = 0; s < succ_count; ++s)
+            {
+                // Both edges of a branch may lead to the same block, it is still just one predecessor.
+                if (s == 0 || succ[1] != succ[0])
+                    preds[succ[s]].push_back(b);
+            }
+        }
+        return preds;
+    }
+
+    std::vector<BlockIndex> Function::GetReversePostOrder() const
+    {
+        std::vector<BlockIndex> order{};
+        std::vector<bool>       visited(blocks.size());
+
+        // Iterative depth first search, the stack holds a block and how many of its successors were visited.
+        std::vector<std::pair<BlockIndex, usize>> stack{ { 0, 0 } };
+        visited[0] = true;
+        while (!stack.empty())
+        {
+            auto& [block, next] = stack.back();
+            BlockIndex succ[2]{};
+            const auto succ_count = GetSuccessors(block, succ);
+            if (next < succ_count)
+            {
+                const auto s = succ[next++];
+                if (!visited[s])
+                {
+                    visited[s] = true;
+                    stack.emplace_back(s, 0);
+                }
+                continue;
+            }
+            order.push_back(block);
+            stack.pop_back();
+        }
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+
+    void Function::Dump(std::ostream& os) const
+    {
+        os << "fn " << name << " (" << paramCount << " params, " << regCount << " vregs)\n";
+        for (const auto b : layout)
+        {
+            os << "  bb" << b << ":\n";
+            for (const auto& inst : blocks[b].code)
+            {
+                os << "    ";
+                if (inst.dst != NoReg)
+                    os << '%' << inst.dst << " = ";
+                os << GetOpCodeStr(inst.op);
+                if (inst.op == OpCode::Compare || inst.op == OpCode::Branch)
+                    os << '.' << GetConditionStr(inst.cond);
+                if (inst.a != NoReg)
+                    os << " %" << inst.a;
+                if (inst.b != NoReg)
+                    os << ", %" << inst.b;
+                if (inst.op == OpCode::Phi)
+                {
+                    for (const auto& operand : phis[inst.imm])
+                        os << " [bb" << operand.block << ": %" << operand.reg << ']';
+                }
+
+                switch (inst.op)
+                {
+                    using enum OpCode;
+
+                    case Const:
+                    case String:
+                    case Param:
+                    case Call: os << " $" << inst.imm; break;
+                    case Jump: os << " bb" << inst.target; break;
+                    case Branch: os << " bb" << inst.target << ", bb" << inst.alt; break;
+                    default: break;
+                }
+                os << '\n';
+            }
+        }
+    }
+
+    Liveness ComputeLiveness(const Function& fn)
+    {
+        const usize block_count = fn.blocks.size();
+
+        Liveness result{};
+        result.words = (fn.regCount + 63) / 64;
+        result.liveIn.resize(block_count * result.words);
+        result.liveOut.resize(block_count * result.words);
+
+        const auto       words = result.words;
+        std::vector<u64> use(block_count * words), def(block_count * words);
+        for (usize b = 0; b < block_count; ++b)
+        {
+            for (const auto& inst : fn.blocks[b].code)
+            {
+                for (const auto operand : { inst.a, inst.b })
+                {
+                    if (operand != NoReg && !((def[b * words + operand / 64] >> (operand % 64)) & 1))
+                        use[b * words + operand / 64] |= u64{ 1 } << (operand % 64);
+                }
+                if (inst.dst != NoReg)
+                    def[b * words + inst.dst / 64] |= u64{ 1 } << (inst.dst % 64);
+            }
+        }
+
+        // Backwards dataflow iterated until nothing changes. Going over the blocks in reverse lets most functions
+        // settle in a couple of passes.
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (usize b = block_count; b-- > 0;)
+            {
+                BlockIndex succ[2]{};
+                const auto succ_count = fn.GetSuccessors((BlockIndex)b, succ);
+                for (usize w = 0; w < words; ++w)
+                {
+                    u64 out = 0;
+                    for (usize s = 0; s < succ_count; ++s)
+                        out |= result.liveIn[succ[s] * words + w];
+
+                    const u64 in = use[b * words + w] | (out & ~def[b * words + w]);
+                    if (out != result.liveOut[b * words + w] || in != result.liveIn[b * words + w])
+                    {
+                        result.liveOut[b * words + w] = out;
+                        result.liveIn[b * words + w]  = in;
+                        changed                       = true;
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    Condition Invert(const Condition cond) noexcept
+    {
+        switch (cond)
+        {
+            using enum Condition;
+
+            case Equal: return NotEqual;
+            case NotEqual: return Equal;
+            case Less: return GreaterEqual;
+            case LessEqual: return Greater;
+            case Greater: return LessEqual;
+            case GreaterEqual: return Less;
+        }
+        return cond;
+    }
+} // namespace relang::refront::ir
@@ -0,0 +1,148 @@
+#ifndef CMC_COMPILER_IR_H
+#define CMC_COMPILER_IR_H
+
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "../Analyzer/Parser.h"
+
+namespace relang::refront::ir {
+    // Virtual registers, there is no limit on how many a function may use, the register allocator maps them onto
+    // the machine's registers and spills whatever does not fit.
+    using VReg       = u32;
+    using BlockIndex = u32;
+
+    constexpr VReg NoReg = ~VReg{};
+
+    enum class OpCode : u8
+    {
+        Const,    // dst = imm
+        Copy,     // dst = a
+        Add,      // dst = a + b
+        Sub,      // dst = a - b
+        Mul,      // dst = a * b
+        Div,      // dst = a / b
+        Compare,  // dst = (a cond b) ? 1 : 0
+        String,   // dst = address of the string at data offset imm
+        Param,    // dst = parameter number imm
+        Arg,      // pass a as the next argument of the following call
+        Call,     // dst = call of function number imm
+        PrintInt, // print a
+        PrintStr, // print the string a points to
+        Jump,     // goto target
+        Branch,   // if (a cond b) goto target else goto alt
+        Return,   // return a, if any
+        Phi       // dst = the operand of whichever predecessor was come from, operands are phis[imm]
+    };
+
+    enum class Condition : u8
+    {
+        Equal,
+        NotEqual,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual
+    };
+
+    struct Instruction
+    {
+        OpCode         op{};
+        Condition      cond{};
+        VReg           dst    = NoReg;
+        VReg           a      = NoReg;
+        VReg           b      = NoReg;
+        BlockIndex     target = 0;
+        BlockIndex     alt    = 0;
+        i64            imm{};
+        ast::NodeIndex node = ast::NullNode; // The syntax node the instruction was lowered from.
+
+    public:
+        bool IsTerminator() const noexcept;
+        bool IsPure() const noexcept; // Free of side effects, removable once nothing uses the result.
+    };
+
+    struct PhiOperand
+    {
+        BlockIndex block{};
+        VReg       reg = NoReg;
+    };
+
+    struct BasicBlock
+    {
+        std::vector<Instruction> code{};
+    };
+
+    struct Function
+    {
+        std::string_view                     name{};
+        u32                                  paramCount{};
+        u32                                  regCount{};
+        std::vector<BasicBlock>              blocks{};
+        std::vector<BlockIndex>              layout{}; // The order blocks are emitted in, blocks[0] is the entry.
+        std::vector<std::vector<PhiOperand>> phis{};
+
+    public:
+        inline VReg NewReg() noexcept { return regCount++; }
+        BlockIndex  NewBlock();
+        BlockIndex  NewBlockBefore(const BlockIndex before);
+        bool        IsTerminated(const BlockIndex block) const noexcept;
+        usize       GetSuccessors(const BlockIndex block, BlockIndex (&succ)[2]) const noexcept;
+        void        ReplaceSuccessor(const BlockIndex block, const BlockIndex from, const BlockIndex to) noexcept;
+        void        RemoveBlock(const BlockIndex block);
+        void        Dump(std::ostream& os) const;
+
+        std::vector<std::vector<BlockIndex>> GetPredecessors() const;
+        std::vector<BlockIndex>              GetReversePostOrder() const; // Reachable blocks only.
+
+        // Calls fn with a reference to every register the instruction reads, phi operands included.
+        template <typename Fn>
+        void ForEachUse(Instruction& inst, Fn&& fn)
+        {
+            if (inst.op == OpCode::Phi)
+            {
+                for (auto& operand : phis[inst.imm])
+                    fn(operand.reg);
+                return;
+            }
+            if (inst.a != NoReg)
+                fn(inst.a);
+            if (inst.b != NoReg)
+                fn(inst.b);
+        }
+    };
+
+    // Which registers are live on entry to and exit from each block, as bit sets indexed by virtual register.
+    // Computed on phi free code.
+    struct Liveness
+    {
+        usize            words{};
+        std::vector<u64> liveIn{};
+        std::vector<u64> liveOut{};
+
+    public:
+        inline std::span<const u64> GetLiveIn(const BlockIndex block) const noexcept
+        {
+            return std::span<const u64>{ liveIn }.subspan(block * words, words);
+        }
+        inline std::span<const u64> GetLiveOut(const BlockIndex block) const noexcept
+        {
+            return std::span<const u64>{ liveOut }.subspan(block * words, words);
+        }
+        inline bool IsLiveIn(const BlockIndex block, const VReg reg) const noexcept
+        {
+            return (liveIn[block * words + reg / 64] >> (reg % 64)) & 1;
+        }
+        inline bool IsLiveOut(const BlockIndex block, const VReg reg) const noexcept
+        {
+            return (liveOut[block * words + reg / 64] >> (reg % 64)) & 1;
+        }
+    };
+
+    Liveness  ComputeLiveness(const Function& fn);
+    Condition Invert(const Condition cond) noexcept;
+} // namespace relang::refront::ir
+
+#endif // CMC_COMPILER_IR_H
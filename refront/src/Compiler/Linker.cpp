@@ -0,0 +1,87 @@
+#include "Linker.h"
+
+#include <unordered_map>
+
+namespace relang::refront::codegen {
+    using namespace relang::blend;
+
+    std::optional<CompiledCode> Linker::Link(std::span<const CompiledCode* const> modules,
+                                             std::span<const std::string>         names)
+    {
+        constexpr usize StubSize = 2;
+
+        // Gather the functions first, modules call into modules that come after them.
+        std::unordered_map<std::string_view, usize> functions{};
+        for (usize i = 0, code_base = StubSize; i < modules.size(); code_base += modules[i++]->GetSize())
+        {
+            for (const auto& [function, address] : modules[i]->m_Exports)
+            {
+                if (!functions.emplace(function, code_base + address).second)
+                {
+                    std::cerr << "Link Error: " << names[i] << ": Multiple definitions of function '" << function
+                              << "'.\n";
+                    return std::nullopt;
+                }
+            }
+        }
+
+        const auto main = functions.find("main");
+        if (main == functions.end())
+        {
+            std::cerr << "Link Error: No module defines a 'main' function.\n";
+            return std::nullopt;
+        }
+
+        CompiledCode res{};
+        res << MakeInst({ .opcode = OpCode::Call, .imm64 = main->second });
+        res << MakeInst({ .opcode = OpCode::End });
+
+        for (usize i = 0; i < modules.size(); ++i)
+        {
+            const auto& module    = *modules[i];
+            const usize code_base = res.m_Code.size();
+            const usize data_base = res.m_Data.size();
+
+            res.m_Code.insert(res.m_Code.end(), module.m_Code.begin(), module.m_Code.end());
+            res.m_DebugNodes.insert(res.m_DebugNodes.end(), module.m_Code.size(), ast::NullNode);
+            res.m_Data.insert(res.m_Data.end(), module.m_Data.begin(), module.m_Data.end());
+            res.m_BssSize += module.m_BssSize;
+
+            // Node indices only mean something within their module's tree, so the rows come over already resolved.
+            for (auto row : module.m_LineTable)
+            {
+                row.index += (u32)code_base;
+                res.m_LineTable.push_back(row);
+            }
+
+            for (const auto& reloc : module.m_Relocations)
+            {
+                const usize offset = (reloc.type == RelocationType::Code) ? code_base : data_base;
+                if (reloc.field == RelocationField::Data)
+                {
+                    *(u64*)(res.m_Data.data() + data_base + reloc.index) += offset;
+                    continue;
+                }
+
+                auto& inst = res.m_Code[code_base + reloc.index];
+                if (reloc.field == RelocationField::Imm64)
+                    inst.imm64 += offset;
+                else
+                    inst.disp += (i32)offset;
+            }
+
+            for (const auto& import : module.m_Imports)
+            {
+                auto it = functions.find(import.function);
+                if (it == functions.end())
+                {
+                    std::cerr << "Link Error: " << names[i] << ": Call to an undefined function '" << import.function
+                              << "'.\n";
+                    return std::nullopt;
+                }
+                res.m_Code[code_base + import.index].imm64 = (u64)it->second;
+            }
+        }
+        return res;
+    }
+} // namespace relang::refront::codegen
@@ -0,0 +1,21 @@
+#ifndef CMC_COMPILER_LINKER_H
+#define CMC_COMPILER_LINKER_H
+
+#include <optional>
+#include <span>
+#include <string>
+
+#include "Compiler.h"
+
+namespace relang::refront::codegen {
+    // Merges the relocatable code of every module into one program. Modules are laid out in order behind a stub that
+    // calls main and halts with its return value.
+    class Linker
+    {
+    public:
+        static std::optional<CompiledCode> Link(std::span<const CompiledCode* const> modules,
+                                                std::span<const std::string>         names);
+    };
+} // namespace relang::refront::codegen
+
+#endif // CMC_COMPILER_LINKER_H
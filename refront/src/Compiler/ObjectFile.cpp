@@ -0,0 +1,161 @@
+#include "ObjectFile.h"
+
+#include <fstream>
+
+namespace relang::refront::codegen {
+    namespace {
+        template <typename T>
+        void WriteValue(std::ofstream& fs, const T& value)
+        {
+            fs.write((const char*)&value, sizeof(T));
+        }
+
+        void WriteString(std::ofstream& fs, const std::string& str)
+        {
+            WriteValue(fs, (u32)str.size());
+            fs.write(str.data(), str.size());
+        }
+
+        template <typename T>
+        bool ReadValue(std::ifstream& fs, T& value)
+        {
+            return (bool)fs.read((char*)&value, sizeof(T));
+        }
+
+        bool ReadString(std::ifstream& fs, std::string& str)
+        {
+            u32 size = 0;
+            if (!ReadValue(fs, size))
+                return false;
+            str.resize(size);
+            return (bool)fs.read(str.data(), size);
+        }
+    } // namespace
+
+    bool ObjectFile::Write(const std::string& path, const CompiledCode& code, const std::string& interface)
+    {
+        std::ofstream fs(path, std::ios::binary);
+        if (!fs.is_open())
+            return false;
+
+        WriteValue(fs, OBJECT_FILE_MAGIC);
+
+        WriteValue(fs, blend::DATA_SECTION_INDIC);
+        WriteValue(fs, (usize)code.m_Data.size());
+        fs.write((const char*)code.m_Data.data(), code.m_Data.size());
+
+        WriteValue(fs, blend::BSS_SECTION_INDIC);
+        WriteValue(fs, code.m_BssSize);
+
+        WriteValue(fs, blend::CODE_SECTION_INDIC);
+        WriteValue(fs, (usize)(code.m_Code.size() * sizeof(blend::Instruction)));
+        fs.write((const char*)code.m_Code.data(), code.m_Code.size() * sizeof(blend::Instruction));
+
+        WriteValue(fs, blend::LINE_TABLE_SECTION_INDIC);
+        WriteValue(fs, (usize)(code.m_LineTable.size() * sizeof(LineEntry)));
+        fs.write((const char*)code.m_LineTable.data(), code.m_LineTable.size() * sizeof(LineEntry));
+
+        WriteValue(fs, EXPORT_SECTION_INDIC);
+        WriteValue(fs, (usize)code.m_Exports.size());
+        for (const auto& exported : code.m_Exports)
+        {
+            WriteString(fs, exported.function);
+            WriteValue(fs, exported.address);
+        }
+
+        WriteValue(fs, RELOCATION_SECTION_INDIC);
+        WriteValue(fs, (usize)code.m_Relocations.size());
+        for (const auto& reloc : code.m_Relocations)
+        {
+            WriteValue(fs, reloc.index);
+            WriteValue(fs, reloc.type);
+            WriteValue(fs, reloc.field);
+        }
+
+        WriteValue(fs, IMPORT_SECTION_INDIC);
+        WriteValue(fs, (usize)code.m_Imports.size());
+        for (const auto& import : code.m_Imports)
+        {
+            WriteString(fs, import.function);
+            WriteValue(fs, import.index);
+        }
+
+        WriteValue(fs, INTERFACE_SECTION_INDIC);
+        WriteValue(fs, (usize)interface.size());
+        fs.write(interface.data(), interface.size());
+
+        return (bool)fs;
+    }
+
+    bool ObjectFile::Read(const std::string& path, CompiledCode& code, std::string& interface)
+    {
+        std::ifstream fs(path, std::ios::binary);
+        if (!fs.is_open())
+            return false;
+
+        u32 magic = 0;
+        if (!ReadValue(fs, magic) || magic != OBJECT_FILE_MAGIC)
+            return false;
+
+        u8    indic{};
+        usize size = 0;
+        while (ReadValue(fs, indic))
+        {
+            if (!ReadValue(fs, size))
+                return false;
+
+            switch (indic)
+            {
+                case blend::DATA_SECTION_INDIC:
+                    code.m_Data.resize(size);
+                    fs.read((char*)code.m_Data.data(), size);
+                    break;
+                case blend::BSS_SECTION_INDIC: code.m_BssSize = size; break;
+                case blend::CODE_SECTION_INDIC:
+                    code.m_Code.resize(size / sizeof(blend::Instruction));
+                    fs.read((char*)code.m_Code.data(), size);
+
+                    // The nodes belonged to a tree that is gone, the line table already holds what they were for.
+                    code.m_DebugNodes.assign(code.m_Code.size(), ast::NullNode);
+                    break;
+                case blend::LINE_TABLE_SECTION_INDIC:
+                    code.m_LineTable.resize(size / sizeof(LineEntry));
+                    fs.read((char*)code.m_LineTable.data(), size);
+                    break;
+                case EXPORT_SECTION_INDIC:
+                    code.m_Exports.resize(size);
+                    for (auto& exported : code.m_Exports)
+                    {
+                        if (!ReadString(fs, exported.function) || !ReadValue(fs, exported.address))
+                            return false;
+                    }
+                    break;
+                case RELOCATION_SECTION_INDIC:
+                    code.m_Relocations.resize(size);
+                    for (auto& reloc : code.m_Relocations)
+                    {
+                        if (!ReadValue(fs, reloc.index) || !ReadValue(fs, reloc.type) || !ReadValue(fs, reloc.field))
+                            return false;
+                    }
+                    break;
+                case IMPORT_SECTION_INDIC:
+                    code.m_Imports.resize(size);
+                    for (auto& import : code.m_Imports)
+                    {
+                        if (!ReadString(fs, import.function) || !ReadValue(fs, import.index))
+                            return false;
+                    }
+                    break;
+                case INTERFACE_SECTION_INDIC:
+                    interface.resize(size);
+                    fs.read(interface.data(), size);
+                    break;
+                default: return false;
+            }
+
+            if (!fs)
+                return false;
+        }
+        return true;
+    }
+} // namespace relang::refront::codegen
@@ -0,0 +1,26 @@
+#ifndef CMC_COMPILER_OBJECT_FILE_H
+#define CMC_COMPILER_OBJECT_FILE_H
+
+#include <string>
+
+#include "Compiler.h"
+
+namespace relang::refront::codegen {
+    // A module's relocatable code on disk, laid out like basm's object files: the executable sections (data, bss,
+    // code, line table) after a magic header, followed by the link sections and the module's interface, the source
+    // text of the functions it defines.
+    constexpr u32 OBJECT_FILE_MAGIC        = 0x4F465200; // "\0RFO"
+    constexpr u8  EXPORT_SECTION_INDIC     = 0xFA;
+    constexpr u8  RELOCATION_SECTION_INDIC = 0xF9;
+    constexpr u8  IMPORT_SECTION_INDIC     = 0xF8;
+    constexpr u8  INTERFACE_SECTION_INDIC  = 0xF6;
+
+    class ObjectFile
+    {
+    public:
+        static bool Write(const std::string& path, const CompiledCode& code, const std::string& interface);
+        static bool Read(const std::string& path, CompiledCode& code, std::string& interface);
+    };
+} // namespace relang::refront::codegen
+
+#endif // CMC_COMPILER_OBJECT_FILE_H
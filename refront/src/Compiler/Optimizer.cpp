@@ -0,0 +1,689 @@
+#include "Optimizer.h"
+
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+
+#include "SSA.h"
+
+namespace relang::refront::ir {
+    namespace {
+        // How many times the scalar passes are repeated at most, each one tends to expose work for the others.
+        constexpr u32 MaxRounds = 8;
+
+        // Evaluates the operation the way the VM would, on wrapping 64-bit registers. Comparisons look at the sign
+        // of the difference just like the flags Blend's cmp leaves. Division by zero is left to fault at runtime.
+        std::optional<u64> Evaluate(const OpCode op, const Condition cond, const u64 lhs, const u64 rhs) noexcept
+        {
+            const auto sign = [](const u64 value) { return (i64)value < 0; };
+            switch (op)
+            {
+                case OpCode::Add: return lhs + rhs;
+                case OpCode::Sub: return lhs - rhs;
+                case OpCode::Mul: return lhs * rhs;
+                case OpCode::Div: return (rhs == 0) ? std::nullopt : std::optional<u64>{ lhs / rhs };
+                case OpCode::Compare:
+                case OpCode::Branch:
+                    switch (cond)
+                    {
+                        using enum Condition;
+
+                        case Equal: return lhs == rhs;
+                        case NotEqual: return lhs != rhs;
+                        case Less: return sign(lhs - rhs);
+                        case LessEqual: return !sign(rhs - lhs);
+                        case Greater: return sign(rhs - lhs);
+                        case GreaterEqual: return !sign(lhs - rhs);
+                    }
+                    return std::nullopt;
+                default: return std::nullopt;
+            }
+        }
+
+        struct ExpressionKey
+        {
+            OpCode    op{};
+            Condition cond{};
+            VReg      a = NoReg;
+            VReg      b = NoReg;
+            i64       imm{};
+
+        public:
+            bool operator==(const ExpressionKey&) const noexcept = default;
+        };
+
+        struct ExpressionKeyHash
+        {
+            usize operator()(const ExpressionKey& key) const noexcept
+            {
+                usize hash = (usize)key.op << 8 | (usize)key.cond;
+                for (const usize part : { (usize)key.a, (usize)key.b, (usize)key.imm })
+                    hash = hash * 0x9E3779B97F4A7C15ull + part;
+                return hash;
+            }
+        };
+
+        struct Loop
+        {
+            BlockIndex              header{};
+            BlockIndex              preheader = NoBlock; // The only way in, a block that does nothing but jump.
+            std::vector<BlockIndex> latches{};           // Blocks with a back edge to the header.
+            std::vector<BlockIndex> blocks{};
+            std::vector<bool>       body{};              // Indexed by block.
+        };
+
+        // Natural loops, one per header, innermost first.
+        std::vector<Loop> FindLoops(const Function& fn, const std::vector<std::vector<BlockIndex>>& preds,
+                                    const DominatorTree& dom)
+        {
+            std::vector<Loop> loops{};
+            for (const auto b : fn.layout)
+            {
+                BlockIndex succ[2]{};
+                const auto succ_count = fn.GetSuccessors(b, succ);
+                for (usize s = 0; s < succ_count; ++s)
+                {
+                    if (!dom.Dominates(succ[s], b))
+                        continue;
+                    auto loop = std::find_if(loops.begin(), loops.end(),
+                                             [&](const Loop& l) { return l.header == succ[s]; });
+                    if (loop == loops.end())
+                        loop = loops.insert(loops.end(), Loop{ .header = succ[s] });
+                    if (std::find(loop->latches.begin(), loop->latches.end(), b) == loop->latches.end())
+                        loop->latches.push_back(b);
+                }
+            }
+
+            for (auto& loop : loops)
+            {
+                loop.body.resize(fn.blocks.size());
+                loop.body[loop.header] = true;
+                loop.blocks.push_back(loop.header);
+
+                auto worklist = loop.latches;
+                while (!worklist.empty())
+                {
+                    const auto b = worklist.back();
+                    worklist.pop_back();
+                    if (loop.body[b])
+                        continue;
+                    loop.body[b] = true;
+                    loop.blocks.push_back(b);
+                    worklist.insert(worklist.end(), preds[b].begin(), preds[b].end());
+                }
+
+                std::vector<BlockIndex> outside{};
+                std::copy_if(preds[loop.header].begin(), preds[loop.header].end(), std::back_inserter(outside),
+                             [&loop](const BlockIndex pred) { return !loop.body[pred]; });
+                if (outside.size() == 1 && fn.blocks[outside[0]].code.back().op == OpCode::Jump)
+                    loop.preheader = outside[0];
+            }
+
+            std::sort(loops.begin(), loops.end(),
+                      [](const Loop& lhs, const Loop& rhs) { return lhs.blocks.size() < rhs.blocks.size(); });
+            return loops;
+        }
+
+        // Gives a loop entered through one side of a branch a block of its own to hoist code into.
+        bool InsertPreheaders(Function& fn)
+        {
+            const auto preds = fn.GetPredecessors();
+            const auto dom   = DominatorTree{ fn, preds };
+
+            bool changed = false;
+            for (const auto& loop : FindLoops(fn, preds, dom))
+            {
+                std::vector<BlockIndex> outside{};
+                std::copy_if(preds[loop.header].begin(), preds[loop.header].end(), std::back_inserter(outside),
+                             [&loop](const BlockIndex pred) { return !loop.body[pred]; });
+                if (loop.preheader != NoBlock || outside.size() != 1)
+                    continue;
+
+                const auto pred      = outside[0];
+                const auto preheader = fn.NewBlockBefore(loop.header);
+                fn.blocks[preheader].code.push_back(Instruction{ .op = OpCode::Jump, .target = loop.header });
+                fn.ReplaceSuccessor(pred, loop.header, preheader);
+                for (const auto& inst : fn.blocks[loop.header].code)
+                {
+                    if (inst.op != OpCode::Phi)
+                        break;
+                    for (auto& operand : fn.phis[inst.imm])
+                    {
+                        if (operand.block == pred)
+                            operand.block = preheader;
+                    }
+                }
+                changed = true;
+            }
+            return changed;
+        }
+
+        // The block each register is defined in.
+        std::vector<BlockIndex> GetDefinitionBlocks(const Function& fn)
+        {
+            std::vector<BlockIndex> result(fn.regCount, NoBlock);
+            for (const auto b : fn.layout)
+            {
+                for (const auto& inst : fn.blocks[b].code)
+                {
+                    if (inst.dst != NoReg)
+                        result[inst.dst] = b;
+                }
+            }
+            return result;
+        }
+
+        std::vector<std::optional<u64>> GetConstants(const Function& fn)
+        {
+            std::vector<std::optional<u64>> result(fn.regCount);
+            for (const auto b : fn.layout)
+            {
+                for (const auto& inst : fn.blocks[b].code)
+                {
+                    if (inst.op == OpCode::Const)
+                        result[inst.dst] = (u64)inst.imm;
+                }
+            }
+            return result;
+        }
+
+        inline void InsertBeforeTerminator(Function& fn, const BlockIndex block, const Instruction& inst)
+        {
+            auto& code = fn.blocks[block].code;
+            code.insert(code.end() - 1, inst);
+        }
+    } // namespace
+
+    Optimizer::Optimizer(Function& fn, const OptimizationLevel level) : m_Function(fn), m_Level(level)
+    {
+    }
+
+    void Optimizer::Run()
+    {
+        if (m_Level == OptimizationLevel::O0)
+            return;
+
+        BuildSSA(m_Function);
+
+        const auto simplify = [this]
+        {
+            bool changed = true;
+            for (u32 round = 0; changed && round < MaxRounds; ++round)
+                changed = FoldConstants() | EliminateCommonSubexpressions() | EliminateDeadCode();
+        };
+
+        simplify();
+        if (m_Level == OptimizationLevel::O2)
+        {
+            const bool hoisted = HoistLoopInvariants();
+            const bool reduced = ReduceStrength();
+            if (hoisted || reduced)
+                simplify();
+        }
+
+        DestructSSA(m_Function);
+    }
+
+    bool Optimizer::FoldConstants()
+    {
+        auto& fn = m_Function;
+
+        bool changed_any = false;
+        bool changed     = true;
+        while (changed)
+        {
+            changed = false;
+            ResetAliases();
+
+            std::vector<std::optional<u64>> value(fn.regCount);
+            bool                            edges_removed = false;
+            for (const auto b : fn.GetReversePostOrder())
+            {
+                auto&                    code = fn.blocks[b].code;
+                std::vector<Instruction> folded{};
+                folded.reserve(code.size());
+                for (auto inst : code)
+                {
+                    fn.ForEachUse(inst, [this](VReg& reg) { reg = Resolve(reg); });
+
+                    const auto lhs = (inst.a != NoReg) ? value[inst.a] : std::nullopt;
+                    const auto rhs = (inst.b != NoReg) ? value[inst.b] : std::nullopt;
+
+                    // The result is either a constant, another register or still has to be computed.
+                    std::optional<u64> constant{};
+                    VReg               same = NoReg;
+                    switch (inst.op)
+                    {
+                        using enum OpCode;
+
+                        case Const: value[inst.dst] = (u64)inst.imm; break;
+                        case Copy: same = inst.a; break;
+                        case Add:
+                        case Sub:
+                        case Mul:
+                        case Div:
+                        case Compare:
+                            if (lhs && rhs)
+                                constant = Evaluate(inst.op, inst.cond, *lhs, *rhs);
+                            else if (inst.a == inst.b && (inst.op == Sub || inst.op == Compare))
+                                constant = Evaluate(inst.op, inst.cond, 0, 0);
+                            else if ((inst.op == Add && lhs == 0) || (inst.op == Mul && lhs == 1))
+                                same = inst.b;
+                            else if (((inst.op == Add || inst.op == Sub) && rhs == 0) ||
+                                     ((inst.op == Mul || inst.op == Div) && rhs == 1))
+                                same = inst.a;
+                            else if (inst.op == Mul && (lhs == 0 || rhs == 0))
+                                constant = 0;
+                            break;
+                        case Phi:
+                        {
+                            // Every way in brings the same register, or the phi itself around a loop.
+                            bool unique = true;
+                            for (const auto& operand : fn.phis[inst.imm])
+                            {
+                                if (operand.reg == inst.dst || operand.reg == same)
+                                    continue;
+                                unique = unique && same == NoReg;
+                                same   = operand.reg;
+                            }
+                            if (!unique)
+                                same = NoReg;
+                            break;
+                        }
+                        case Branch:
+                        {
+                            std::optional<u64> taken{};
+                            if (lhs && rhs)
+                                taken = Evaluate(inst.op, inst.cond, *lhs, *rhs);
+                            else if (inst.a == inst.b)
+                                taken = Evaluate(inst.op, inst.cond, 0, 0);
+                            else if (inst.target == inst.alt)
+                                taken = 1;
+                            if (!taken)
+                                break;
+
+                            const auto target  = (*taken) ? inst.target : inst.alt;
+                            const auto dropped = (*taken) ? inst.alt : inst.target;
+                            if (dropped != target)
+                            {
+                                for (const auto& succ_inst : fn.blocks[dropped].code)
+                                {
+                                    if (succ_inst.op != Phi)
+                                        break;
+                                    std::erase_if(fn.phis[succ_inst.imm],
+                                                  [b](const PhiOperand& op) { return op.block == b; });
+                                }
+                                edges_removed = true;
+                            }
+                            inst    = Instruction{ .op = Jump, .target = target, .node = inst.node };
+                            changed = true;
+                            break;
+                        }
+                        default: break;
+                    }
+
+                    if (constant)
+                    {
+                        inst            = Instruction{ .op = OpCode::Const, .dst = inst.dst, .imm = (i64)*constant,
+                                                       .node = inst.node };
+                        value[inst.dst] = constant;
+                        changed         = true;
+                    }
+                    else if (same != NoReg)
+                    {
+                        m_Alias[inst.dst] = same;
+                        changed           = true;
+                        continue;
+                    }
+                    folded.push_back(inst);
+                }
+                code = std::move(folded);
+            }
+
+            ApplyAliases();
+            if (edges_removed)
+                RemoveUnreachableBlocks(fn);
+            changed_any = changed_any || changed;
+        }
+        return changed_any;
+    }
+
+    bool Optimizer::EliminateCommonSubexpressions()
+    {
+        auto& fn = m_Function;
+        ResetAliases();
+
+        const auto preds = fn.GetPredecessors();
+        const auto dom   = DominatorTree{ fn, preds };
+
+        // Expressions computed on the way down the dominator tree, the log undoes a subtree's entries on the way up.
+        std::unordered_map<ExpressionKey, VReg, ExpressionKeyHash> available{};
+        std::vector<ExpressionKey>                                 log{};
+        std::vector<usize>                                         marks{ 0 };
+        std::vector<std::pair<BlockIndex, usize>>                  stack{ { 0, 0 } };
+
+        bool changed = false;
+        while (!stack.empty())
+        {
+            auto& [block, next] = stack.back();
+            if (next == 0)
+            {
+                auto& code = fn.blocks[block].code;
+                std::erase_if(code,
+                              [&](Instruction& inst)
+                              {
+                                  fn.ForEachUse(inst, [this](VReg& reg) { reg = Resolve(reg); });
+                                  switch (inst.op)
+                                  {
+                                      using enum OpCode;
+
+                                      case Const:
+                                      case String:
+                                      case Add:
+                                      case Sub:
+                                      case Mul:
+                                      case Div:
+                                      case Compare: break;
+                                      default: return false;
+                                  }
+
+                                  ExpressionKey key{ inst.op, inst.cond, inst.a, inst.b, inst.imm };
+                                  const bool    commutative =
+                                      inst.op == OpCode::Add || inst.op == OpCode::Mul ||
+                                      (inst.op == OpCode::Compare &&
+                                       (inst.cond == Condition::Equal || inst.cond == Condition::NotEqual));
+                                  if (commutative && key.a > key.b)
+                                      std::swap(key.a, key.b);
+
+                                  if (const auto it = available.find(key); it != available.end())
+                                  {
+                                      m_Alias[inst.dst] = it->second;
+                                      changed           = true;
+                                      return true;
+                                  }
+                                  available.emplace(key, inst.dst);
+                                  log.push_back(key);
+                                  return false;
+                              });
+            }
+
+            const auto& children = dom.GetChildren(block);
+            if (next < children.size())
+            {
+                stack.emplace_back(children[next++], 0);
+                marks.push_back(log.size());
+                continue;
+            }
+
+            for (usize i = log.size(); i > marks.back(); --i)
+                available.erase(log[i - 1]);
+            log.resize(marks.back());
+            marks.pop_back();
+            stack.pop_back();
+        }
+
+        ApplyAliases();
+        return changed;
+    }
+
+    bool Optimizer::EliminateDeadCode()
+    {
+        auto& fn = m_Function;
+
+        // Mark everything side effects and control flow depend on, then sweep the pure instructions left unmarked.
+        std::vector<Instruction*> defs(fn.regCount);
+        std::vector<bool>         live(fn.regCount);
+        std::vector<VReg>         worklist{};
+
+        const auto mark = [&](VReg& reg)
+        {
+            if (!live[reg])
+            {
+                live[reg] = true;
+                worklist.push_back(reg);
+            }
+        };
+
+        for (const auto b : fn.layout)
+        {
+            for (auto& inst : fn.blocks[b].code)
+            {
+                if (inst.dst != NoReg)
+                    defs[inst.dst] = &inst;
+                if (!inst.IsPure())
+                    fn.ForEachUse(inst, mark);
+            }
+        }
+        while (!worklist.empty())
+        {
+            const auto reg = worklist.back();
+            worklist.pop_back();
+            if (defs[reg] && defs[reg]->IsPure())
+                fn.ForEachUse(*defs[reg], mark);
+        }
+
+        bool changed = false;
+        for (const auto b : fn.layout)
+        {
+            changed |= std::erase_if(fn.blocks[b].code, [&live](const Instruction& inst)
+                                     { return inst.IsPure() && !live[inst.dst]; }) > 0;
+        }
+        return changed;
+    }
+
+    bool Optimizer::HoistLoopInvariants()
+    {
+        auto& fn = m_Function;
+
+        bool changed = InsertPreheaders(fn);
+
+        const auto preds     = fn.GetPredecessors();
+        const auto dom       = DominatorTree{ fn, preds };
+        const auto constants = GetConstants(fn);
+        auto       def_block = GetDefinitionBlocks(fn);
+
+        // Inner loops go first so what they hoist into their preheader can keep moving out of the enclosing loops.
+        for (const auto& loop : FindLoops(fn, preds, dom))
+        {
+            if (loop.preheader == NoBlock)
+                continue;
+
+            const auto invariant = [&](const VReg reg)
+            { return reg == NoReg || def_block[reg] == NoBlock || !loop.body[def_block[reg]]; };
+            const auto hoistable = [&](const Instruction& inst)
+            {
+                switch (inst.op)
+                {
+                    using enum OpCode;
+
+                    case Const:
+                    case String:
+                    case Add:
+                    case Sub:
+                    case Mul:
+                    case Compare: break;
+                    // Dividing by zero faults, only move divisions that cannot.
+                    case Div:
+                        if (!constants[inst.b] || *constants[inst.b] == 0)
+                            return false;
+                        break;
+                    default: return false;
+                }
+                return invariant(inst.a) && invariant(inst.b);
+            };
+
+            bool moved = true;
+            while (moved)
+            {
+                moved = false;
+                for (const auto b : loop.blocks)
+                {
+                    auto& code = fn.blocks[b].code;
+                    for (usize i = 0; i < code.size();)
+                    {
+                        if (!hoistable(code[i]))
+                        {
+                            ++i;
+                            continue;
+                        }
+                        def_block[code[i].dst] = loop.preheader;
+                        InsertBeforeTerminator(fn, loop.preheader, code[i]);
+                        code.erase(code.begin() + (std::ptrdiff_t)i);
+                        moved = changed = true;
+                    }
+                }
+            }
+        }
+        return changed;
+    }
+
+    bool Optimizer::ReduceStrength()
+    {
+        auto& fn = m_Function;
+        ResetAliases();
+
+        // Blend has no shifts, a doubling is cheapest as an addition.
+        bool changed   = false;
+        auto constants = GetConstants(fn);
+        for (const auto b : fn.layout)
+        {
+            for (auto& inst : fn.blocks[b].code)
+            {
+                if (inst.op != OpCode::Mul)
+                    continue;
+                if (constants[inst.a] == 2)
+                    std::swap(inst.a, inst.b);
+                if (constants[inst.b] == 2)
+                {
+                    inst.op = OpCode::Add;
+                    inst.b  = inst.a;
+                    changed = true;
+                }
+            }
+        }
+
+        // Induction variable strength reduction. For a basic induction variable i stepping by an invariant s, every
+        // i * c with an invariant c becomes a new variable j starting at init * c and stepping by s * c.
+        const auto preds     = fn.GetPredecessors();
+        const auto dom       = DominatorTree{ fn, preds };
+        const auto def_block = GetDefinitionBlocks(fn);
+        for (const auto& loop : FindLoops(fn, preds, dom))
+        {
+            if (loop.preheader == NoBlock || loop.latches.size() != 1)
+                continue;
+
+            const auto latch     = loop.latches[0];
+            // Registers made by an earlier loop have no recorded block, they are not known to be invariant.
+            const auto invariant = [&](const VReg reg)
+            { return reg < def_block.size() && (def_block[reg] == NoBlock || !loop.body[def_block[reg]]); };
+            const auto find_def  = [&](const VReg reg) -> Instruction*
+            {
+                for (auto& inst : fn.blocks[def_block[reg]].code)
+                {
+                    if (inst.dst == reg)
+                        return &inst;
+                }
+                return nullptr;
+            };
+
+            std::vector<Instruction> phis{};
+            std::copy_if(fn.blocks[loop.header].code.begin(), fn.blocks[loop.header].code.end(),
+                         std::back_inserter(phis), [](const Instruction& inst) { return inst.op == OpCode::Phi; });
+            for (const auto& phi : phis)
+            {
+                if (fn.phis[phi.imm].size() != 2)
+                    continue;
+
+                VReg init = NoReg, next = NoReg;
+                for (const auto& operand : fn.phis[phi.imm])
+                {
+                    if (operand.block == loop.preheader)
+                        init = operand.reg;
+                    else if (operand.block == latch)
+                        next = operand.reg;
+                }
+                if (init == NoReg || next == NoReg || def_block[next] == NoBlock || !loop.body[def_block[next]])
+                    continue;
+
+                const auto* update = find_def(next);
+                if (!update || !((update->op == OpCode::Add && (update->a == phi.dst || update->b == phi.dst)) ||
+                                 (update->op == OpCode::Sub && update->a == phi.dst)))
+                    continue;
+                const auto step = (update->a == phi.dst) ? update->b : update->a;
+                if (step == phi.dst || !invariant(step))
+                    continue;
+                const auto step_op = update->op;
+
+                // Group the multiplications by their invariant factor, one new variable serves each group.
+                std::vector<std::pair<VReg, std::vector<VReg>>> factors{};
+                for (const auto b : loop.blocks)
+                {
+                    for (const auto& inst : fn.blocks[b].code)
+                    {
+                        if (inst.op != OpCode::Mul || (inst.a != phi.dst && inst.b != phi.dst))
+                            continue;
+                        const auto factor = (inst.a == phi.dst) ? inst.b : inst.a;
+                        if (factor == phi.dst || !invariant(factor))
+                            continue;
+                        auto group = std::find_if(factors.begin(), factors.end(),
+                                                  [factor](const auto& f) { return f.first == factor; });
+                        if (group == factors.end())
+                            group = factors.insert(factors.end(), { factor, {} });
+                        group->second.push_back(inst.dst);
+                    }
+                }
+
+                for (const auto& [factor, products] : factors)
+                {
+                    const auto start = fn.NewReg(), stride = fn.NewReg(), value = fn.NewReg(), stepped = fn.NewReg();
+                    InsertBeforeTerminator(fn, loop.preheader,
+                                           Instruction{ .op = OpCode::Mul, .dst = start, .a = init, .b = factor });
+                    InsertBeforeTerminator(fn, loop.preheader,
+                                           Instruction{ .op = OpCode::Mul, .dst = stride, .a = step, .b = factor });
+
+                    auto& update_code = fn.blocks[def_block[next]].code;
+                    const auto at     = std::find_if(update_code.begin(), update_code.end(),
+                                                     [next](const Instruction& inst) { return inst.dst == next; });
+                    update_code.insert(at + 1, Instruction{ .op = step_op, .dst = stepped, .a = value, .b = stride });
+
+                    auto& header_code = fn.blocks[loop.header].code;
+                    header_code.insert(header_code.begin(),
+                                       Instruction{ .op = OpCode::Phi, .dst = value, .imm = (i64)fn.phis.size() });
+                    fn.phis.push_back({ { loop.preheader, start }, { latch, stepped } });
+
+                    for (const auto product : products)
+                        m_Alias[product] = value;
+                    changed = true;
+                }
+            }
+        }
+
+        // The replaced products are dead now, the aliases route their uses to the new variables.
+        ApplyAliases();
+        return changed;
+    }
+
+    void Optimizer::ResetAliases()
+    {
+        m_Alias.resize(m_Function.regCount);
+        for (VReg r = 0; r < m_Function.regCount; ++r)
+            m_Alias[r] = r;
+    }
+
+    VReg Optimizer::Resolve(VReg reg) noexcept
+    {
+        // Registers made after the aliases were reset stand for themselves.
+        while (reg < m_Alias.size() && m_Alias[reg] != reg)
+            reg = m_Alias[reg];
+        return reg;
+    }
+
+    void Optimizer::ApplyAliases()
+    {
+        for (const auto b : m_Function.layout)
+        {
+            for (auto& inst : m_Function.blocks[b].code)
+                m_Function.ForEachUse(inst, [this](VReg& reg) { reg = Resolve(reg); });
+        }
+    }
+} // namespace relang::refront::ir
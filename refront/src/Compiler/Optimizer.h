@@ -0,0 +1,43 @@
+#ifndef CMC_COMPILER_OPTIMIZER_H
+#define CMC_COMPILER_OPTIMIZER_H
+
+#include <vector>
+
+#include "IR.h"
+
+namespace relang::refront::ir {
+    enum class OptimizationLevel : u8
+    {
+        O0, // Lowered code goes straight to the register allocator.
+        O1, // SSA with constant and copy propagation, common subexpression and dead code elimination.
+        O2  // O1 plus loop invariant code motion and strength reduction.
+    };
+
+    // Runs the passes the level asks for over one function. The function is taken into SSA form first and back out
+    // of it last, so the backend only ever sees copies.
+    class Optimizer
+    {
+    private:
+        Function&         m_Function;
+        OptimizationLevel m_Level;
+        std::vector<VReg> m_Alias{}; // Registers a pass found equal to another one, see Resolve.
+
+    public:
+        Optimizer(Function& fn, OptimizationLevel level);
+
+    public:
+        void Run();
+
+    private:
+        bool FoldConstants();
+        bool EliminateCommonSubexpressions();
+        bool EliminateDeadCode();
+        bool HoistLoopInvariants();
+        bool ReduceStrength();
+        void ResetAliases();
+        VReg Resolve(VReg reg) noexcept;
+        void ApplyAliases();
+    };
+} // namespace relang::refront::ir
+
+#endif // CMC_COMPILER_OPTIMIZER_H
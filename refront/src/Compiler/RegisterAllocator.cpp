@@ -0,0 +1,127 @@
+#include "RegisterAllocator.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace relang::refront::codegen {
+    using namespace relang::blend;
+
+    RegisterAllocator::RegisterAllocator(const ir::Function& fn, std::span<const RegType> pool)
+        : m_Function(fn), m_Pool(pool)
+    {
+    }
+
+    Allocation RegisterAllocator::Allocate()
+    {
+        ComputeIntervals();
+        std::sort(m_Intervals.begin(), m_Intervals.end(),
+                  [](const LiveInterval& lhs, const LiveInterval& rhs) { return lhs.start < rhs.start; });
+
+        Allocation result{};
+        result.locations.resize(m_Function.regCount);
+
+        // Free registers are taken from the back, so reverse the pool to hand them out in order.
+        std::vector<RegType> free_regs(m_Pool.rbegin(), m_Pool.rend());
+        std::vector<bool>    used(RegType::NUL + 1);
+
+        // Intervals currently holding a register, sorted by their end.
+        std::vector<const LiveInterval*> active{};
+        const auto                       insert_active = [&active](const LiveInterval* interval)
+        {
+            const auto by_end = [](const LiveInterval* lhs, const LiveInterval* rhs) { return lhs->end < rhs->end; };
+            active.insert(std::upper_bound(active.begin(), active.end(), interval, by_end), interval);
+        };
+
+        for (const auto& current : m_Intervals)
+        {
+            // Expire the intervals that ended before this one begins and give their registers back.
+            auto expired = std::find_if(active.begin(), active.end(), [&current](const LiveInterval* interval)
+                                        { return interval->end >= current.start; });
+            for (auto it = active.begin(); it != expired; ++it)
+                free_regs.push_back(result.locations[(*it)->reg].reg);
+            active.erase(active.begin(), expired);
+
+            if (!free_regs.empty())
+            {
+                auto reg = free_regs.back();
+                free_regs.pop_back();
+                used[reg]                         = true;
+                result.locations[current.reg].reg = reg;
+                insert_active(&current);
+                continue;
+            }
+
+            // Out of registers, spill whichever interval lives the longest, either the current one or the one that
+            // ends last among the active ones.
+            const auto* victim = (active.empty()) ? nullptr : active.back();
+            if (victim && victim->end > current.end)
+            {
+                result.locations[current.reg].reg = result.locations[victim->reg].reg;
+                result.locations[victim->reg]     = Location{ .slot = (i32)result.slotCount++ };
+                active.pop_back();
+                insert_active(&current);
+            }
+            else
+            {
+                result.locations[current.reg] = Location{ .slot = (i32)result.slotCount++ };
+            }
+        }
+
+        for (const auto reg : m_Pool)
+        {
+            if (used[reg])
+                result.usedRegisters.push_back(reg);
+        }
+        return result;
+    }
+
+    void RegisterAllocator::ComputeIntervals()
+    {
+        const auto& blocks   = m_Function.blocks;
+        const auto  liveness = ir::ComputeLiveness(m_Function);
+        const usize words    = liveness.words;
+
+        m_Intervals.assign(m_Function.regCount, LiveInterval{});
+        for (ir::VReg r = 0; r < m_Function.regCount; ++r)
+            m_Intervals[r].reg = r;
+
+        const auto extend = [this](const ir::VReg reg, const u32 pos)
+        {
+            auto& interval = m_Intervals[reg];
+            interval.start = std::min(interval.start, pos);
+            interval.end   = std::max(interval.end, pos);
+        };
+
+        // Number the instructions in emission order.
+        u32 position = 0;
+        for (const auto b : m_Function.layout)
+        {
+            const u32 first = position;
+            for (const auto& inst : blocks[b].code)
+            {
+                if (inst.a != ir::NoReg)
+                    extend(inst.a, position * 2);
+                if (inst.b != ir::NoReg)
+                    extend(inst.b, position * 2);
+                if (inst.dst != ir::NoReg)
+                    extend(inst.dst, position * 2 + 1);
+                ++position;
+            }
+            const u32 last = (position == first) ? first : position - 1;
+
+            // Whatever is live across the block boundaries covers the whole block.
+            const auto live_in  = liveness.GetLiveIn(b);
+            const auto live_out = liveness.GetLiveOut(b);
+            for (usize w = 0; w < words; ++w)
+            {
+                for (u64 bits = live_in[w]; bits != 0; bits &= bits - 1)
+                    extend((ir::VReg)(w * 64 + std::countr_zero(bits)), first * 2);
+                for (u64 bits = live_out[w]; bits != 0; bits &= bits - 1)
+                    extend((ir::VReg)(w * 64 + std::countr_zero(bits)), last * 2 + 1);
+            }
+        }
+
+        // Drop the registers that were never referenced.
+        std::erase_if(m_Intervals, [](const LiveInterval& interval) { return interval.start == ~u32{}; });
+    }
+} // namespace relang::refront::codegen
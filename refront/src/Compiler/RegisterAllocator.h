@@ -0,0 +1,58 @@
+#ifndef CMC_COMPILER_REGISTER_ALLOCATOR_H
+#define CMC_COMPILER_REGISTER_ALLOCATOR_H
+
+#include <Blend.h>
+#include <span>
+#include <vector>
+
+#include "IR.h"
+
+namespace relang::refront::codegen {
+    // Where a virtual register lives, either a machine register or, once spilled, a stack slot below the frame
+    // pointer.
+    struct Location
+    {
+        blend::RegType reg  = blend::RegType::NUL;
+        i32            slot = -1;
+
+    public:
+        inline bool IsSpilled() const noexcept { return reg == blend::RegType::NUL; }
+    };
+
+    struct Allocation
+    {
+        std::vector<Location>       locations{};     // Indexed by virtual register.
+        std::vector<blend::RegType> usedRegisters{}; // Every machine register handed out, in pool order.
+        u32                         slotCount{};
+    };
+
+    // A virtual register's lifetime over the linearized function. Positions are two per instruction, uses read at
+    // the even one and the definition writes at the odd one so an operand's register can be reused for the result.
+    struct LiveInterval
+    {
+        ir::VReg reg{};
+        u32      start = ~u32{};
+        u32      end{};
+    };
+
+    // Linear scan register allocation (Poletto & Sarkar), lifetime holes are ignored so an interval covers
+    // everything between its first and last live position, loops included.
+    class RegisterAllocator
+    {
+    private:
+        const ir::Function&             m_Function;
+        std::span<const blend::RegType> m_Pool;
+        std::vector<LiveInterval>       m_Intervals{};
+
+    public:
+        RegisterAllocator(const ir::Function& fn, std::span<const blend::RegType> pool);
+
+    public:
+        Allocation Allocate();
+
+    private:
+        void ComputeIntervals();
+    };
+} // namespace relang::refront::codegen
+
+#endif // CMC_COMPILER_REGISTER_ALLOCATOR_H
@@ -0,0 +1,419 @@
+#include "SSA.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+
+namespace relang::refront::ir {
+    namespace {
+        // Orders the copies of one edge so none overwrites a register another still has to read, breaking cycles
+        // through a fresh register.
+        std::vector<Instruction> SequentializeCopies(Function& fn, std::vector<std::pair<VReg, VReg>> pending)
+        {
+            std::erase_if(pending, [](const auto& copy) { return copy.first == copy.second; });
+
+            std::vector<Instruction> result{};
+            while (!pending.empty())
+            {
+                const auto ready = std::find_if(pending.begin(), pending.end(),
+                                                [&pending](const auto& copy)
+                                                {
+                                                    return std::none_of(pending.begin(), pending.end(),
+                                                                        [&copy](const auto& other)
+                                                                        { return other.second == copy.first; });
+                                                });
+                if (ready != pending.end())
+                {
+                    result.push_back(Instruction{ .op = OpCode::Copy, .dst = ready->first, .a = ready->second });
+                    pending.erase(ready);
+                    continue;
+                }
+
+                // Every destination is still read by another copy, so they form cycles. Save one destination aside
+                // and let its readers take it from there.
+                const auto saved = pending.front().first;
+                const auto temp  = fn.NewReg();
+                result.push_back(Instruction{ .op = OpCode::Copy, .dst = temp, .a = saved });
+                for (auto& copy : pending)
+                {
+                    if (copy.second == saved)
+                        copy.second = temp;
+                }
+            }
+            return result;
+        }
+
+        inline u64 MakePair(const VReg lhs, const VReg rhs) noexcept
+        {
+            return (u64)std::min(lhs, rhs) << 32 | std::max(lhs, rhs);
+        }
+
+        // Merges copy related registers that are never live at the same time (Chaitin's interference test), one
+        // round of disjoint pairs at a time, until no copy can be removed.
+        void CoalesceCopies(Function& fn)
+        {
+            while (true)
+            {
+                std::vector<std::vector<VReg>> partners(fn.regCount);
+                for (const auto b : fn.layout)
+                {
+                    for (const auto& inst : fn.blocks[b].code)
+                    {
+                        if (inst.op == OpCode::Copy && inst.dst != inst.a)
+                        {
+                            partners[inst.dst].push_back(inst.a);
+                            partners[inst.a].push_back(inst.dst);
+                        }
+                    }
+                }
+
+                // Walk each block backwards tracking what is live, a register interferes with a partner that is live
+                // where it gets defined, unless the definition is the copy from that partner itself.
+                const auto              liveness = ComputeLiveness(fn);
+                std::unordered_set<u64> interferes{};
+                std::vector<u64>        live(liveness.words);
+
+                const auto is_live = [&live](const VReg r) { return (live[r / 64] >> (r % 64)) & 1; };
+                for (const auto b : fn.layout)
+                {
+                    const auto live_out = liveness.GetLiveOut(b);
+                    std::copy(live_out.begin(), live_out.end(), live.begin());
+                    const auto& code = fn.blocks[b].code;
+                    for (auto it = code.rbegin(); it != code.rend(); ++it)
+                    {
+                        if (it->dst != NoReg)
+                        {
+                            for (const auto p : partners[it->dst])
+                            {
+                                if (is_live(p) && !(it->op == OpCode::Copy && it->a == p))
+                                    interferes.insert(MakePair(it->dst, p));
+                            }
+                            live[it->dst / 64] &= ~(u64{ 1 } << (it->dst % 64));
+                        }
+                        for (const auto operand : { it->a, it->b })
+                        {
+                            if (operand != NoReg)
+                                live[operand / 64] |= u64{ 1 } << (operand % 64);
+                        }
+                    }
+                }
+
+                std::vector<VReg> rename(fn.regCount);
+                std::vector<bool> touched(fn.regCount);
+                for (VReg r = 0; r < fn.regCount; ++r)
+                    rename[r] = r;
+
+                bool merged = false;
+                for (const auto b : fn.layout)
+                {
+                    for (const auto& inst : fn.blocks[b].code)
+                    {
+                        if (inst.op != OpCode::Copy || inst.dst == inst.a || touched[inst.dst] || touched[inst.a] ||
+                            interferes.contains(MakePair(inst.dst, inst.a)))
+                            continue;
+                        rename[inst.a]    = inst.dst;
+                        touched[inst.a]   = true;
+                        touched[inst.dst] = true;
+                        merged            = true;
+                    }
+                }
+                if (!merged)
+                    return;
+
+                for (const auto b : fn.layout)
+                {
+                    auto& code = fn.blocks[b].code;
+                    for (auto& inst : code)
+                    {
+                        for (auto* reg : { &inst.dst, &inst.a, &inst.b })
+                        {
+                            if (*reg != NoReg)
+                                *reg = rename[*reg];
+                        }
+                    }
+                    std::erase_if(code, [](const Instruction& inst)
+                                  { return inst.op == OpCode::Copy && inst.dst == inst.a; });
+                }
+            }
+        }
+    } // namespace
+
+    DominatorTree::DominatorTree(const Function& fn, const std::vector<std::vector<BlockIndex>>& preds)
+        : m_Idom(fn.blocks.size(), NoBlock), m_Order(fn.blocks.size()), m_Children(fn.blocks.size())
+    {
+        const auto rpo = fn.GetReversePostOrder();
+        for (u32 i = 0; i < rpo.size(); ++i)
+            m_Order[rpo[i]] = i;
+
+        const auto intersect = [this](BlockIndex lhs, BlockIndex rhs)
+        {
+            while (lhs != rhs)
+            {
+                while (m_Order[lhs] > m_Order[rhs])
+                    lhs = m_Idom[lhs];
+                while (m_Order[rhs] > m_Order[lhs])
+                    rhs = m_Idom[rhs];
+            }
+            return lhs;
+        };
+
+        m_Idom[0]    = 0;
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (usize i = 1; i < rpo.size(); ++i)
+            {
+                const auto block    = rpo[i];
+                auto       new_idom = NoBlock;
+                for (const auto pred : preds[block])
+                {
+                    if (m_Idom[pred] == NoBlock)
+                        continue;
+                    new_idom = (new_idom == NoBlock) ? pred : intersect(pred, new_idom);
+                }
+                if (m_Idom[block] != new_idom)
+                {
+                    m_Idom[block] = new_idom;
+                    changed       = true;
+                }
+            }
+        }
+
+        for (usize i = 1; i < rpo.size(); ++i)
+            m_Children[m_Idom[rpo[i]]].push_back(rpo[i]);
+    }
+
+    bool DominatorTree::Dominates(const BlockIndex dom, BlockIndex block) const noexcept
+    {
+        if (!IsReachable(block) || !IsReachable(dom))
+            return false;
+        while (m_Order[block] > m_Order[dom])
+            block = m_Idom[block];
+        return block == dom;
+    }
+
+    void RemoveUnreachableBlocks(Function& fn)
+    {
+        std::vector<bool> reachable(fn.blocks.size());
+        for (const auto b : fn.GetReversePostOrder())
+            reachable[b] = true;
+
+        const auto layout = fn.layout;
+        for (const auto b : layout)
+        {
+            if (!reachable[b])
+                fn.RemoveBlock(b);
+        }
+    }
+
+    void BuildSSA(Function& fn)
+    {
+        RemoveUnreachableBlocks(fn);
+
+        const auto preds = fn.GetPredecessors();
+        const auto dom   = DominatorTree{ fn, preds };
+
+        std::vector<std::vector<BlockIndex>> frontier(fn.blocks.size());
+        for (const auto b : fn.layout)
+        {
+            if (preds[b].size() < 2)
+                continue;
+            for (const auto pred : preds[b])
+            {
+                for (auto runner = pred; runner != dom.GetIdom(b); runner = dom.GetIdom(runner))
+                {
+                    if (std::find(frontier[runner].begin(), frontier[runner].end(), b) == frontier[runner].end())
+                        frontier[runner].push_back(b);
+                }
+            }
+        }
+
+        // Registers written once already are in SSA form, a single definition dominates all of its uses.
+        const u32                            reg_count = fn.regCount;
+        std::vector<u32>                     def_count(reg_count);
+        std::vector<std::vector<BlockIndex>> def_blocks(reg_count);
+        for (const auto b : fn.layout)
+        {
+            for (const auto& inst : fn.blocks[b].code)
+            {
+                if (inst.dst == NoReg)
+                    continue;
+                ++def_count[inst.dst];
+                if (def_blocks[inst.dst].empty() || def_blocks[inst.dst].back() != b)
+                    def_blocks[inst.dst].push_back(b);
+            }
+        }
+
+        // Pruned SSA, a phi only goes where the variable is live, which liveness computed before any phi exists
+        // tells directly.
+        const auto        liveness = ComputeLiveness(fn);
+        std::vector<VReg> phi_var{};
+        std::vector<u32>  has_phi(fn.blocks.size(), NoReg);
+        for (VReg var = 0; var < reg_count; ++var)
+        {
+            if (def_count[var] < 2)
+                continue;
+
+            auto worklist = def_blocks[var];
+            while (!worklist.empty())
+            {
+                const auto b = worklist.back();
+                worklist.pop_back();
+                for (const auto f : frontier[b])
+                {
+                    if (has_phi[f] == var || !liveness.IsLiveIn(f, var))
+                        continue;
+                    has_phi[f] = var;
+                    auto& code = fn.blocks[f].code;
+                    code.insert(code.begin(), Instruction{ .op = OpCode::Phi, .dst = var, .imm = (i64)fn.phis.size() });
+                    fn.phis.emplace_back();
+                    phi_var.push_back(var);
+                    worklist.push_back(f);
+                }
+            }
+        }
+
+        // Rename along the dominator tree, each variable keeps a stack of the names reaching the current block.
+        std::vector<std::vector<VReg>> names(reg_count);
+        std::vector<VReg>              pushed{};
+        auto                           undefined = NoReg;
+
+        const auto current = [&](const VReg var)
+        {
+            if (!names[var].empty())
+                return names[var].back();
+
+            // Read before any write on some path, the old code read whatever the register held, give it a zero.
+            if (undefined == NoReg)
+            {
+                undefined   = fn.NewReg();
+                auto& entry = fn.blocks[0].code;
+                entry.insert(entry.begin(), Instruction{ .op = OpCode::Const, .dst = undefined });
+            }
+            return undefined;
+        };
+
+        std::vector<std::pair<BlockIndex, usize>> stack{ { 0, 0 } };
+        std::vector<usize>                        marks{ 0 };
+        while (!stack.empty())
+        {
+            auto& [block, next] = stack.back();
+            if (next == 0)
+            {
+                for (auto& inst : fn.blocks[block].code)
+                {
+                    if (inst.op != OpCode::Phi)
+                    {
+                        for (auto* operand : { &inst.a, &inst.b })
+                        {
+                            if (*operand != NoReg && *operand < reg_count && def_count[*operand] > 1)
+                                *operand = current(*operand);
+                        }
+                    }
+                    if (inst.dst != NoReg && inst.dst < reg_count && def_count[inst.dst] > 1)
+                    {
+                        const auto var = inst.dst;
+                        inst.dst       = fn.NewReg();
+                        names[var].push_back(inst.dst);
+                        pushed.push_back(var);
+                    }
+                }
+
+                BlockIndex succ[2]{};
+                const auto succ_count = fn.GetSuccessors(block, succ);
+                for (usize s = 0; s < succ_count; ++s)
+                {
+                    if (s == 1 && succ[1] == succ[0])
+                        break;
+                    for (const auto& inst : fn.blocks[succ[s]].code)
+                    {
+                        if (inst.op != OpCode::Phi)
+                            break;
+                        fn.phis[inst.imm].push_back(PhiOperand{ block, current(phi_var[inst.imm]) });
+                    }
+                }
+            }
+
+            const auto& children = dom.GetChildren(block);
+            if (next < children.size())
+            {
+                const auto child = children[next++];
+                stack.emplace_back(child, 0);
+                marks.push_back(pushed.size());
+                continue;
+            }
+
+            for (usize i = pushed.size(); i > marks.back(); --i)
+                names[pushed[i - 1]].pop_back();
+            pushed.resize(marks.back());
+            marks.pop_back();
+            stack.pop_back();
+        }
+    }
+
+    void DestructSSA(Function& fn)
+    {
+        const auto preds  = fn.GetPredecessors();
+        const auto layout = fn.layout;
+        for (const auto b : layout)
+        {
+            auto&      code      = fn.blocks[b].code;
+            const auto phi_count = (usize)(std::find_if(code.begin(), code.end(), [](const Instruction& inst)
+                                                        { return inst.op != OpCode::Phi; }) -
+                                           code.begin());
+            if (phi_count == 0)
+                continue;
+
+            for (const auto pred : preds[b])
+            {
+                std::vector<std::pair<VReg, VReg>> copies{};
+                for (usize i = 0; i < phi_count; ++i)
+                {
+                    const auto& inst     = fn.blocks[b].code[i];
+                    const auto& operands = fn.phis[inst.imm];
+                    const auto  incoming = std::find_if(operands.begin(), operands.end(),
+                                                        [pred](const PhiOperand& op) { return op.block == pred; });
+                    if (incoming != operands.end())
+                        copies.emplace_back(inst.dst, incoming->reg);
+                }
+
+                auto sequence = SequentializeCopies(fn, std::move(copies));
+                if (sequence.empty())
+                    continue;
+
+                // A critical edge, the predecessor branches elsewhere too, so the copies get a block of their own.
+                auto       at = pred;
+                BlockIndex succ[2]{};
+                if (fn.GetSuccessors(pred, succ) == 2 && succ[0] != succ[1])
+                {
+                    at = fn.NewBlockBefore(b);
+                    fn.ReplaceSuccessor(pred, b, at);
+                    fn.blocks[at].code.push_back(Instruction{ .op = OpCode::Jump, .target = b });
+                }
+
+                auto& at_code = fn.blocks[at].code;
+                at_code.insert(at_code.end() - 1, sequence.begin(), sequence.end());
+            }
+
+            auto& phi_code = fn.blocks[b].code;
+            phi_code.erase(phi_code.begin(), phi_code.begin() + (std::ptrdiff_t)phi_count);
+        }
+        fn.phis.clear();
+
+        CoalesceCopies(fn);
+
+        // Edges whose copies all coalesced away leave blocks that only jump, route their predecessors past them so
+        // they stop breaking up fall through.
+        for (const auto b : std::vector<BlockIndex>{ fn.layout })
+        {
+            const auto& code = fn.blocks[b].code;
+            if (b == 0 || code.size() != 1 || code[0].op != OpCode::Jump || code[0].target == b)
+                continue;
+            const auto target = code[0].target;
+            for (const auto pred : fn.layout)
+                fn.ReplaceSuccessor(pred, b, target);
+            fn.RemoveBlock(b);
+        }
+    }
+} // namespace relang::refront::ir
@@ -0,0 +1,46 @@
+#ifndef CMC_COMPILER_SSA_H
+#define CMC_COMPILER_SSA_H
+
+#include <vector>
+
+#include "IR.h"
+
+namespace relang::refront::ir {
+    constexpr BlockIndex NoBlock = ~BlockIndex{};
+
+    // Immediate dominators of the reachable blocks, computed with Cooper, Harvey and Kennedy's iterative algorithm.
+    class DominatorTree
+    {
+    private:
+        std::vector<BlockIndex>              m_Idom{};
+        std::vector<u32>                     m_Order{}; // Reverse post order number of each block.
+        std::vector<std::vector<BlockIndex>> m_Children{};
+
+    public:
+        DominatorTree(const Function& fn, const std::vector<std::vector<BlockIndex>>& preds);
+
+    public:
+        inline BlockIndex GetIdom(const BlockIndex block) const noexcept { return m_Idom[block]; }
+        inline bool       IsReachable(const BlockIndex block) const noexcept { return m_Idom[block] != NoBlock; }
+        inline const std::vector<BlockIndex>& GetChildren(const BlockIndex block) const noexcept
+        {
+            return m_Children[block];
+        }
+
+    public:
+        bool Dominates(const BlockIndex dom, BlockIndex block) const noexcept;
+    };
+
+    // Drops the blocks control can no longer reach, along with the phi operands flowing out of them.
+    void RemoveUnreachableBlocks(Function& fn);
+
+    // Rewrites every register defined more than once into single assignment form, placing phis on the iterated
+    // dominance frontier of the definitions wherever the register is live.
+    void BuildSSA(Function& fn);
+
+    // Replaces the phis with copies on the incoming edges, splitting the critical ones, then coalesces the copies
+    // whose registers do not interfere.
+    void DestructSSA(Function& fn);
+} // namespace relang::refront::ir
+
+#endif // CMC_COMPILER_SSA_H
@@ -0,0 +1,62 @@
+#include "Cache.h"
+
+#include <fmt/core.h>
+#include <random>
+
+#include "../Compiler/ObjectFile.h"
+
+namespace relang::refront {
+    u64 HashBytes(const std::string_view bytes, u64 hash) noexcept
+    {
+        for (const unsigned char c : bytes)
+        {
+            hash ^= c;
+            hash *= 0x100000001B3;
+        }
+        return hash;
+    }
+
+    ModuleCache::ModuleCache(std::filesystem::path directory) : m_Directory(std::move(directory))
+    {
+        // A directory that cannot be created just turns every lookup into a miss.
+        std::error_code error{};
+        std::filesystem::create_directories(m_Directory, error);
+    }
+
+    bool ModuleCache::Load(const u64 key, codegen::CompiledCode& code, std::string& interface)
+    {
+        // Whatever a failed read left behind gets thrown away, the module is compiled from scratch instead.
+        if (codegen::ObjectFile::Read(GetPath(key).string(), code, interface))
+        {
+            ++m_Hits;
+            return true;
+        }
+
+        code      = codegen::CompiledCode{};
+        interface = std::string{};
+        ++m_Misses;
+        return false;
+    }
+
+    void ModuleCache::Store(const u64 key, const codegen::CompiledCode& code, const std::string& interface) const
+    {
+        const auto path = GetPath(key);
+        auto       temp = path;
+        temp += fmt::format(".{:016x}", std::random_device{}() * 0x9E3779B97F4A7C15);
+
+        std::error_code error{};
+        if (!codegen::ObjectFile::Write(temp.string(), code, interface))
+        {
+            std::filesystem::remove(temp, error);
+            return;
+        }
+        std::filesystem::rename(temp, path, error);
+        if (error)
+            std::filesystem::remove(temp, error);
+    }
+
+    std::filesystem::path ModuleCache::GetPath(const u64 key) const
+    {
+        return m_Directory / fmt::format("{:016x}.rfo", key);
+    }
+} // namespace relang::refront
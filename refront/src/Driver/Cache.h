@@ -0,0 +1,47 @@
+#ifndef CMC_DRIVER_CACHE_H
+#define CMC_DRIVER_CACHE_H
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+
+#include "../Compiler/Compiler.h"
+
+namespace relang::refront {
+    constexpr u64 HashSeed = 0xCBF29CE484222325;
+
+    // FNV-1a, unlike std::hash it stays the same between builds so it can name files on disk.
+    u64 HashBytes(std::string_view bytes, u64 hash = HashSeed) noexcept;
+
+    template <typename T>
+    u64 HashValue(const T& value, const u64 hash = HashSeed) noexcept
+    {
+        return HashBytes(std::string_view{ (const char*)&value, sizeof(T) }, hash);
+    }
+
+    // Compiled modules kept on disk between runs as object files named after their key. Entries are written to a
+    // temporary file and renamed into place, so concurrent builds sharing the directory never see half an entry.
+    class ModuleCache
+    {
+    private:
+        std::filesystem::path m_Directory{};
+        std::atomic<usize>    m_Hits{};
+        std::atomic<usize>    m_Misses{};
+
+    public:
+        explicit ModuleCache(std::filesystem::path directory);
+
+    public:
+        inline usize GetHits() const noexcept { return m_Hits; }
+        inline usize GetMisses() const noexcept { return m_Misses; }
+
+    public:
+        bool Load(u64 key, codegen::CompiledCode& code, std::string& interface);
+        void Store(u64 key, const codegen::CompiledCode& code, const std::string& interface) const;
+
+    private:
+        std::filesystem::path GetPath(u64 key) const;
+    };
+} // namespace relang::refront
+
+#endif // CMC_DRIVER_CACHE_H
@@ -0,0 +1,307 @@
+#include "Driver.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "../Compiler/Linker.h"
+
+namespace relang::refront {
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        // Bump whenever the generated code or the object file layout changes, stale entries then stop matching.
+        constexpr u64 CacheVersion = 3;
+
+        double MillisecondsSince(const Clock::time_point begin) noexcept
+        {
+            return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+        }
+
+        std::string_view GetTypeKeyword(const ast::Type& type) noexcept
+        {
+            switch (type.ftype)
+            {
+                using enum ast::FundamentalType;
+
+                case Integer32: return "i32";
+                case Integer64: return "i64";
+                case Boolean: return "bool";
+                case Character: return "char";
+                case String: return "string";
+                default: return type.name;
+            }
+        }
+
+        std::string RenderInterface(const ast::SyntaxTree& tree)
+        {
+            std::string interface{};
+            for (const auto& s : tree.GetGlobals())
+            {
+                // Declarations without a body were imported, they belong to another module's interface.
+                if (s.kind != ast::StatementKind::FunctionDeclaration || s.children.count == 1)
+                    continue;
+
+                interface += fmt::format("fn {}(", s.name);
+                for (usize i = 0; const auto& param : tree.GetChildren(tree.GetChildren(s)[0]))
+                    interface += fmt::format("{}{}: {}", (i++ == 0) ? "" : ", ", param.name,
+                                             GetTypeKeyword(tree.GetType(param)));
+                interface += ')';
+                if (!tree.GetType(s).IsVoid())
+                    interface += fmt::format(" -> {}", GetTypeKeyword(tree.GetType(s)));
+                interface += " {}\n";
+            }
+            return interface;
+        }
+    } // namespace
+
+    Driver::Driver(const ir::OptimizationLevel level, const usize jobs,
+                   const std::optional<std::filesystem::path>& cacheDir)
+        : m_Level(level), m_Jobs(std::max(jobs, 1ul))
+    {
+        if (cacheDir)
+            m_Cache.emplace(*cacheDir);
+    }
+
+    std::optional<codegen::CompiledCode> Driver::Build(const std::filesystem::path& root)
+    {
+        const auto begin = Clock::now();
+        if (!Discover(root))
+            return std::nullopt;
+        if (const auto module = FindCycle(); module)
+        {
+            std::cerr << "cmc: '" << m_Modules[*module].path.string() << "' is caught in an import cycle." << std::endl;
+            return std::nullopt;
+        }
+
+        Schedule();
+
+        std::vector<const codegen::CompiledCode*> code{};
+        std::vector<std::string>                  names{};
+        for (const auto& module : m_Modules)
+        {
+            code.push_back(&module.code);
+            names.push_back(module.path.string());
+        }
+        auto program = codegen::Linker::Link(code, names);
+        m_WallTime   = MillisecondsSince(begin);
+        return program;
+    }
+
+    void Driver::PrintTimings(std::ostream& stream) const
+    {
+        stream << fmt::format("{:<40}{:>12}{:>12}{:>10}{:>8}\n", "Module", "Parse", "Codegen", "Workers", "Cache");
+        for (const auto& module : m_Modules)
+        {
+            const auto& t     = module.timings;
+            const auto  cache = (!m_Cache) ? "-" : (t.cached) ? "hit" : "miss";
+            stream << fmt::format("{:<40}{:>10.3f}ms{:>10.3f}ms{:>6}/{:<3}{:>8}\n", module.path.string(), t.parse,
+                                  t.codegen, t.parseWorker, t.codegenWorker, cache);
+        }
+        stream << fmt::format("Built {} module(s) in {:.3f}ms on {} worker(s).\n", m_Modules.size(), m_WallTime,
+                              std::min(m_Jobs, m_Modules.size()));
+        if (m_Cache)
+            stream << fmt::format("Cache: {} hit(s), {} miss(es).\n", m_Cache->GetHits(), m_Cache->GetMisses());
+    }
+
+    bool Driver::Discover(const std::filesystem::path& root)
+    {
+        std::unordered_map<std::string, usize> indices{};
+        const auto load = [&](const std::filesystem::path& path) -> std::optional<usize>
+        {
+            // The same file may be reached through different relative paths.
+            auto key = std::filesystem::weakly_canonical(path).string();
+            if (const auto it = indices.find(key); it != indices.end())
+                return it->second;
+
+            std::ifstream fs(path, std::ios::binary);
+            if (!fs.is_open())
+                return std::nullopt;
+
+            auto& module  = m_Modules.emplace_back();
+            module.path   = path;
+            module.source = std::string((std::istreambuf_iterator<char>(fs)), (std::istreambuf_iterator<char>()));
+            indices.emplace(std::move(key), m_Modules.size() - 1);
+            return m_Modules.size() - 1;
+        };
+
+        if (!load(root))
+        {
+            std::cerr << "cmc: input file non-existent." << std::endl;
+            return false;
+        }
+
+        // Breadth first from the root, which is also the link order.
+        for (usize i = 0; i < m_Modules.size(); ++i)
+        {
+            auto& module = m_Modules[i];
+            for (const auto import : Parser::ScanImports(module.source))
+            {
+                const auto index = load(module.path.parent_path() / import);
+                if (!index)
+                {
+                    std::cerr << "cmc: " << module.path.string() << ": cannot open the imported module '" << import
+                              << "'." << std::endl;
+                    return false;
+                }
+                if (std::find(module.imports.begin(), module.imports.end(), *index) != module.imports.end())
+                    continue;
+
+                module.imports.push_back(*index);
+                m_Modules[*index].importers.push_back(i);
+            }
+        }
+        return true;
+    }
+
+    std::optional<usize> Driver::FindCycle() const
+    {
+        // Peel off modules whose imports are all accounted for, whatever is left is stuck behind a cycle.
+        std::vector<usize> pending(m_Modules.size());
+        std::vector<usize> ready{};
+        for (usize i = 0; i < m_Modules.size(); ++i)
+        {
+            pending[i] = m_Modules[i].imports.size();
+            if (pending[i] == 0)
+                ready.push_back(i);
+        }
+
+        while (!ready.empty())
+        {
+            const auto module = ready.back();
+            ready.pop_back();
+            for (const auto importer : m_Modules[module].importers)
+            {
+                if (--pending[importer] == 0)
+                    ready.push_back(importer);
+            }
+        }
+
+        for (usize i = 0; i < m_Modules.size(); ++i)
+        {
+            if (pending[i] != 0)
+                return i;
+        }
+        return std::nullopt;
+    }
+
+    void Driver::Schedule()
+    {
+        enum class Stage : u8
+        {
+            Parse,
+            Generate
+        };
+
+        struct Task
+        {
+            usize module{};
+            Stage stage{};
+        };
+
+        std::mutex              mutex{};
+        std::condition_variable wake{};
+        std::deque<Task>        queue{};
+        std::vector<usize>      pending(m_Modules.size()); // Imports of each module still being parsed.
+        usize                   remaining = m_Modules.size() * 2;
+        for (usize i = 0; i < m_Modules.size(); ++i)
+        {
+            pending[i] = m_Modules[i].imports.size();
+            if (pending[i] == 0)
+                queue.push_back(Task{ .module = i, .stage = Stage::Parse });
+        }
+
+        const auto work = [&](const usize worker)
+        {
+            std::unique_lock lock(mutex);
+            while (true)
+            {
+                wake.wait(lock, [&] { return !queue.empty() || remaining == 0; });
+                if (remaining == 0)
+                    return;
+
+                const auto task = queue.front();
+                queue.pop_front();
+                lock.unlock();
+
+                auto& module = m_Modules[task.module];
+                if (task.stage == Stage::Parse)
+                {
+                    module.timings.parseWorker = worker;
+                    ParseModule(module);
+                }
+                else
+                {
+                    module.timings.codegenWorker = worker;
+                    GenerateModule(module);
+                }
+
+                lock.lock();
+                --remaining;
+                if (task.stage == Stage::Parse)
+                {
+                    // A parse unblocks the modules importing this one while code generation only finishes it, so
+                    // parses jump the queue.
+                    for (const auto importer : module.importers)
+                    {
+                        if (--pending[importer] == 0)
+                            queue.push_front(Task{ .module = importer, .stage = Stage::Parse });
+                    }
+                    if (module.timings.cached)
+                        --remaining;
+                    else
+                        queue.push_back(Task{ .module = task.module, .stage = Stage::Generate });
+                }
+                wake.notify_all();
+            }
+        };
+
+        // The calling thread is worker 0, no point in more workers than there are modules.
+        std::vector<std::thread> workers{};
+        for (usize i = 1; i < std::min(m_Jobs, m_Modules.size()); ++i)
+            workers.emplace_back(work, i);
+        work(0);
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    void Driver::ParseModule(Module& module)
+    {
+        const auto begin = Clock::now();
+
+        // The code depends on what the imported modules declare, not on how they implement it.
+        module.key = HashBytes(module.source, HashValue(m_Level, HashValue(CacheVersion)));
+        for (const auto import : module.imports)
+            module.key = HashValue(m_Modules[import].interfaceHash, module.key);
+
+        if (m_Cache && m_Cache->Load(module.key, module.code, module.interface))
+        {
+            // Importers are parsed against the declarations, which the interface is the source of.
+            module.tree           = Parser(module.interface).Parse();
+            module.timings.cached = true;
+        }
+        else
+        {
+            auto parser = Parser(module.source);
+            for (const auto import : module.imports)
+                parser.Import(m_Modules[import].tree);
+            module.tree      = parser.Parse();
+            module.interface = RenderInterface(module.tree);
+        }
+        module.interfaceHash = HashBytes(module.interface);
+        module.timings.parse = MillisecondsSince(begin);
+    }
+
+    void Driver::GenerateModule(Module& module)
+    {
+        // Modules importing this one may be reading the tree in the meantime, which is fine as nobody writes to it.
+        const auto begin       = Clock::now();
+        module.code            = Compiler(module.tree, m_Level).Compile();
+        if (m_Cache)
+            m_Cache->Store(module.key, module.code, module.interface);
+        module.timings.codegen = MillisecondsSince(begin);
+    }
+} // namespace relang::refront
@@ -0,0 +1,75 @@
+#ifndef CMC_DRIVER_DRIVER_H
+#define CMC_DRIVER_DRIVER_H
+
+#include <deque>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../Analyzer/Parser.h"
+#include "../Compiler/Compiler.h"
+#include "Cache.h"
+
+namespace relang::refront {
+    // Where a module's compile time went, in milliseconds.
+    struct ModuleTimings
+    {
+        double parse{};         // Lexing and parsing, the lexer runs on demand from within the parser.
+        double codegen{};       // Lowering, optimization and emission.
+        usize  parseWorker{};   // The workers each stage ran on.
+        usize  codegenWorker{};
+        bool   cached = false; // Loaded from the cache, neither parsed nor generated.
+    };
+
+    // A source file of the program and everything produced from it. Names in the tree point into the source.
+    struct Module
+    {
+        std::filesystem::path path{};
+        std::string           source{};
+        std::vector<usize>    imports{};   // The modules this one imports.
+        std::vector<usize>    importers{}; // The modules importing this one.
+        std::string           interface{}; // The functions it defines, written out as declarations.
+        u64                   interfaceHash{};
+        u64                   key{}; // Covers everything the compiled code depends on.
+        ast::SyntaxTree       tree{};
+        codegen::CompiledCode code{};
+        ModuleTimings         timings{};
+    };
+
+    // Compiles a program starting from its root module. Every import is parsed on a worker once the modules it
+    // imports are, since the parser checks calls against their declarations, and its code is generated as soon as
+    // it is parsed. The modules are linked in the order they were found in, root first.
+    //
+    // With a cache a module whose source and imported interfaces are unchanged is loaded instead. Importers only
+    // see a module's interface, so changing a function body recompiles just the module it is in.
+    class Driver
+    {
+    private:
+        std::deque<Module>         m_Modules{}; // Stable addresses, the trees point into the sources.
+        ir::OptimizationLevel      m_Level;
+        usize                      m_Jobs;
+        std::optional<ModuleCache> m_Cache{};
+        double                     m_WallTime{};
+
+    public:
+        Driver(ir::OptimizationLevel level, usize jobs,
+               const std::optional<std::filesystem::path>& cacheDir = std::nullopt);
+
+    public:
+        inline const std::deque<Module>& GetModules() const noexcept { return m_Modules; }
+
+    public:
+        std::optional<codegen::CompiledCode> Build(const std::filesystem::path& root);
+        void                                 PrintTimings(std::ostream& stream) const;
+
+    private:
+        bool                 Discover(const std::filesystem::path& root);
+        std::optional<usize> FindCycle() const;
+        void                 Schedule();
+        void                 ParseModule(Module& module);
+        void                 GenerateModule(Module& module);
+    };
+} // namespace relang::refront
+
+#endif // CMC_DRIVER_DRIVER_H
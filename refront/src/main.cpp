@@ -5,9 +5,12 @@
 #include <CommonDef.h>
 
 #include "Analyzer/Parser.h"
+#include "Analyzer/TreeFile.h"
 #include "Compiler/Compiler.h"
+#include "Driver/Driver.h"
 
 #include <filesystem>
+#include <thread>
 
 using namespace relang;
 using namespace relang::refront;
@@ -121,10 +124,11 @@ void DumpIntermediate(const relang::blend::InstructionList& code, const std::opt
                     switch (inst.opcode)
                     {
                         case relang::blend::OpCode::PInt:
-                        case relang::blend::OpCode::Enter:
                         case relang::blend::OpCode::SConio:
                         case relang::blend::OpCode::Push:
                         case relang::blend::OpCode::Call:
+                        case relang::blend::OpCode::TailCall:
+                        case relang::blend::OpCode::Jump:
                         case relang::blend::OpCode::Jz:
                         case relang::blend::OpCode::Jnz:
                         case relang::blend::OpCode::Js:
@@ -144,6 +148,7 @@ void DumpIntermediate(const relang::blend::InstructionList& code, const std::opt
                     }
                 }
             }
+            relang::blend::PrintMaskOperands(fs, inst);
             fs << "\n";
         }
     }
@@ -246,10 +251,11 @@ void DumpIntermediate(const relang::blend::InstructionList& code, const std::opt
                     {
                         case relang::blend::OpCode::PInt:
                         case relang::blend::OpCode::PChr:
-                        case relang::blend::OpCode::Enter:
                         case relang::blend::OpCode::SConio:
                         case relang::blend::OpCode::Push:
                         case relang::blend::OpCode::Call:
+                        case relang::blend::OpCode::TailCall:
+                        case relang::blend::OpCode::Jump:
                         case relang::blend::OpCode::Jz:
                         case relang::blend::OpCode::Jnz:
                         case relang::blend::OpCode::Js:
@@ -269,44 +275,139 @@ void DumpIntermediate(const relang::blend::InstructionList& code, const std::opt
                     }
                 }
             }
+            relang::blend::PrintMaskOperands(std::cout, inst);
             std::cout << "\n";
         }
     }
 }
 
+// Prints a syntax tree file as JSON, the format is meant for tools so this is how a person gets to look at one.
+int DumpTreeFile(const std::filesystem::path& path)
+{
+    std::ifstream fs(path, std::ios::binary);
+    if (!fs.is_open())
+    {
+        std::cerr << "cmc: input file non-existent." << std::endl;
+        return -1;
+    }
+
+    // Keep the bytes 8 byte aligned so the reader can use them in place.
+    std::vector<u64> bytes((std::filesystem::file_size(path) + 7) / sizeof(u64));
+    fs.read((char*)bytes.data(), std::filesystem::file_size(path));
+    const auto reader = ast::TreeReader(std::span<const u8>{ (const u8*)bytes.data(), bytes.size() * sizeof(u64) });
+    const auto tree   = reader.Read();
+    if (!tree)
+    {
+        std::cerr << "cmc: '" << path.string() << "' is not a valid syntax tree file." << std::endl;
+        return -1;
+    }
+
+    // The reader only checks that names lie within the file, one that is not UTF-8 is caught when it is printed.
+    try
+    {
+        const nlohmann::ordered_json json = *tree;
+        std::cout << json.dump(4) << std::endl;
+    }
+    catch (const nlohmann::json::exception&)
+    {
+        std::cerr << "cmc: '" << path.string() << "' is not a valid syntax tree file." << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
 int main(int argc, const char* argv[])
 {
     if (argc > 1)
     {
         std::cout << std::filesystem::current_path().string() << std::endl;
 
-        std::ifstream fs(argv[1]);
-        if (fs.is_open())
+        // Everything after the input file is an option.
+        auto                       level = ir::OptimizationLevel::O0;
+        usize                      jobs  = std::thread::hardware_concurrency();
+        std::optional<std::string> output{};
+        std::optional<std::string> cache_dir{};
+        bool                       dump_ast = false;
+        bool                       emit_ast = false;
+        for (int i = 2; i < argc; ++i)
         {
-            auto src    = std::string((std::istreambuf_iterator<char>(fs)), (std::istreambuf_iterator<char>()));
-            auto parser = Parser(src);
-            auto tree   = parser.Parse();
-            nlohmann::ordered_json json = tree;
-            std::cout << std::setw(4) << json << std::endl;
-            auto compiler      = Compiler(tree);
-            auto compiled_code = compiler.Compile();
+            const auto arg = std::string_view{ argv[i] };
+            if (arg == "-O0")
+                level = ir::OptimizationLevel::O0;
+            else if (arg == "-O1")
+                level = ir::OptimizationLevel::O1;
+            else if (arg == "-O2")
+                level = ir::OptimizationLevel::O2;
+            else if (arg == "-o" && i + 1 < argc)
+                output = argv[++i];
+            else if (arg == "-j" && i + 1 < argc)
+                jobs = std::strtoull(argv[++i], nullptr, 10);
+            else if (arg == "--cache-dir" && i + 1 < argc)
+                cache_dir = argv[++i];
+            else if (arg == "--dump-ast")
+                dump_ast = true;
+            else if (arg == "--emit-ast")
+                emit_ast = true;
+            else
+            {
+                std::cerr << "cmc: unknown option '" << arg << "'." << std::endl;
+                return -1;
+            }
+        }
+
+        if (std::filesystem::path{ argv[1] }.extension() == ".rfa")
+            return DumpTreeFile(argv[1]);
 
-            std::cout << std::endl;
-            DumpIntermediate(compiled_code, std::nullopt);
-            std::cout << std::endl;
+        // The imports are found, parsed and compiled by the driver, the root module is the input file.
+        auto driver        = Driver(level, jobs, cache_dir);
+        auto compiled_code = driver.Build(argv[1]);
+        if (!compiled_code)
+            return -1;
 
-            auto vm = Blend(compiled_code.GetDataSection(), compiled_code.GetDataSection().size());
-            i64  result{};
-            vm.Run(compiled_code, result);
-            return result;
+        // Modules loaded from the cache only have their interface's tree.
+        for (const auto& module : driver.GetModules())
+        {
+            if (dump_ast)
+            {
+                nlohmann::ordered_json json = module.tree;
+                std::cout << std::setw(4) << json << std::endl;
+            }
+            if (emit_ast)
+            {
+                auto          path = module.path.string() + ".rfa";
+                std::ofstream fs(path, std::ios::binary);
+                if (!fs.is_open() || !ast::TreeWriter::Write(module.tree, fs))
+                {
+                    std::cerr << "cmc: failed to write the syntax tree to '" << path << "'." << std::endl;
+                    return -1;
+                }
+            }
         }
-        else
+
+        std::cout << std::endl;
+        DumpIntermediate(*compiled_code, std::nullopt);
+        std::cout << std::endl;
+        driver.PrintTimings(std::cout);
+
+        // Write a Blend executable, line table included, instead of running the code.
+        if (output)
         {
-            std::cerr << "cmc: input file non-existent." << std::endl;
-            return -1;
+            if (!compiled_code->WriteToBinary(*output))
+            {
+                std::cerr << "cmc: failed to write output file." << std::endl;
+                return -1;
+            }
+            return 0;
         }
+
+        auto vm = Blend(compiled_code->GetDataSection(), compiled_code->GetDataSection().size());
+        i64  result{};
+        vm.Run(*compiled_code, result);
+        return result;
     }
     else
-        std::cout << "Usage:\n\tcmc [file]" << std::endl;
+        std::cout << "Usage:\n\tcmc [file] [-O0|-O1|-O2] [-j jobs] [--cache-dir dir] [--dump-ast] [--emit-ast] "
+                     "[-o output]\n\tcmc [file.rfa]"
+                  << std::endl;
     return 0;
 }